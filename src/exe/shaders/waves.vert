@@ -3,7 +3,7 @@
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec4 inColor;
 layout (location = 2) in vec2 inTex;
-layout (location = 3) in vec3 inNormal;
+layout (location = 3) in vec2 inNormal; // Octahedral-encoded
 layout (location = 4) in uvec4 inJoints;
 layout (location = 5) in vec4 inWeights;
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <limits>
 #include <vgi/asset/gltf.hpp>
 #include <vgi/buffer/storage.hpp>
 #include <vgi/fs.hpp>
@@ -44,32 +46,40 @@ namespace skeleton {
             // always be true.
             this->skins.emplace_back(win, this->pipeline, skin, this->asset.textures.at(0).texture);
         }
+        this->rigid = skin::identity(win, this->pipeline, this->asset.textures.at(0).texture);
     }
 
     static void draw_mesh(const vgi::window& win, const vgi::graphics_pipeline& pipeline,
                           vk::CommandBuffer cmdbuf, uint32_t current_frame, vgi::gltf::asset& asset,
                           size_t mesh, std::optional<size_t> skin, glm::mat4 camera,
-                          vgi::math::transf3d transform, std::span<struct skin> skinning) {
+                          const glm::mat4& view, float projection_scale,
+                          vgi::math::transf3d transform, std::span<struct skin> skinning,
+                          const struct skin& rigid, std::span<uint32_t> lods) {
         glm::mat4 mvp = camera * transform;
         cmdbuf.pushConstants(pipeline, vk::ShaderStageFlagBits::eVertex, UINT32_C(0),
                              vk::ArrayProxy<const glm::mat4>{mvp});
 
-        if (skin.has_value()) {
-            const vk::DescriptorSet& set = skinning[*skin].descriptor[current_frame];
-            cmdbuf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline, 0, set, {});
-        }
-
-        for (const vgi::gltf::primitive& gltf_prim: asset.meshes.at(mesh).primitives) {
-            gltf_prim.bind_and_draw(cmdbuf);
+        // Meshes without a skin still go through the joints of the shader, so they use the
+        // identity ones instead of whichever set was bound last
+        const vk::DescriptorSet& set =
+                (skin.has_value() ? skinning[*skin] : rigid).descriptor[current_frame];
+        cmdbuf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline, 0, set, {});
+
+        // Every primitive is drawn with the coarsest level of detail that still looks the same,
+        // starting from the level it had on the previous frame
+        const glm::mat4 model_view = view * transform;
+        const std::vector<vgi::gltf::primitive>& primitives = asset.meshes.at(mesh).primitives;
+        for (size_t i = 0; i < primitives.size(); ++i) {
+            lods[i] = primitives[i].select_lod(model_view, projection_scale, lods[i]);
+            primitives[i].bind_and_draw(cmdbuf, 1, 0, vgi::vertex_streams::all, lods[i]);
         }
     }
 
-    static void process_node(const vgi::window& win, const vgi::graphics_pipeline& pipeline,
-                             vk::CommandBuffer cmdbuf, uint32_t current_frame,
-                             vgi::gltf::asset& asset, size_t node_index,
-                             vgi::math::transf3d parent_transf, glm::mat4 camera,
-                             std::span<skin> skinning, const vgi::gltf::animation* animation,
-                             const vgi::timings& ts) {
+    static void process_node(scene& scene, uint32_t current_frame, size_t node_index,
+                             vgi::math::transf3d parent_transf,
+                             const vgi::gltf::animation* animation, const vgi::timings& ts) {
+        vgi::gltf::asset& asset = scene.asset;
+        std::span<skin> skinning = scene.skins;
         const vgi::gltf::node& node = asset.nodes.at(node_index);
 
         glm::vec3 origin = node.local_origin;
@@ -99,22 +109,29 @@ namespace skeleton {
         vgi::math::transf3d local_transf{origin, rotation, scale};
         vgi::math::transf3d model_transf = parent_transf * local_transf;
 
-        // Update attached joints
+        // Update attached joints (flushed once all the nodes have been processed)
         for (const vgi::gltf::joint& joint: node.attachments) {
-            skinning[joint.skin].buffer.write(win, model_transf * joint.inv_bind, current_frame,
-                                              joint.index);
+            skinning[joint.skin].buffer.data(current_frame)[joint.index] =
+                    model_transf * joint.inv_bind;
         }
 
-        // If this node has a mesh, submit a draw command
-        if (node.mesh) {
-            draw_mesh(win, pipeline, cmdbuf, current_frame, asset, *node.mesh, node.skin, camera,
-                      model_transf, skinning);
+        // If this node has a mesh, queue it to be culled and drawn. Skinned meshes are deformed
+        // by their joints, so their rest pose bounds don't apply and they are never culled.
+        // Static meshes are already drawn by the scene's batches.
+        if (node.mesh && !node.batched) {
+            scene.draws.push_back(mesh_draw{
+                    .mesh = *node.mesh,
+                    .skin = node.skin,
+                    .transform = model_transf,
+            });
+            scene.bounds.push_back(
+                    node.skin ? vgi::math::sphere{.radius = (std::numeric_limits<float>::max)()}
+                              : asset.meshes[*node.mesh].bounding_sphere.transform(model_transf));
         }
 
         // Process children
         for (size_t child: node.children) {
-            process_node(win, pipeline, cmdbuf, current_frame, asset, child, model_transf, camera,
-                         skinning, animation, ts);
+            process_node(scene, current_frame, child, model_transf, animation, ts);
         }
     }
 
@@ -126,11 +143,49 @@ namespace skeleton {
 
     void scene::on_render(vgi::window& win, vk::CommandBuffer cmdbuf, uint32_t current_frame,
                           const vgi::timings& ts) {
-        this->pipeline.bind(cmdbuf);
+        this->draws.clear();
+        this->bounds.clear();
         for (size_t root: this->asset.scenes[0].roots) {
-            process_node(win, pipeline, cmdbuf, current_frame, this->asset, root, {},
-                         this->camera.projection(win.draw_size()) * this->camera.view(),
-                         this->skins, &this->asset.animations[0], ts);
+            process_node(*this, current_frame, root, {}, &this->asset.animations[0], ts);
+        }
+        for (const skin& skin: this->skins) skin.buffer.flush(win, current_frame);
+
+        // Nodes are always visited in the same order, so every primitive keeps its level of
+        // detail across frames
+        size_t lod_count = 0;
+        for (mesh_draw& draw: this->draws) {
+            draw.first_lod = lod_count;
+            lod_count += this->asset.meshes[draw.mesh].primitives.size();
+        }
+        this->lods.resize(lod_count);
+
+        // Only the meshes inside the camera's frustum are drawn
+        const vgi::math::frustum frustum = this->camera.view_frustum(win.draw_size());
+        this->visible.resize(this->bounds.size());
+        const size_t visible_count = frustum.cull(this->bounds, this->visible);
+
+        const glm::mat4 view = this->camera.view();
+        const glm::mat4 camera = this->camera.projection(win.draw_size()) * view;
+        const float projection_scale = this->camera.projection_scale(win.draw_size());
+        this->pipeline.bind(cmdbuf);
+        for (size_t i = 0; i < visible_count; ++i) {
+            const mesh_draw& draw = this->draws[this->visible[i]];
+            draw_mesh(win, this->pipeline, cmdbuf, current_frame, this->asset, draw.mesh,
+                      draw.skin, camera, view, projection_scale, draw.transform, this->skins,
+                      *this->rigid, std::span{this->lods}.subspan(
+                              draw.first_lod, this->asset.meshes[draw.mesh].primitives.size()));
+        }
+
+        // Static meshes are drawn with a single draw per material. Their vertices are already in
+        // the batch's space, so they must not be deformed by any joint.
+        cmdbuf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, this->pipeline, 0,
+                                  this->rigid->descriptor[current_frame], {});
+        for (const vgi::gltf::batch& batch: this->asset.scenes[0].batches) {
+            if (!frustum.intersects(batch.bounding_sphere)) continue;
+            const glm::mat4 mvp = camera * batch.transform;
+            cmdbuf.pushConstants(this->pipeline, vk::ShaderStageFlagBits::eVertex, UINT32_C(0),
+                                 vk::ArrayProxy<const glm::mat4>{mvp});
+            batch.bind_and_draw(cmdbuf);
         }
     }
 
@@ -138,14 +193,29 @@ namespace skeleton {
         win->waitIdle();
         std::move(this->pipeline).destroy(win);
         for (skin& skin: this->skins) std::move(skin).destroy(win);
+        if (this->rigid) std::move(*this->rigid).destroy(win);
+        this->rigid.reset();
         std::move(this->asset).destroy(win);
     }
 
     skin::skin(vgi::window& win, const vgi::graphics_pipeline& pipeline,
                const vgi::gltf::skin& info, const vgi::texture_sampler& tex) :
         descriptor(win, pipeline), buffer(win, info.joints) {
-        tex.update_descriptors(win, this->descriptor, 0);
-        this->buffer.update_descriptors(win, this->descriptor, 1);
+        vgi::descriptor_writer writer;
+        tex.update_descriptors(writer, this->descriptor, 0);
+        this->buffer.update_descriptors(writer, this->descriptor, 1);
+        writer.flush(win);
+    }
+
+    skin skin::identity(vgi::window& win, const vgi::graphics_pipeline& pipeline,
+                        const vgi::texture_sampler& tex) {
+        // Vertices may reference any joint that fits in their 8-bit indices
+        skin result{win, pipeline, vgi::gltf::skin{.joints = size_t{UINT8_MAX} + 1}, tex};
+        for (uint32_t i = 0; i < vgi::window::MAX_FRAMES_IN_FLIGHT; ++i) {
+            std::ranges::fill(result.buffer.data(i), glm::mat4{1.0f});
+            result.buffer.flush(win, i);
+        }
+        return result;
     }
 
     void skin::destroy(vgi::window& win) && {
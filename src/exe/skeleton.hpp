@@ -4,6 +4,7 @@
 #include <vgi/buffer/storage.hpp>
 #include <vgi/buffer/uniform.hpp>
 #include <vgi/buffer/vertex.hpp>
+#include <vgi/math/bounds.hpp>
 #include <vgi/math/camera.hpp>
 #include <vgi/pipeline.hpp>
 #include <vgi/pipeline/shader.hpp>
@@ -18,9 +19,19 @@ namespace skeleton {
 
         skin(vgi::window& win, const vgi::graphics_pipeline& pipeline, const vgi::gltf::skin& info,
              const vgi::texture_sampler& tex);
+        // Skin whose joints are all the identity, for meshes that aren't deformed
+        static skin identity(vgi::window& win, const vgi::graphics_pipeline& pipeline,
+                             const vgi::texture_sampler& tex);
         void destroy(vgi::window& win) &&;
     };
 
+    struct mesh_draw {
+        size_t mesh;
+        std::optional<size_t> skin;
+        vgi::math::transf3d transform;
+        size_t first_lod = 0;
+    };
+
     struct uniform {
         vgi::std140<glm::mat4> mvp;
         vgi::std140<uint32_t> has_skin;
@@ -31,6 +42,11 @@ namespace skeleton {
         vgi::graphics_pipeline pipeline;
         vgi::math::perspective_camera camera;
         std::vector<skin> skins;
+        std::optional<skin> rigid;
+        std::vector<mesh_draw> draws;
+        std::vector<vgi::math::sphere> bounds;
+        std::vector<uint32_t> visible;
+        std::vector<uint32_t> lods;
 
         void on_attach(vgi::window& win) override;
         void on_update(vgi::window& win, vk::CommandBuffer cmdbuf, uint32_t current_frame,
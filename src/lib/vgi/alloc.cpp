@@ -0,0 +1,284 @@
+#include "alloc.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <optional>
+
+#include "math.hpp"
+
+namespace vgi {
+    // Every allocation is preceded by a header, which also keeps pool allocations aligned
+    constexpr static inline const size_t HEADER_SIZE = 16;
+    constexpr static inline const size_t MIN_ALIGNMENT = 16;
+    // Pool blocks (header included) range from 32 bytes to 8 KiB, doubling on every class
+    constexpr static inline const uint32_t CLASS_COUNT = 9;
+    constexpr static inline const uint32_t LARGE_CLASS = UINT32_MAX;
+    // Pools grow a slab at a time, and never give memory back to the system
+    constexpr static inline const size_t SLAB_SIZE = 64 * 1024;
+    // Maximum number of blocks per class kept by a thread, before half of them are handed back
+    constexpr static inline const uint32_t CACHE_LIMIT = 64;
+
+    constexpr static size_t class_size(uint32_t size_class) noexcept {
+        return size_t{32} << size_class;
+    }
+
+    struct alloc_header {
+        uint32_t size_class;
+        // Distance from the start of the system allocation, for large allocations
+        uint32_t offset;
+        size_t size;
+    };
+    static_assert(sizeof(alloc_header) <= HEADER_SIZE);
+
+    struct free_block {
+        free_block* next;
+    };
+
+    struct central_pool {
+        std::mutex lock;
+        free_block* head = nullptr;
+    };
+
+    struct scope_counters {
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<uint64_t> reallocations{0};
+        std::atomic<size_t> live_bytes{0};
+        std::atomic<size_t> peak_bytes{0};
+    };
+
+    static scope_counters counters[ALLOC_SCOPE_COUNT];
+
+    // Pools are never destroyed, since blocks may be released by threads that outlive the
+    // static destructors (i.e. SDL's or the driver's).
+    static central_pool* central_pools() {
+        static central_pool* const pools = new central_pool[CLASS_COUNT];
+        return pools;
+    }
+
+    struct thread_cache {
+        free_block* heads[CLASS_COUNT] = {};
+        uint32_t counts[CLASS_COUNT] = {};
+
+        // Moves up to `count` cached blocks of a class back to its central pool
+        void release(uint32_t size_class, uint32_t count) noexcept {
+            if (count == 0 || this->heads[size_class] == nullptr) return;
+
+            free_block* first = this->heads[size_class];
+            free_block* last = first;
+            uint32_t moved = 1;
+            for (; moved < count && last->next != nullptr; ++moved) last = last->next;
+            this->heads[size_class] = last->next;
+            this->counts[size_class] -= moved;
+
+            central_pool& pool = central_pools()[size_class];
+            std::lock_guard<std::mutex> guard{pool.lock};
+            last->next = pool.head;
+            pool.head = first;
+        }
+
+        // Takes up to half a cache worth of blocks from the central pool, carving a new slab when
+        // it's empty
+        bool refill(uint32_t size_class) noexcept {
+            central_pool& pool = central_pools()[size_class];
+            {
+                std::lock_guard<std::mutex> guard{pool.lock};
+                for (uint32_t i = 0; i < CACHE_LIMIT / 2 && pool.head != nullptr; ++i) {
+                    free_block* block = pool.head;
+                    pool.head = block->next;
+                    block->next = this->heads[size_class];
+                    this->heads[size_class] = block;
+                    this->counts[size_class]++;
+                }
+            }
+            if (this->heads[size_class] != nullptr) return true;
+
+            std::byte* slab = static_cast<std::byte*>(::operator new(
+                    SLAB_SIZE, std::align_val_t{MIN_ALIGNMENT}, std::nothrow));
+            if (slab == nullptr) return false;
+
+            const size_t block_size = class_size(size_class);
+            for (size_t offset = 0; offset + block_size <= SLAB_SIZE; offset += block_size) {
+                free_block* block = reinterpret_cast<free_block*>(slab + offset);
+                block->next = this->heads[size_class];
+                this->heads[size_class] = block;
+                this->counts[size_class]++;
+            }
+            // Keep the cache within its limit
+            if (this->counts[size_class] > CACHE_LIMIT) {
+                this->release(size_class, this->counts[size_class] - CACHE_LIMIT);
+            }
+            return true;
+        }
+
+        ~thread_cache() {
+            for (uint32_t i = 0; i < CLASS_COUNT; ++i) this->release(i, this->counts[i]);
+        }
+    };
+
+    static thread_local thread_cache cache;
+
+    static alloc_header* header_of(void* ptr) noexcept {
+        return reinterpret_cast<alloc_header*>(static_cast<std::byte*>(ptr) - HEADER_SIZE);
+    }
+
+    static void count_alloc(alloc_scope scope, size_t size) noexcept {
+        scope_counters& c = counters[static_cast<size_t>(scope)];
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+        const size_t live = c.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = c.peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak &&
+               !c.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void count_free(alloc_scope scope, size_t size) noexcept {
+        scope_counters& c = counters[static_cast<size_t>(scope)];
+        c.frees.fetch_add(1, std::memory_order_relaxed);
+        c.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    void* host_alloc(alloc_scope scope, size_t size, size_t alignment) noexcept {
+        VGI_ASSERT(std::has_single_bit(alignment));
+        alignment = (std::max)(alignment, MIN_ALIGNMENT);
+
+        std::byte* result;
+        std::optional<size_t> total = math::check_add<size_t>(size, HEADER_SIZE);
+        if (total && alignment == MIN_ALIGNMENT && *total <= class_size(CLASS_COUNT - 1)) {
+            // Smallest class whose blocks fit the allocation
+            const uint32_t size_class =
+                    static_cast<uint32_t>(std::bit_width((std::max)(*total, class_size(0)) - 1) -
+                                          std::bit_width(class_size(0) - 1));
+            VGI_ASSERT(size_class < CLASS_COUNT && *total <= class_size(size_class));
+
+            if (cache.heads[size_class] == nullptr && !cache.refill(size_class)) return nullptr;
+            free_block* block = cache.heads[size_class];
+            cache.heads[size_class] = block->next;
+            cache.counts[size_class]--;
+
+            result = reinterpret_cast<std::byte*>(block) + HEADER_SIZE;
+            *header_of(result) = alloc_header{.size_class = size_class, .offset = 0, .size = size};
+        } else {
+            // Large (or over-aligned) allocations go straight to the system allocator, with room
+            // to align the user pointer after the header
+            if (total) total = math::check_add<size_t>(*total, alignment - MIN_ALIGNMENT);
+            if (!total || alignment > UINT32_MAX) return nullptr;
+
+            std::byte* raw = static_cast<std::byte*>(
+                    ::operator new(*total, std::align_val_t{MIN_ALIGNMENT}, std::nothrow));
+            if (raw == nullptr) return nullptr;
+
+            const uintptr_t address = reinterpret_cast<uintptr_t>(raw + HEADER_SIZE);
+            result = raw + HEADER_SIZE + ((alignment - address % alignment) % alignment);
+            *header_of(result) = alloc_header{
+                    .size_class = LARGE_CLASS,
+                    .offset = static_cast<uint32_t>(result - raw),
+                    .size = size,
+            };
+        }
+
+        count_alloc(scope, size);
+        return result;
+    }
+
+    void* host_realloc(alloc_scope scope, void* ptr, size_t size, size_t alignment) noexcept {
+        if (ptr == nullptr) return host_alloc(scope, size, alignment);
+        if (size == 0) {
+            host_free(scope, ptr);
+            return nullptr;
+        }
+
+        // Resize in place when the block is big enough, and properly aligned
+        alloc_header* header = header_of(ptr);
+        const size_t old_size = header->size;
+        if (header->size_class != LARGE_CLASS && alignment <= MIN_ALIGNMENT &&
+            size <= class_size(header->size_class) - HEADER_SIZE) {
+            header->size = size;
+            count_free(scope, old_size);
+            count_alloc(scope, size);
+            return ptr;
+        }
+
+        void* result = host_alloc(scope, size, alignment);
+        if (result == nullptr) return nullptr;
+        std::memcpy(result, ptr, (std::min)(old_size, size));
+        host_free(scope, ptr);
+        counters[static_cast<size_t>(scope)].reallocations.fetch_add(1, std::memory_order_relaxed);
+        return result;
+    }
+
+    void host_free(alloc_scope scope, void* ptr) noexcept {
+        if (ptr == nullptr) return;
+
+        alloc_header* header = header_of(ptr);
+        count_free(scope, header->size);
+        if (header->size_class == LARGE_CLASS) {
+            ::operator delete(static_cast<std::byte*>(ptr) - header->offset,
+                              std::align_val_t{MIN_ALIGNMENT});
+            return;
+        }
+
+        const uint32_t size_class = header->size_class;
+        free_block* block = reinterpret_cast<free_block*>(header);
+        block->next = cache.heads[size_class];
+        cache.heads[size_class] = block;
+        if (++cache.counts[size_class] > CACHE_LIMIT) cache.release(size_class, CACHE_LIMIT / 2);
+    }
+
+    alloc_stats host_alloc_stats(alloc_scope scope) noexcept {
+        const scope_counters& c = counters[static_cast<size_t>(scope)];
+        return alloc_stats{
+                .allocations = c.allocations.load(std::memory_order_relaxed),
+                .frees = c.frees.load(std::memory_order_relaxed),
+                .reallocations = c.reallocations.load(std::memory_order_relaxed),
+                .live_bytes = c.live_bytes.load(std::memory_order_relaxed),
+                .peak_bytes = c.peak_bytes.load(std::memory_order_relaxed),
+        };
+    }
+
+    // The scope of the callbacks is passed through their user data
+    static alloc_scope callback_scope(void* userdata) noexcept {
+        return static_cast<alloc_scope>(reinterpret_cast<uintptr_t>(userdata));
+    }
+
+    static VKAPI_ATTR void* VKAPI_CALL vulkan_alloc(void* userdata, size_t size, size_t alignment,
+                                                   VkSystemAllocationScope) {
+        return host_alloc(callback_scope(userdata), size, alignment);
+    }
+
+    static VKAPI_ATTR void* VKAPI_CALL vulkan_realloc(void* userdata, void* original, size_t size,
+                                                     size_t alignment, VkSystemAllocationScope) {
+        return host_realloc(callback_scope(userdata), original, size, alignment);
+    }
+
+    static VKAPI_ATTR void VKAPI_CALL vulkan_free(void* userdata, void* memory) {
+        host_free(callback_scope(userdata), memory);
+    }
+
+    static vk::AllocationCallbacks make_callbacks(alloc_scope scope) noexcept {
+        return vk::AllocationCallbacks{
+                .pUserData = reinterpret_cast<void*>(static_cast<uintptr_t>(scope)),
+                .pfnAllocation = vulkan_alloc,
+                .pfnReallocation = vulkan_realloc,
+                .pfnFree = vulkan_free,
+        };
+    }
+
+    const vk::AllocationCallbacks* host_callbacks(alloc_scope scope) noexcept {
+#if VGI_HOST_ALLOCATOR
+        static const vk::AllocationCallbacks callbacks[ALLOC_SCOPE_COUNT] = {
+                make_callbacks(alloc_scope::vulkan),
+                make_callbacks(alloc_scope::vma),
+                make_callbacks(alloc_scope::sdl),
+                make_callbacks(alloc_scope::arena),
+        };
+        return &callbacks[static_cast<size_t>(scope)];
+#else
+        return nullptr;
+#endif
+    }
+}  // namespace vgi
@@ -0,0 +1,74 @@
+/*! \file */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "defs.hpp"
+#include "vulkan.hpp"
+
+namespace vgi {
+    /// @brief Subsystems whose host allocations are routed through vgi, and accounted separately
+    enum struct alloc_scope : uint8_t {
+        /// @brief Allocations made by the Vulkan driver for the instance and devices
+        vulkan,
+        /// @brief Allocations made by VMA, and by the Vulkan driver for the objects VMA creates
+        vma,
+        /// @brief Allocations made by SDL
+        sdl,
+        /// @brief Memory reserved by the per-frame arenas of the windows
+        arena,
+    };
+
+    /// @brief Number of variants of `vgi::alloc_scope`
+    constexpr inline const size_t ALLOC_SCOPE_COUNT = 4;
+
+    /// @brief Host allocation counters of a subsystem
+    struct alloc_stats {
+        /// @brief Number of allocations made
+        uint64_t allocations = 0;
+        /// @brief Number of allocations released
+        uint64_t frees = 0;
+        /// @brief Number of reallocations that had to move the allocation
+        uint64_t reallocations = 0;
+        /// @brief Number of bytes currently allocated
+        size_t live_bytes = 0;
+        /// @brief Maximum number of bytes that were allocated at the same time
+        size_t peak_bytes = 0;
+    };
+
+    /// @brief Allocates host memory
+    /// @details Small allocations are served from size-classed pools, through a per-thread cache,
+    /// so that allocating and releasing them seldom takes a lock or reaches the system allocator.
+    /// @param scope Subsystem the allocation is accounted to
+    /// @param size Number of bytes to allocate
+    /// @param alignment Alignment of the allocation. Must be a power of two.
+    /// @return Pointer to the allocated memory, or `nullptr` if allocation failed
+    void* host_alloc(alloc_scope scope, size_t size,
+                     size_t alignment = alignof(std::max_align_t)) noexcept;
+
+    /// @brief Resizes an allocation made with `host_alloc`
+    /// @details Shrinking an allocation, or growing it within its size class, never moves it.
+    /// @param scope Subsystem the allocation is accounted to
+    /// @param ptr Allocation to be resized. If `nullptr`, a new allocation is made.
+    /// @param size New size of the allocation, in bytes. If zero, the allocation is released.
+    /// @param alignment Alignment of the allocation. Must be a power of two.
+    /// @return Pointer to the resized allocation, or `nullptr` if it was released or allocation
+    /// failed (in which case `ptr` is left untouched)
+    void* host_realloc(alloc_scope scope, void* ptr, size_t size,
+                       size_t alignment = alignof(std::max_align_t)) noexcept;
+
+    /// @brief Releases an allocation made with `host_alloc`
+    /// @param scope Subsystem the allocation is accounted to
+    /// @param ptr Allocation to be released. May be `nullptr`.
+    void host_free(alloc_scope scope, void* ptr) noexcept;
+
+    /// @brief Host allocation counters of a subsystem
+    /// @param scope Subsystem
+    alloc_stats host_alloc_stats(alloc_scope scope) noexcept;
+
+    /// @brief Vulkan allocation callbacks that route the allocations of the driver through vgi
+    /// @param scope Subsystem the allocations are accounted to
+    /// @return The callbacks, or `nullptr` if `VGI_HOST_ALLOCATOR` is disabled
+    const vk::AllocationCallbacks* host_callbacks(alloc_scope scope) noexcept;
+}  // namespace vgi
@@ -0,0 +1,104 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <new>
+#include <optional>
+
+#include "alloc.hpp"
+#include "math.hpp"
+
+namespace vgi {
+    // Chunks are laid out as a header followed by their data, and linked in allocation order
+    struct frame_arena::chunk {
+        chunk* next;
+        size_t size;
+
+        inline std::byte* data() noexcept { return reinterpret_cast<std::byte*>(this + 1); }
+    };
+
+    // Bumps `head` to fit a region within the data of a chunk, if possible
+    static void* bump(std::byte* data, size_t size, size_t& head, size_t bytes,
+                      size_t alignment) noexcept {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(data) + head;
+        const size_t padding = static_cast<size_t>(-address & (alignment - 1));
+        if (padding > size - head || bytes > size - head - padding) return nullptr;
+
+        void* result = data + head + padding;
+        head += padding + bytes;
+        return result;
+    }
+
+    void* frame_arena::do_allocate(size_t bytes, size_t alignment) {
+        VGI_ASSERT(std::has_single_bit(alignment));
+        bytes = (std::max)(bytes, size_t{1});
+
+        void* result = nullptr;
+        if (this->current != nullptr) {
+            result = bump(this->current->data(), this->current->size, this->head, bytes,
+                          alignment);
+            // Move on to the chunks reserved by earlier frames, before reserving a new one
+            while (result == nullptr && this->current->next != nullptr) {
+                this->current = this->current->next;
+                this->head = 0;
+                result = bump(this->current->data(), this->current->size, this->head, bytes,
+                              alignment);
+            }
+        }
+
+        if (result == nullptr) {
+            std::optional<size_t> size = math::check_add(bytes, alignment - 1);
+            if (size) size = (std::max)(*size, this->chunk_size);
+            std::optional<size_t> total =
+                    size ? math::check_add(*size, sizeof(chunk)) : std::nullopt;
+            if (!total) throw std::bad_alloc{};
+
+            chunk* VGI_RESTRICT new_chunk =
+                    static_cast<chunk*>(host_alloc(alloc_scope::arena, *total, alignof(chunk)));
+            if (new_chunk == nullptr) throw std::bad_alloc{};
+            *new_chunk = chunk{.next = nullptr, .size = *size};
+
+            if (this->current != nullptr) {
+                this->current->next = new_chunk;
+            } else {
+                this->first = new_chunk;
+            }
+            this->current = new_chunk;
+            this->head = 0;
+            this->reserved_bytes += *size;
+
+            result = bump(new_chunk->data(), new_chunk->size, this->head, bytes, alignment);
+            VGI_ASSERT(result != nullptr);
+        }
+
+        this->used_bytes += bytes;
+        this->peak_bytes = (std::max)(this->peak_bytes, this->used_bytes);
+        return result;
+    }
+
+    void frame_arena::do_deallocate(void* ptr, size_t bytes, size_t) noexcept {
+        if (ptr == nullptr || this->current == nullptr) return;
+        bytes = (std::max)(bytes, size_t{1});
+
+        // Only the last region can be handed back
+        const uintptr_t data = reinterpret_cast<uintptr_t>(this->current->data());
+        const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        if (address < data || address + bytes != data + this->head) return;
+
+        this->head = static_cast<size_t>(address - data);
+        this->used_bytes -= bytes;
+    }
+
+    void frame_arena::reset() noexcept {
+        this->current = this->first;
+        this->head = 0;
+        this->used_bytes = 0;
+    }
+
+    frame_arena::~frame_arena() noexcept {
+        for (chunk* it = this->first; it != nullptr;) {
+            host_free(alloc_scope::arena, std::exchange(it, it->next));
+        }
+    }
+}  // namespace vgi
@@ -0,0 +1,101 @@
+/*! \file */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vgi/defs.hpp>
+#include <vgi/memory.hpp>
+
+namespace vgi {
+    /// @brief A host bump allocator for scratch data that only lives for a single frame
+    /// @details Every frame in flight owns an arena (see `window::arena`), which is reset once the
+    /// device has finished with that frame, at the same point as its transient buffer. Memory is
+    /// reserved in chunks that are kept across resets, so once an arena has grown to fit the
+    /// largest frame, allocating from it never reaches the system allocator again.
+    ///
+    /// The arena is a `std::pmr::memory_resource`, so it can back any allocator-aware container
+    /// (i.e. `std::pmr::vector`), as well as `vgi::unique_span` (see
+    /// `make_unique_span_for_overwrite`). Deallocating is a no-op, unless the region is the last
+    /// one that was allocated, in which case it's handed back to the arena.
+    ///
+    /// @warning Arenas are not thread-safe, and anything allocated from them must not outlive the
+    /// frame it was allocated for.
+    class frame_arena final : public std::pmr::memory_resource {
+    public:
+        /// @brief Default constructor. Reserves no memory until the first allocation.
+        frame_arena() = default;
+
+        /// @brief Creates a new arena
+        /// @param chunk_size Minimum number of bytes reserved every time the arena grows
+        explicit frame_arena(size_t chunk_size) noexcept : chunk_size(chunk_size) {
+            VGI_ASSERT(chunk_size > 0);
+        }
+
+        /// @brief Move constructor
+        /// @details Any memory allocated from `other` is now owned by the new arena.
+        /// @param other Object to be moved
+        frame_arena(frame_arena&& other) noexcept :
+            std::pmr::memory_resource(), first(std::exchange(other.first, nullptr)),
+            current(std::exchange(other.current, nullptr)), head(std::exchange(other.head, 0)),
+            used_bytes(std::exchange(other.used_bytes, 0)),
+            peak_bytes(std::exchange(other.peak_bytes, 0)),
+            reserved_bytes(std::exchange(other.reserved_bytes, 0)), chunk_size(other.chunk_size) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        frame_arena& operator=(frame_arena&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Number of bytes allocated since the arena was last reset
+        constexpr size_t used() const noexcept { return this->used_bytes; }
+        /// @brief Maximum number of bytes allocated between two resets
+        constexpr size_t peak() const noexcept { return this->peak_bytes; }
+        /// @brief Number of bytes reserved by the arena
+        constexpr size_t reserved() const noexcept { return this->reserved_bytes; }
+
+        /// @brief Polymorphic allocator that allocates from the arena
+        /// @tparam T Type of the elements to allocate
+        template<class T = std::byte>
+        inline std::pmr::polymorphic_allocator<T> allocator() noexcept {
+            return std::pmr::polymorphic_allocator<T>{this};
+        }
+
+        /// @brief Releases everything allocated from the arena, keeping its memory for later use
+        /// @warning Anything allocated from the arena must no longer be in use
+        void reset() noexcept;
+
+        /// @brief Destructor. Returns the memory of the arena to the system.
+        ~frame_arena() noexcept override;
+
+        frame_arena(const frame_arena&) = delete;
+        frame_arena& operator=(const frame_arena&) = delete;
+
+    protected:
+        //! @cond Doxygen_Suppress
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) noexcept override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+        //! @endcond
+
+    private:
+        struct chunk;
+
+        chunk* first = nullptr;
+        chunk* current = nullptr;
+        // Offset of the next free byte of the current chunk
+        size_t head = 0;
+        size_t used_bytes = 0;
+        size_t peak_bytes = 0;
+        size_t reserved_bytes = 0;
+        size_t chunk_size = VGI_FRAME_ARENA_SIZE;
+    };
+}  // namespace vgi
@@ -1,34 +1,45 @@
 #include "gltf.hpp"
 
+#include <algorithm>
 #include <bit>
 #include <concepts>
+#include <cstddef>
+#include <cstring>
 #include <fastgltf/core.hpp>
 #include <fastgltf/glm_element_traits.hpp>
 #include <fastgltf/math.hpp>
 #include <fastgltf/tools.hpp>
 #include <fastgltf/types.hpp>
+#include <functional>
 #include <glm/glm.hpp>
 #include <memory>
 #include <ranges>
 #include <type_traits>
+#include <vector>
 #include <vgi/buffer/index.hpp>
+#include <vgi/buffer/staging.hpp>
 #include <vgi/buffer/transfer.hpp>
 #include <vgi/buffer/vertex.hpp>
 #include <vgi/cmdbuf.hpp>
 #include <vgi/fs.hpp>
 #include <vgi/log.hpp>
 #include <vgi/math.hpp>
+#include <vgi/resource/optimize.hpp>
 #include <vgi/vgi.hpp>
 #include <vgi/window.hpp>
 
 using namespace std::literals;
 
-#define COPY_VERTEX_FIELD(__field, ...)                                \
-    this->template copy_vertex_field<decltype(::vgi::vertex::__field), \
-                                     offsetof(::vgi::vertex, __field)>(asset, __VA_ARGS__, dest)
-#define FILL_VERTEX_FIELD(__field, ...)                                \
-    this->template fill_vertex_field<decltype(::vgi::vertex::__field), \
-                                     offsetof(::vgi::vertex, __field)>(__VA_ARGS__, dest)
+// Reads the accessor's elements as `__type`, and quantizes them with `__pack` into the `__field` of
+// the `__stream` of every vertex
+#define VERTEX_FIELD_OFFSET(__stream, __field) \
+    (offsetof(::vgi::vertex, __stream) + offsetof(decltype(::vgi::vertex::__stream), __field))
+#define COPY_VERTEX_FIELD(__stream, __field, __type, __pack, ...)                         \
+    this->template copy_vertex_field<__type, VERTEX_FIELD_OFFSET(__stream, __field)>(     \
+            asset, __VA_ARGS__, dest, __pack)
+#define FILL_VERTEX_FIELD(__stream, __field, ...)                                          \
+    this->template fill_vertex_field<decltype(decltype(::vgi::vertex::__stream)::__field), \
+                                     VERTEX_FIELD_OFFSET(__stream, __field)>(__VA_ARGS__, dest)
 
 constexpr fastgltf::Options LOAD_OPTIONS =
         fastgltf::Options::DecomposeNodeMatrices | fastgltf::Options::GenerateMeshIndices;
@@ -193,18 +204,33 @@ namespace vgi::gltf {
         return result;
     }
 
+    // Computes the bounds of a node and all of its descendants, in the node's space
+    static void compute_bounds(std::span<node> nodes, std::span<const mesh> meshes, size_t index,
+                               std::vector<bool>& done) {
+        if (done[index]) return;
+        done[index] = true;
+
+        node& current = nodes[index];
+        if (current.mesh) {
+            current.bounds = meshes[*current.mesh].bounds;
+            current.bounding_sphere = meshes[*current.mesh].bounding_sphere;
+        }
+        for (size_t child_index: current.children) {
+            compute_bounds(nodes, meshes, child_index, done);
+            const node& child = nodes[child_index];
+            const glm::mat4 transform =
+                    math::transf3d{child.local_origin, child.local_rotation, child.local_scale};
+            current.bounds.extend(child.bounds.transform(transform));
+            current.bounding_sphere.extend(child.bounding_sphere.transform(transform));
+        }
+    }
+
     static scene parse_scene(const fastgltf::Scene& s) {
         scene result{.name = std::string{s.name}};
         result.roots.insert(result.roots.cend(), s.nodeIndices.cbegin(), s.nodeIndices.cend());
         return result;
     }
 
-    struct TransferOffset {
-        size_t buffer;
-        size_t offset;
-        size_t byte_size;
-    };
-
     struct asset_parser {
         window& parent;
         fastgltf::Parser& parser;
@@ -215,8 +241,6 @@ namespace vgi::gltf {
         std::vector<animation> animations;
         std::vector<std::shared_ptr<surface>> images;
         std::vector<std::shared_ptr<struct material>> materials;
-        std::vector<size_t> transfer_buffers;
-        size_t transfer_size = 0;
 
         asset_parser(window& parent, fastgltf::Parser& parser, fastgltf::Asset& asset) :
             parent(parent), parser(parser), asset(asset) {
@@ -286,41 +310,6 @@ namespace vgi::gltf {
             return std::addressof(this->asset);
         }
 
-        /// @brief Reserves device mapped memory for a later upload
-        /// @param count Number of elements to reserve memory for
-        /// @return The transfer information of the reserved memory
-        template<class T>
-        TransferOffset reserve(size_t count) {
-            std::optional<size_t> byte_size = math::check_mul<size_t>(sizeof(T), count);
-            if (!byte_size) throw vgi_error{"arithmetic overflow"};
-            if (auto new_transfer_size = math::check_add(this->transfer_size, *byte_size)) {
-                const size_t offset = this->transfer_size;
-                this->transfer_size = *new_transfer_size;
-                return {this->transfer_buffers.size(), offset, *byte_size};
-            } else {
-                this->transfer_buffers.push_back(std::exchange(this->transfer_size, *byte_size));
-                return {this->transfer_buffers.size(), 0, *byte_size};
-            }
-        }
-
-        /// @brief Reserves device mapped memory for a later upload
-        /// @param accessor GLTF accessor describing the memory to be reserved
-        /// @return The transfer information of the reserved memory
-        TransferOffset reserve(const fastgltf::Accessor& accessor) {
-            size_t element_size =
-                    fastgltf::getElementByteSize(accessor.type, accessor.componentType);
-            std::optional<size_t> byte_size = math::check_mul(element_size, accessor.count);
-            if (!byte_size) throw vgi_error{"arithmetic overflow"};
-            if (auto new_transfer_size = math::check_add(this->transfer_size, *byte_size)) {
-                const size_t offset = this->transfer_size;
-                this->transfer_size = *new_transfer_size;
-                return {this->transfer_buffers.size(), offset, *byte_size};
-            } else {
-                this->transfer_buffers.push_back(std::exchange(this->transfer_size, *byte_size));
-                return {this->transfer_buffers.size(), 0, *byte_size};
-            }
-        }
-
         surface load_image(fastgltf::DataSource& source) {
             if (fastgltf::sources::BufferView* buf_view =
                         std::get_if<fastgltf::sources::BufferView>(&source)) {
@@ -551,55 +540,59 @@ namespace vgi::gltf {
 
     struct asset_uploader {
         fastgltf::Asset& asset;
-        command_buffer cmdbuf;
-        std::vector<transfer_buffer> transfer_buffers;
-
-        asset_uploader(window& win, asset_parser& parser) : asset(parser.asset), cmdbuf(win) {
-            if (parser.transfer_size > 0) parser.transfer_buffers.push_back(parser.transfer_size);
-            this->transfer_buffers.reserve(parser.transfer_buffers.size());
-            for (size_t size: parser.transfer_buffers) {
-                this->transfer_buffers.emplace_back(win, size);
-            }
-        }
+        window& win;
 
-        //! @copydoc command_buffer::window
-        inline struct window& parent() const noexcept { return cmdbuf.parent(); }
-
-        /// @brief Registers the transfer on the command buffer.
-        /// @param transfer Transfer information
-        /// @param dest Destination buffer
-        /// @param dest_offset Destination buffer offset
-        /// @return Memory region where the upload data must be written
-        std::span<std::byte> upload(TransferOffset transfer, vk::Buffer dest,
-                                    size_t dest_offset = 0) noexcept {
-            transfer_buffer& buf = this->transfer_buffers[transfer.buffer];
-            cmdbuf->copyBuffer(buf, dest,
-                               vk::BufferCopy{.srcOffset = transfer.offset,
-                                              .dstOffset = dest_offset,
-                                              .size = transfer.byte_size});
-            return buf->subspan(transfer.offset, transfer.byte_size);
-        }
+        asset_uploader(window& win, asset_parser& parser) : asset(parser.asset), win(win) {}
 
-        /// @brief Registers the transfer on the command buffer.
-        /// @param transfer Transfer information
+        /// @brief Window that will own the uploaded resources
+        inline struct window& parent() const noexcept { return this->win; }
+        /// @brief Staging ring through which the uploads are streamed
+        inline staging_ring& staging() const noexcept { return this->win.staging(); }
+        /// @brief Geometry pool where the primitives are stored
+        inline geometry_pool& geometry() const noexcept { return this->win.geometry(); }
+
+        /// @brief Registers the transfer on the staging ring.
         /// @param src Surface to upload
         /// @return The new texture with it's data upload already set up
-        vgi::texture upload(TransferOffset transfer, const surface& src) noexcept {
-            transfer_buffer& buf = this->transfer_buffers[transfer.buffer];
-            return vgi::texture{this->parent(),
-                                this->cmdbuf,
-                                buf,
-                                src,
-                                vk::ImageUsageFlagBits::eSampled,
+        vgi::texture upload(const surface& src) {
+            return vgi::texture{this->win, this->staging(), src, vk::ImageUsageFlagBits::eSampled,
                                 vk::SampleCountFlagBits::e1,
-                                vk::ImageLayout::eShaderReadOnlyOptimal,
-                                transfer.offset};
+                                vk::ImageLayout::eShaderReadOnlyOptimal};
         }
 
-        ~asset_uploader() {
-            for (auto& buf: this->transfer_buffers) {
-                std::move(buf).destroy(cmdbuf.parent());
+        /// @brief Sub-allocates a range from the geometry pool, and stages its data
+        /// @param vertices Vertices of the range
+        /// @param indices Indices of the range
+        /// @param meshlets Meshlets of the range, if any
+        /// @return The new range
+        geometry_range upload(std::span<const vertex> vertices, std::span<const uint32_t> indices,
+                              std::span<const meshlet> meshlets) {
+            if (indices.size() > static_cast<size_t>(UINT32_MAX)) {
+                throw vgi_error{"Primitive has too many indices"};
+            }
+            if (vertices.size() > static_cast<size_t>(INT32_MAX)) {
+                throw vgi_error{"Primitive has too many vertices"};
+            }
+
+            geometry_pool& pool = this->geometry();
+            geometry_range range = pool.allocate(this->win, static_cast<uint32_t>(vertices.size()),
+                                                 static_cast<uint32_t>(indices.size()),
+                                                 static_cast<uint32_t>(meshlets.size()));
+            try {
+                // Each staged region must be written before the next one is staged
+                std::memcpy(pool.stage_indices(this->win, range).data(), indices.data(),
+                            indices.size() * sizeof(uint32_t));
+                if (!meshlets.empty()) {
+                    std::memcpy(pool.stage_meshlets(this->win, range).data(), meshlets.data(),
+                                meshlets.size() * sizeof(meshlet));
+                }
+                vertex::copy_positions(vertices, pool.stage_positions(this->win, range).data());
+                vertex::copy_attributes(vertices, pool.stage_attributes(this->win, range).data());
+            } catch (...) {
+                pool.free(range);
+                throw;
             }
+            return range;
         }
     };
 
@@ -614,8 +607,6 @@ namespace vgi::gltf {
         fastgltf::Accessor* weights = nullptr;
         std::shared_ptr<struct material> material;
         vk::PrimitiveTopology topology;
-        TransferOffset index_transfer;
-        TransferOffset vertex_transfer;
 
         primitive_parser(asset_parser& asset, fastgltf::Primitive& primitive) :
             indices(find_accessor(asset, primitive.indicesAccessor)),
@@ -628,16 +619,11 @@ namespace vgi::gltf {
             weights(find_accessor(asset, primitive, "WEIGHTS_0")),
             material(primitive.materialIndex ? asset.materials[*primitive.materialIndex]
                                              : nullptr) {
-            if (this->indices) {
-                if (this->indices->count > static_cast<size_t>(UINT32_MAX)) {
-                    throw vgi_error{"Primitive has too many indices"};
-                } else {
-                    this->index_transfer = asset.reserve(*this->indices);
-                }
+            if (this->indices && this->indices->count > static_cast<size_t>(UINT32_MAX)) {
+                throw vgi_error{"Primitive has too many indices"};
             }
-
-            if (this->position) {
-                this->vertex_transfer = asset.template reserve<vertex>(this->position->count);
+            if (this->position && this->position->count > static_cast<size_t>(INT32_MAX)) {
+                throw vgi_error{"Primitive has too many vertices"};
             }
 
             switch (primitive.type) {
@@ -664,73 +650,123 @@ namespace vgi::gltf {
             }
         }
 
-        primitive upload(asset_uploader& asset) {
+        primitive upload(asset_uploader& asset, bool resident) {
             VGI_ASSERT(this->indices != nullptr);
             VGI_ASSERT(this->position != nullptr);
 
-            primitive result;
-            result.material = this->material;
-            result.topology = this->topology;
-
-            // Upload indices
-            vertex_buffer* vertices = nullptr;
-            switch (this->indices->componentType) {
-                case fastgltf::ComponentType::UnsignedShort: {
-                    auto& value = result.mesh.template emplace<vgi::mesh<uint16_t>>(
-                            asset.parent(), this->position->count,
-                            static_cast<uint32_t>(this->indices->count));
-                    std::span<std::byte> dest = asset.upload(this->index_transfer, value.indices);
-                    fastgltf::copyFromAccessor<uint16_t>(asset.asset, *this->indices,
-                                                         static_cast<void*>(dest.data()));
-                    vertices = &value.vertices;
-                    break;
-                }
-                case fastgltf::ComponentType::UnsignedInt: {
-                    auto& value = result.mesh.template emplace<vgi::mesh<uint32_t>>(
-                            asset.parent(), this->position->count,
-                            static_cast<uint32_t>(this->indices->count));
-                    std::span<std::byte> dest = asset.upload(this->index_transfer, value.indices);
-                    fastgltf::copyFromAccessor<uint32_t>(asset.asset, *this->indices,
-                                                         static_cast<void*>(dest.data()));
-                    vertices = &value.vertices;
-                    break;
-                }
-                default:
-                    throw vgi_error{"Invalid index type"};
+            // Vertices are assembled on the host first, so that they can be optimized before
+            // they are sub-allocated from the pool
+            std::vector<vertex> vertices(this->position->count);
+            std::vector<uint32_t> indices(this->indices->count);
+            this->read(asset, vertices, indices);
+
+            // Primitives that are only drawn by batches just keep their description
+            if (!resident) {
+                primitive result{.material = this->material, .topology = this->topology};
+                std::tie(result.bounds, result.bounding_sphere) = this->bounds(vertices);
+                return result;
             }
+            // Triangle lists are also split into meshlets, so that they can be culled on the
+            // device, and simplified into levels of detail, whose indices follow the full detail
+            // ones
+            std::vector<meshlet> meshlets;
+            std::vector<mesh_lod> lods;
+            if (this->topology == vk::PrimitiveTopology::eTriangleList) {
+                optimize_mesh(vertices, indices);
+                meshlets = build_meshlets(vertices, indices);
+                lods = build_lods(vertices, indices);
+            }
+            if (lods.empty()) {
+                lods.push_back(mesh_lod{
+                        .first_index = 0,
+                        .index_count = static_cast<uint32_t>(indices.size()),
+                        .error = 0.0f,
+                });
+            }
+            primitive result{
+                    .geometry = asset.upload(vertices, indices, meshlets),
+                    .material = this->material,
+                    .topology = this->topology,
+                    .lods = std::move(lods),
+            };
+            std::tie(result.bounds, result.bounding_sphere) = this->bounds(vertices);
 
-            // Upload vertices
-            VGI_ASSERT(vertices != nullptr);
-            std::byte* dest = asset.upload(this->vertex_transfer, *vertices).data();
-            COPY_VERTEX_FIELD(origin, *this->position);
+            // The range itself only draws the full detail level, while the allocation (which is
+            // what gets released) still spans every level
+            result.geometry.index_count = result.lods.front().index_count;
+            return result;
+        }
+
+        void read(asset_uploader& asset, std::span<vertex> vertices,
+                  std::span<uint32_t> indices) {
+            // Indices are always widened to 32 bits
+            fastgltf::copyFromAccessor<uint32_t>(asset.asset, *this->indices,
+                                                 static_cast<void*>(indices.data()));
+
+            // Attributes are read as floats (whatever their format on the asset), and quantized
+            std::byte* dest = reinterpret_cast<std::byte*>(vertices.data());
+            COPY_VERTEX_FIELD(position, origin, glm::vec3, vertex::pack_origin, *this->position);
 
             if (this->normal) {
-                COPY_VERTEX_FIELD(normal, *this->normal);
+                COPY_VERTEX_FIELD(attributes, normal, glm::vec3, vertex::pack_normal,
+                                  *this->normal);
             } else {
-                FILL_VERTEX_FIELD(normal, {0.0f, 1.0f, 0.0f});
+                FILL_VERTEX_FIELD(attributes, normal, vertex::pack_normal({0.0f, 1.0f, 0.0f}));
             }
             if (this->texcoord) {
-                COPY_VERTEX_FIELD(tex, *this->texcoord);
+                COPY_VERTEX_FIELD(attributes, tex, glm::vec2, std::identity{}, *this->texcoord);
             } else {
-                FILL_VERTEX_FIELD(tex, {0.0f, 0.0f});
+                FILL_VERTEX_FIELD(attributes, tex, {0.0f, 0.0f});
             }
             if (this->color) {
-                COPY_VERTEX_FIELD(color, *this->color);
+                if (this->color->type == fastgltf::AccessorType::Vec3) {
+                    COPY_VERTEX_FIELD(attributes, color, glm::vec3, pack_rgb, *this->color);
+                } else {
+                    COPY_VERTEX_FIELD(attributes, color, glm::vec4, vertex::pack_color,
+                                      *this->color);
+                }
             } else {
-                FILL_VERTEX_FIELD(color, {1.0f, 1.0f, 1.0f, 1.0f});
+                FILL_VERTEX_FIELD(attributes, color, vertex::pack_color(glm::vec4{1.0f}));
             }
             if (this->joints) {
-                COPY_VERTEX_FIELD(joints, *this->joints);
+                COPY_VERTEX_FIELD(attributes, joints, glm::uvec4, pack_joints, *this->joints);
             } else {
-                FILL_VERTEX_FIELD(joints, {0, 0, 0, 0});
+                FILL_VERTEX_FIELD(attributes, joints, {0, 0, 0, 0});
             }
             if (this->weights) {
-                COPY_VERTEX_FIELD(weights, *this->weights);
+                COPY_VERTEX_FIELD(attributes, weights, glm::vec4, vertex::pack_weights,
+                                  *this->weights);
             } else {
-                FILL_VERTEX_FIELD(weights, {1.0f, 0.0f, 0.0f, 0.0f});
+                FILL_VERTEX_FIELD(attributes, weights,
+                                  vertex::pack_weights({1.0f, 0.0f, 0.0f, 0.0f}));
             }
+        }
 
-            return result;
+        // Bounds are taken from the position accessor when it has them, and computed from the
+        // vertices otherwise. Spheres are always fit to the vertices, around the box's center.
+        std::pair<math::aabb, math::sphere> bounds(std::span<const vertex> vertices) const {
+            math::aabb box;
+            const fastgltf::Accessor& accessor = *this->position;
+            // The bounds of quantized positions are not in the same units as the positions
+            if (accessor.componentType == fastgltf::ComponentType::Float &&
+                accessor.min.size() == 3 && accessor.max.size() == 3) {
+                for (glm::length_t i = 0; i < 3; ++i) {
+                    box.min[i] = static_cast<float>(accessor.min.get<double>(i));
+                    box.max[i] = static_cast<float>(accessor.max.get<double>(i));
+                }
+            } else {
+                for (const vertex& value: vertices) {
+                    box.extend(vertex::unpack_origin(value.position.origin));
+                }
+            }
+            if (box.empty()) return std::make_pair(box, math::sphere{});
+
+            math::sphere sphere{.center = box.center(), .radius = 0.0f};
+            for (const vertex& value: vertices) {
+                const glm::vec3 origin = vertex::unpack_origin(value.position.origin);
+                sphere.radius = (std::max)(sphere.radius, glm::distance(sphere.center, origin));
+            }
+            return std::make_pair(box, sphere);
         }
 
         static fastgltf::Accessor* find_accessor(asset_parser& asset,
@@ -747,13 +783,25 @@ namespace vgi::gltf {
             return std::addressof(asset->accessors[prim->accessorIndex]);
         }
 
-        template<class T, size_t offset>
+        static glm::u8vec4 pack_rgb(const glm::vec3& color) noexcept {
+            return vertex::pack_color(glm::vec4{color, 1.0f});
+        }
+
+        static glm::u8vec4 pack_joints(const glm::uvec4& joints) {
+            if (glm::any(glm::greaterThan(joints, glm::uvec4{UINT8_MAX}))) {
+                throw vgi_error{"Joint indices must fit in 8 bits"};
+            }
+            return glm::u8vec4{joints};
+        }
+
+        template<class T, size_t offset, class F>
         void copy_vertex_field(asset_uploader& asset, fastgltf::Accessor& accessor,
-                               std::byte* vertices) {
+                               std::byte* vertices, F&& pack) {
             for (size_t i = 0; i < (std::min) (accessor.count, this->position->count); ++i) {
                 std::byte* dest = vertices + i * sizeof(vertex) + offset;
-                T value = fastgltf::getAccessorElement<T>(asset.asset, accessor, i);
-                std::memcpy(dest, std::addressof(value), sizeof(T));
+                auto value = std::invoke(
+                        pack, fastgltf::getAccessorElement<T>(asset.asset, accessor, i));
+                std::memcpy(dest, std::addressof(value), sizeof(value));
             }
         }
 
@@ -786,11 +834,150 @@ namespace vgi::gltf {
             }
         }
 
-        mesh upload(asset_uploader& asset) {
-            mesh result{.name = std::move(this->name)};
+        mesh upload(asset_uploader& asset, bool resident) {
+            mesh result{.resident = resident, .name = std::move(this->name)};
             result.primitives.reserve(this->primitives.size());
             for (primitive_parser& primitive: this->primitives) {
-                result.primitives.push_back(primitive.upload(asset));
+                const struct primitive& uploaded =
+                        result.primitives.emplace_back(primitive.upload(asset, resident));
+                result.bounds.extend(uploaded.bounds);
+                result.bounding_sphere.extend(uploaded.bounding_sphere);
+            }
+            return result;
+        }
+    };
+
+    // Merges the primitives of a scene's static nodes into batches
+    struct batch_builder {
+        struct group {
+            std::shared_ptr<struct material> material;
+            vk::PrimitiveTopology topology;
+            glm::ivec3 cell;
+            // Positions are kept in full precision until the center of the batch is known
+            std::vector<glm::vec3> origins;
+            std::vector<vertex> vertices;
+            std::vector<uint32_t> indices;
+            math::aabb bounds;
+        };
+
+        asset_uploader& uploader;
+        std::span<mesh_parser> meshes;
+        std::span<node> nodes;
+        // Whether each node is the target of an animation channel
+        const std::vector<bool>& animated;
+        std::vector<group> groups;
+
+        // Strips and fans can't be merged without restarting them
+        static bool mergeable(vk::PrimitiveTopology topology) noexcept {
+            return topology == vk::PrimitiveTopology::ePointList ||
+                   topology == vk::PrimitiveTopology::eLineList ||
+                   topology == vk::PrimitiveTopology::eTriangleList;
+        }
+
+        // Adds the meshes of a node and its descendants, unless they are animated
+        void collect(size_t index, const glm::mat4& parent_transform) {
+            if (this->animated[index]) return;
+
+            node& current = this->nodes[index];
+            const glm::mat4 local = math::transf3d{current.local_origin, current.local_rotation,
+                                                   current.local_scale};
+            const glm::mat4 transform = parent_transform * local;
+            if (current.mesh && !current.skin &&
+                std::ranges::all_of(this->meshes[*current.mesh].primitives,
+                                    [](const primitive_parser& primitive) {
+                                        return mergeable(primitive.topology);
+                                    })) {
+                for (primitive_parser& primitive: this->meshes[*current.mesh].primitives) {
+                    this->add(primitive, transform);
+                }
+                current.batched = true;
+            }
+            for (size_t child_index: current.children) this->collect(child_index, transform);
+        }
+
+        void add(primitive_parser& primitive, const glm::mat4& transform) {
+            std::vector<vertex> vertices(primitive.position->count);
+            std::vector<uint32_t> indices(primitive.indices->count);
+            primitive.read(this->uploader, vertices, indices);
+
+            // Normals are transformed by the inverse transpose, so that they stay perpendicular
+            // to their surfaces under non-uniform scales
+            const glm::mat3 normal_transform = glm::transpose(glm::inverse(glm::mat3{transform}));
+            std::vector<glm::vec3> origins;
+            origins.reserve(vertices.size());
+            math::aabb bounds;
+            for (vertex& value: vertices) {
+                const glm::vec3 origin{
+                        transform * glm::vec4{vertex::unpack_origin(value.position.origin), 1.0f}};
+                origins.push_back(origin);
+                bounds.extend(origin);
+                value.attributes.normal = vertex::pack_normal(
+                        normal_transform * vertex::unpack_normal(value.attributes.normal));
+            }
+            if (bounds.empty()) return;
+
+            const glm::ivec3 cell{glm::floor(bounds.center() / batch::CELL_SIZE)};
+            auto it = std::ranges::find_if(this->groups, [&](const group& value) {
+                return value.material == primitive.material &&
+                       value.topology == primitive.topology && value.cell == cell;
+            });
+            if (it == this->groups.end()) {
+                it = this->groups.insert(it, group{.material = primitive.material,
+                                                   .topology = primitive.topology,
+                                                   .cell = cell});
+            }
+            group& target = *it;
+            const size_t first_vertex = target.vertices.size();
+            if (first_vertex + vertices.size() > static_cast<size_t>(INT32_MAX)) {
+                throw vgi_error{"Batch has too many vertices"};
+            }
+
+            target.origins.insert(target.origins.cend(), origins.cbegin(), origins.cend());
+            target.vertices.insert(target.vertices.cend(), vertices.cbegin(), vertices.cend());
+            target.bounds.extend(bounds);
+            // Mirroring transforms flip the winding of triangles, which is restored by swapping
+            // the last two indices of each one
+            const bool flip = primitive.topology == vk::PrimitiveTopology::eTriangleList &&
+                              indices.size() % 3 == 0 &&
+                              glm::determinant(glm::mat3{transform}) < 0.0f;
+            target.indices.reserve(target.indices.size() + indices.size());
+            for (size_t i = 0; i < indices.size(); ++i) {
+                size_t source = i;
+                if (flip && i % 3 != 0) source = i % 3 == 1 ? i + 1 : i - 1;
+                target.indices.push_back(static_cast<uint32_t>(first_vertex) + indices[source]);
+            }
+        }
+
+        std::vector<batch> upload() {
+            std::vector<batch> result;
+            result.reserve(this->groups.size());
+            for (group& value: this->groups) {
+                if (value.indices.empty()) continue;
+
+                const glm::vec3 center = value.bounds.center();
+                math::sphere sphere{.center = center, .radius = 0.0f};
+                for (size_t i = 0; i < value.vertices.size(); ++i) {
+                    const glm::vec3& origin = value.origins[i];
+                    sphere.radius = (std::max)(sphere.radius, glm::distance(center, origin));
+                    value.vertices[i].position.origin = vertex::pack_origin(origin - center);
+                }
+
+                std::vector<meshlet> meshlets;
+                if (value.topology == vk::PrimitiveTopology::eTriangleList) {
+                    optimize_mesh(value.vertices, value.indices);
+                    meshlets = build_meshlets(value.vertices, value.indices);
+                }
+
+                glm::mat4 transform{1.0f};
+                transform[3] = glm::vec4{center, 1.0f};
+                result.push_back(batch{
+                        .geometry = this->uploader.upload(value.vertices, value.indices, meshlets),
+                        .material = std::move(value.material),
+                        .topology = value.topology,
+                        .transform = transform,
+                        .bounds = value.bounds,
+                        .bounding_sphere = sphere,
+                });
             }
             return result;
         }
@@ -800,7 +987,6 @@ namespace vgi::gltf {
         std::string name;
         std::shared_ptr<surface> image;
         sampler_options sampler;
-        TransferOffset transfer;
 
         texture_parser(asset_parser& asset, fastgltf::Texture& tex) :
             name(tex.name),
@@ -818,12 +1004,10 @@ namespace vgi::gltf {
             if (!image_index) image_index = tex.basisuImageIndex;
             if (!image_index) throw vgi_error{"Texure has no valid image"};
             this->image = asset.images[*image_index];
-            this->transfer = asset.template reserve<std::byte>(
-                    vgi::texture::transfer_size(asset.parent, *this->image));
         }
 
         texture upload(asset_uploader& asset) {
-            vgi::texture tex = asset.upload(this->transfer, *this->image);
+            vgi::texture tex = asset.upload(*this->image);
             if (!this->name.empty()) vmaSetAllocationName(asset.parent(), tex, this->name.c_str());
 
             return texture{
@@ -868,15 +1052,45 @@ namespace vgi::gltf {
             this->textures.push_back(tex.upload(uploader));
         }
 
+        // Static nodes are merged while their primitives can still be read from the asset
+        std::vector<bool> animated(parser.nodes.size(), false);
+        for (const animation& anim: parser.animations) {
+            for (const auto& entry: anim.nodes) animated[entry.first] = true;
+        }
+        for (gltf::scene& target: parser.scenes) {
+            batch_builder builder{
+                    .uploader = uploader,
+                    .meshes = meshes,
+                    .nodes = parser.nodes,
+                    .animated = animated,
+            };
+            for (size_t root: target.roots) builder.collect(root, glm::mat4{1.0f});
+            target.batches = builder.upload();
+        }
+
+        // Meshes whose every node has been batched are already on the device, within the
+        // batches, so only the ones drawn on their own (or not referenced at all) are uploaded
+        std::vector<bool> referenced(meshes.size(), false);
+        std::vector<bool> resident(meshes.size(), false);
+        for (const node& value: parser.nodes) {
+            if (!value.mesh) continue;
+            referenced[*value.mesh] = true;
+            if (!value.batched) resident[*value.mesh] = true;
+        }
+
         this->meshes.reserve(meshes.size());
-        for (mesh_parser& mesh: meshes) {
-            this->meshes.push_back(mesh.upload(uploader));
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            this->meshes.push_back(meshes[i].upload(uploader, resident[i] || !referenced[i]));
         }
 
         // Wait for uploads to complete
-        std::move(uploader.cmdbuf).submit_and_wait();
+        uploader.staging().wait(win);
         this->scenes = std::move(parser.scenes);
         this->nodes = std::move(parser.nodes);
+        std::vector<bool> bounded(this->nodes.size(), false);
+        for (size_t i = 0; i < this->nodes.size(); ++i) {
+            compute_bounds(this->nodes, this->meshes, i, bounded);
+        }
         this->skins = std::move(parser.skins);
         this->animations = std::move(parser.animations);
     }
@@ -1011,17 +1225,48 @@ namespace vgi::gltf {
         }
     }
 
+    uint32_t primitive::select_lod(const glm::mat4& model_view, float projection_scale,
+                                   uint32_t current, float max_error) const noexcept {
+        if (this->lods.size() <= 1 || this->bounding_sphere.empty()) return 0;
+
+        // Errors are measured in model units, so they are scaled like the bounding sphere
+        const math::sphere view = this->bounding_sphere.transform(model_view);
+        const float scale = this->bounding_sphere.radius > 0.0f
+                                    ? view.radius / this->bounding_sphere.radius
+                                    : 1.0f;
+        const float distance = glm::length(view.center) - view.radius;
+        if (!(distance > 0.0f)) return 0;
+        const float pixels = std::abs(projection_scale) * scale / distance;
+
+        uint32_t level = 0;
+        for (uint32_t i = 1; i < this->lods.size(); ++i) {
+            const float limit = i > current ? max_error * (1.0f - LOD_HYSTERESIS) : max_error;
+            if (this->lods[i].error * pixels > limit) break;
+            level = i;
+        }
+        return level;
+    }
+
     void primitive::destroy(window& parent) && {
-        std::visit([&](auto& mesh) { std::move(mesh).destroy(parent); }, this->mesh);
+        parent.geometry().free(std::exchange(this->geometry, {}));
     }
 
     void mesh::destroy(window& parent) && {
         for (primitive& primitive: this->primitives) std::move(primitive).destroy(parent);
     }
 
+    void batch::destroy(window& parent) && {
+        parent.geometry().free(std::exchange(this->geometry, {}));
+    }
+
     void texture::destroy(window& parent) && { std::move(this->texture).destroy(parent); }
 
+    void scene::destroy(window& parent) && {
+        for (batch& batch: this->batches) std::move(batch).destroy(parent);
+    }
+
     void asset::destroy(window& parent) && {
+        for (gltf::scene& scene: this->scenes) std::move(scene).destroy(parent);
         for (gltf::mesh& mesh: this->meshes) std::move(mesh).destroy(parent);
         for (gltf::texture& tex: this->textures) std::move(tex).destroy(parent);
     }
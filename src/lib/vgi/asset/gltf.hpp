@@ -7,7 +7,9 @@
 #include <unordered_map>
 #include <variant>
 #include <vgi/forward.hpp>
+#include <vgi/math/bounds.hpp>
 #include <vgi/resource/mesh.hpp>
+#include <vgi/resource/optimize.hpp>
 #include <vgi/texture.hpp>
 
 namespace vgi::gltf {
@@ -62,44 +64,92 @@ namespace vgi::gltf {
     };
 
     struct primitive {
-        /// @brief Vertex & index data stored on the device
-        std::variant<vgi::mesh<uint16_t>, vgi::mesh<uint32_t>> mesh;
+        /// @brief Vertex & index data stored on the window's geometry pool
+        /// @details Primitives on the same page of the pool share their buffers, so they can be
+        /// drawn after a single `bind`. Triangle lists are also split into meshlets, so that
+        /// static primitives can be culled with a `vgi::meshlet_culler`.
+        geometry_range geometry;
         /// @brief The material to apply to this primitive when rendering, if any
         std::shared_ptr<struct material> material;
         /// @brief The topology type of primitives to render
         vk::PrimitiveTopology topology;
+        /// @brief Bounding box of the primitive's vertices, taken from the accessor's bounds when
+        /// available
+        math::aabb bounds;
+        /// @brief Bounding sphere of the primitive's vertices
+        math::sphere bounding_sphere;
+        /// @brief Levels of detail of the primitive, from full detail to the coarsest one
+        /// @details Triangle lists are simplified on import (see `vgi::build_lods`), and other
+        /// topologies only have their full detail level. Every level shares the vertices of
+        /// `geometry`, and its indices are stored after the ones of the previous level, within
+        /// the same allocation.
+        std::vector<mesh_lod> lods;
+
+        /// @brief How much lower than the error threshold a coarser level's error must be to
+        /// switch to it, as a fraction of the threshold
+        /// @sa select_lod
+        constexpr static inline const float LOD_HYSTERESIS = 0.25f;
+
+        /// @brief Range that draws one of the primitive's levels of detail
+        /// @param level Level of detail. Only the full detail level has meshlets.
+        inline geometry_range lod(size_t level) const noexcept {
+            if (level == 0) return this->geometry;
+            VGI_ASSERT(level < this->lods.size());
+            geometry_range result = this->geometry;
+            result.first_index += this->lods[level].first_index;
+            result.index_count = this->lods[level].index_count;
+            result.meshlets = 0;
+            result.meshlet_count = 0;
+            return result;
+        }
+
+        /// @brief Picks the coarsest level of detail whose error stays below a size on screen
+        /// @details Errors are projected at the point of the bounding sphere nearest to the
+        /// camera. Switching to a coarser level than the current one requires its error to be
+        /// `LOD_HYSTERESIS` lower than the threshold, so that instances near the threshold don't
+        /// flicker between levels.
+        /// @param model_view Matrix that transforms from model to view space
+        /// @param projection_scale Size on screen, in pixels, of a unit of length one unit away
+        /// from the camera (see `vgi::math::perspective_camera::projection_scale`)
+        /// @param current Level the instance was drawn with on the previous frame
+        /// @param max_error Largest error allowed, in pixels
+        /// @return Index of the level within `lods`
+        uint32_t select_lod(const glm::mat4& model_view, float projection_scale, uint32_t current,
+                            float max_error = 1.0f) const noexcept;
 
         /// @brief Binds both the vertex and index buffers
         /// @param cmdbuf Command buffer into which the command is recorded.
-        /// @param vertex_binding Index of the vertex input binding whose state is updated by the
-        /// command
-        /// @sa vgi::mesh::bind
-        void bind(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0) const noexcept {
-            std::visit([=](const auto& mesh) { mesh.bind(cmdbuf, vertex_binding); }, this->mesh);
+        /// @param vertex_binding Index of the vertex input binding of the position stream. The
+        /// attribute stream is bound to the next one.
+        /// @param streams Vertex streams to bind
+        /// @sa vgi::geometry_range::bind
+        void bind(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0,
+                  vertex_streams streams = vertex_streams::all) const noexcept {
+            this->geometry.bind(cmdbuf, vertex_binding, streams);
         }
 
         /// @brief Draws the mesh using the bounded properties of the command buffer
         /// @param cmdbuf Command buffer into which the command is recorded.
         /// @param instance_count Number of instances to draw
-        /// @warning This method assumes that this mesh is the one currently bound. Call `bind` or
-        /// `bind_and_draw` before calling this.
-        /// @sa vgi::mesh::draw
-        void draw(vk::CommandBuffer cmdbuf, uint32_t instance_count = 1) const noexcept {
-            std::visit([=](const auto& mesh) { mesh.draw(cmdbuf, instance_count); }, this->mesh);
+        /// @param level Level of detail to draw
+        /// @warning This method assumes that the primitive's page is the one currently bound. Call
+        /// `bind` (on this or any other primitive of the page) or `bind_and_draw` before calling
+        /// this.
+        /// @sa vgi::geometry_range::draw
+        void draw(vk::CommandBuffer cmdbuf, uint32_t instance_count = 1,
+                  size_t level = 0) const noexcept {
+            this->lod(level).draw(cmdbuf, instance_count);
         }
 
         /// @brief Binds and draws the mesh.
         /// @details This is equivalent to calling `bind` and `draw` in sequence
-        /// @sa vgi::mesh::bind_and_draw
-        /// @sa vgi::mesh::bind
-        /// @sa vgi::mesh::draw
+        /// @sa vgi::geometry_range::bind_and_draw
         void bind_and_draw(vk::CommandBuffer cmdbuf, uint32_t instance_count = 1,
-                           uint32_t vertex_binding = 0) const noexcept {
-            std::visit(
-                    [=](const auto& mesh) {
-                        mesh.bind_and_draw(cmdbuf, instance_count, vertex_binding);
-                    },
-                    this->mesh);
+                           uint32_t vertex_binding = 0,
+                           vertex_streams streams = vertex_streams::all,
+                           size_t level = 0) const noexcept {
+            this->bind(cmdbuf, vertex_binding, streams);
+            this->draw(cmdbuf, instance_count, level);
         }
 
         /// @brief Destroys the resource
@@ -109,9 +159,98 @@ namespace vgi::gltf {
 
     struct mesh {
         /// @brief An array of primitives, each defining geometry to be rendered
+        /// @details Meshes that are only referenced by `node::batched` nodes are never drawn on
+        /// their own, so their primitives aren't uploaded: their `geometry` is empty and they
+        /// have no `lods`, but they keep their material, topology and bounds.
         std::vector<primitive> primitives;
+        /// @brief Whether the primitives' geometry has been uploaded to the device
+        bool resident = true;
         /// @brief The name of the mesh
         std::string name;
+        /// @brief Bounding box of all the primitives of the mesh
+        math::aabb bounds;
+        /// @brief Bounding sphere of all the primitives of the mesh
+        math::sphere bounding_sphere;
+
+        /// @brief Binds and draws every primitive of the mesh, with the same bound pipeline
+        /// @details Pages are only bound again when a primitive is stored on a different one than
+        /// the previous primitive.
+        /// @param cmdbuf Command buffer into which the commands are recorded.
+        /// @param instance_count Number of instances to draw
+        /// @param vertex_binding Index of the vertex input binding of the position stream. The
+        /// attribute stream is bound to the next one.
+        /// @param streams Vertex streams to bind
+        void bind_and_draw(vk::CommandBuffer cmdbuf, uint32_t instance_count = 1,
+                           uint32_t vertex_binding = 0,
+                           vertex_streams streams = vertex_streams::all) const noexcept {
+            const primitive* previous = nullptr;
+            for (const primitive& value: this->primitives) {
+                if (previous == nullptr || previous->geometry.page != value.geometry.page) {
+                    value.bind(cmdbuf, vertex_binding, streams);
+                }
+                value.draw(cmdbuf, instance_count);
+                previous = &value;
+            }
+        }
+
+        /// @brief Destroys the resource
+        /// @param parent Window that created the resource
+        void destroy(window& parent) &&;
+    };
+
+    /// @brief Static primitives of a scene that share their material and topology, merged into a
+    /// single range of vertices and indices
+    /// @details Primitives are merged on import, for every node that is neither skinned nor
+    /// animated (nor the descendant of an animated node), and every list topology. Their vertices
+    /// are pre-transformed to world space, so a whole batch is drawn with a single draw, and the
+    /// nodes it covers are flagged as `node::batched`.
+    ///
+    /// Positions are stored relative to the center of the batch, so that they keep the precision
+    /// of their half-float quantization. For the same reason, primitives are only merged with the
+    /// ones whose center falls within the same cell of a `CELL_SIZE` grid. Batches must be drawn
+    /// with `transform` as their model matrix.
+    struct batch {
+        /// @brief Size of the world space grid that splits batches, in world units
+        constexpr static inline const float CELL_SIZE = 64.0f;
+
+        /// @brief Vertex & index data stored on the window's geometry pool
+        /// @details Triangle lists are also split into meshlets, like the ones of a `primitive`.
+        geometry_range geometry;
+        /// @brief The material shared by every merged primitive, if any
+        std::shared_ptr<struct material> material;
+        /// @brief The topology type shared by every merged primitive
+        vk::PrimitiveTopology topology;
+        /// @brief Matrix that transforms from the batch's space to world space
+        glm::mat4 transform{1.0f};
+        /// @brief Bounding box of the batch's vertices, in world space
+        math::aabb bounds;
+        /// @brief Bounding sphere of the batch's vertices, in world space
+        math::sphere bounding_sphere;
+
+        /// @brief Binds both the vertex and index buffers
+        /// @param cmdbuf Command buffer into which the command is recorded.
+        /// @param vertex_binding Index of the vertex input binding of the position stream. The
+        /// attribute stream is bound to the next one.
+        /// @param streams Vertex streams to bind
+        /// @sa vgi::geometry_range::bind
+        void bind(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0,
+                  vertex_streams streams = vertex_streams::all) const noexcept {
+            this->geometry.bind(cmdbuf, vertex_binding, streams);
+        }
+
+        /// @brief Draws the batch using the bounded properties of the command buffer
+        /// @param cmdbuf Command buffer into which the command is recorded.
+        /// @warning This method assumes that the batch's page is the one currently bound.
+        /// @sa vgi::geometry_range::draw
+        void draw(vk::CommandBuffer cmdbuf) const noexcept { this->geometry.draw(cmdbuf, 1); }
+
+        /// @brief Binds and draws the batch.
+        /// @details This is equivalent to calling `bind` and `draw` in sequence
+        void bind_and_draw(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0,
+                           vertex_streams streams = vertex_streams::all) const noexcept {
+            this->bind(cmdbuf, vertex_binding, streams);
+            this->draw(cmdbuf);
+        }
 
         /// @brief Destroys the resource
         /// @param parent Window that created the resource
@@ -275,6 +414,20 @@ namespace vgi::gltf {
         std::vector<size_t> children;
         /// @brief The name of the node
         std::string name;
+        /// @brief Bounding box of the node's mesh and all of its descendants' meshes, in the
+        /// node's space (i.e. before applying its local transform)
+        /// @details Bounds are computed for the rest pose, so animated descendants and skinned
+        /// meshes may move outside of them.
+        math::aabb bounds;
+        /// @brief Bounding sphere of the node's mesh and all of its descendants' meshes, in the
+        /// node's space
+        /// @sa bounds
+        math::sphere bounding_sphere;
+        /// @brief Whether the node's mesh has been merged into its scene's `batches`
+        /// @details Batched meshes must be skipped when traversing the scene, since they are
+        /// already drawn by the batches. Meshes that are only referenced by batched nodes aren't
+        /// uploaded (see `mesh::resident`).
+        bool batched = false;
     };
 
     /// @brief The root nodes of a scene
@@ -283,6 +436,12 @@ namespace vgi::gltf {
         std::vector<size_t> roots;
         /// @brief The name of the scene
         std::string name;
+        /// @brief The static primitives of the scene, merged by material and topology
+        std::vector<batch> batches;
+
+        /// @brief Destroys the resource
+        /// @param parent Window that created the resource
+        void destroy(window& parent) &&;
     };
 
     struct asset {
@@ -0,0 +1,70 @@
+/*! \file */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "vulkan.hpp"
+
+namespace vgi {
+    /// @brief Categories in which the device memory allocated through a window is accounted
+    enum struct memory_category : uint8_t {
+        /// @brief Vertex, index, uniform, storage and transient buffers
+        buffer,
+        /// @brief Sampled textures
+        texture,
+        /// @brief Images that can be rendered to, such as depth textures
+        attachment,
+        /// @brief Buffers that are only used as the source of transfers
+        staging,
+    };
+
+    /// @brief Number of variants of `vgi::memory_category`
+    constexpr inline const size_t MEMORY_CATEGORY_COUNT = 4;
+
+    /// @brief Human readable name of a memory category
+    /// @param category Memory category
+    constexpr std::string_view to_string(memory_category category) noexcept {
+        switch (category) {
+            case memory_category::buffer:
+                return "buffer";
+            case memory_category::texture:
+                return "texture";
+            case memory_category::attachment:
+                return "attachment";
+            case memory_category::staging:
+                return "staging";
+        }
+        return "unknown";
+    }
+
+    /// @brief Memory allocated for a single category
+    struct memory_usage {
+        /// @brief Number of live allocations
+        size_t allocations = 0;
+        /// @brief Total size of the live allocations, in bytes
+        vk::DeviceSize bytes = 0;
+    };
+
+    /// @brief Usage and budget of a memory heap
+    struct heap_budget {
+        /// @brief Properties of the heap
+        vk::MemoryHeapFlags flags;
+        /// @brief Number of device memory blocks allocated from the heap
+        uint32_t block_count = 0;
+        /// @brief Number of allocations placed on those blocks
+        uint32_t allocation_count = 0;
+        /// @brief Number of bytes allocated in device memory blocks
+        vk::DeviceSize block_bytes = 0;
+        /// @brief Number of bytes occupied by allocations. The difference with `block_bytes` is
+        /// the memory lost to fragmentation or still free inside the blocks.
+        vk::DeviceSize allocation_bytes = 0;
+        /// @brief Estimated memory usage of the whole process on this heap, in bytes
+        vk::DeviceSize usage = 0;
+        /// @brief Estimated amount of memory available to the process on this heap, in bytes
+        /// @details Allocating beyond the budget may fail, or degrade performance when memory is
+        /// evicted to the host.
+        vk::DeviceSize budget = 0;
+    };
+}  // namespace vgi
@@ -0,0 +1,274 @@
+#include "geometry.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <tuple>
+#include <vgi/alloc.hpp>
+#include <vgi/log.hpp>
+#include <vgi/math.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    // Index buffers of a page are a quarter of the size of its vertex buffer
+    constexpr static inline const vk::DeviceSize INDEX_PAGE_RATIO = 4;
+    // Meshlet buffers of a page have room for a meshlet every this many indices, which is enough
+    // for meshlets that are at least half full
+    constexpr static inline const vk::DeviceSize MESHLET_PAGE_INDICES =
+            3 * MAX_MESHLET_TRIANGLES / 2;
+
+    // Virtual blocks are sized in elements (vertices or indices), so the offsets of their
+    // allocations are the `vertexOffset` and `firstIndex` of the ranges
+    static VmaVirtualBlock create_block(vk::DeviceSize size) {
+        const VmaVirtualBlockCreateInfo info{
+                .size = size,
+                .pAllocationCallbacks = reinterpret_cast<const VkAllocationCallbacks*>(
+                        host_callbacks(alloc_scope::vma)),
+        };
+        VmaVirtualBlock block;
+        VGI_VMA_CHECK(vmaCreateVirtualBlock(&info, &block));
+        return block;
+    }
+
+    static std::optional<std::pair<VmaVirtualAllocation, vk::DeviceSize>> try_suballocate(
+            VmaVirtualBlock block, uint32_t count) noexcept {
+        const VmaVirtualAllocationCreateInfo info{.size = count};
+        VmaVirtualAllocation allocation;
+        vk::DeviceSize offset;
+        if (vmaVirtualAllocate(block, &info, &allocation, &offset) != VK_SUCCESS) {
+            return std::nullopt;
+        }
+        return std::make_pair(allocation, offset);
+    }
+
+    geometry_range geometry_pool::allocate(const window& parent, uint32_t vertex_count,
+                                           uint32_t index_count, uint32_t meshlet_count) {
+        if (vertex_count == 0 || index_count == 0) throw vgi_error{"empty geometry range"};
+        if (vertex_count > static_cast<uint32_t>(INT32_MAX)) throw vgi_error{"too many vertices"};
+
+        for (uint32_t i = 0; i < this->pages.size(); ++i) {
+            std::optional<geometry_range> range =
+                    this->try_allocate(i, vertex_count, index_count, meshlet_count);
+            if (range) return *range;
+        }
+
+        // No page has room left, so create a new one, big enough for the range
+        std::optional<uint32_t> page_index = math::check_cast<uint32_t>(this->pages.size());
+        if (!page_index) throw vgi_error{"too many geometry pages"};
+
+        const vk::DeviceSize vertex_capacity = std::clamp<vk::DeviceSize>(
+                this->page_size / (this->position_size + this->attribute_size), vertex_count,
+                INT32_MAX);
+        const vk::DeviceSize index_capacity = std::clamp<vk::DeviceSize>(
+                this->page_size / INDEX_PAGE_RATIO / sizeof(uint32_t), index_count, UINT32_MAX);
+        const vk::DeviceSize meshlet_capacity = std::clamp<vk::DeviceSize>(
+                index_capacity / MESHLET_PAGE_INDICES, (std::max)(meshlet_count, 1u), UINT32_MAX);
+        std::optional<vk::DeviceSize> position_bytes =
+                math::check_mul<vk::DeviceSize>(vertex_capacity, this->position_size);
+        std::optional<vk::DeviceSize> attribute_bytes =
+                math::check_mul<vk::DeviceSize>(vertex_capacity, this->attribute_size);
+        if (!position_bytes || !attribute_bytes) throw vgi_error{"too many vertices"};
+
+        const auto create_page_buffer = [&](vk::DeviceSize size, vk::BufferUsageFlags usage) {
+            return parent.create_buffer(
+                    vk::BufferCreateInfo{
+                            .size = size,
+                            .usage = vk::BufferUsageFlagBits::eTransferSrc |
+                                     vk::BufferUsageFlagBits::eTransferDst | usage,
+                    },
+                    window::UPLOAD_ALLOCATION_INFO);
+        };
+
+        page new_page{};
+        try {
+            std::tie(new_page.positions, new_page.position_allocation) =
+                    create_page_buffer(*position_bytes, vk::BufferUsageFlagBits::eVertexBuffer);
+            std::tie(new_page.attributes, new_page.attribute_allocation) =
+                    create_page_buffer(*attribute_bytes, vk::BufferUsageFlagBits::eVertexBuffer);
+            std::tie(new_page.indices, new_page.index_allocation) =
+                    create_page_buffer(index_capacity * sizeof(uint32_t),
+                                       vk::BufferUsageFlagBits::eIndexBuffer);
+            // Meshlets are only read by the culling shader, through their device address
+            std::tie(new_page.meshlets, new_page.meshlet_allocation) =
+                    create_page_buffer(meshlet_capacity * sizeof(meshlet),
+                                       vk::BufferUsageFlagBits::eStorageBuffer |
+                                               vk::BufferUsageFlagBits::eShaderDeviceAddress);
+            new_page.meshlet_address = parent->getBufferAddress(
+                    vk::BufferDeviceAddressInfo{.buffer = new_page.meshlets});
+            new_page.vertex_block = create_block(vertex_capacity);
+            new_page.index_block = create_block(index_capacity);
+            new_page.meshlet_block = create_block(meshlet_capacity);
+            this->pages.push_back(new_page);
+        } catch (...) {
+            if (new_page.vertex_block) vmaDestroyVirtualBlock(new_page.vertex_block);
+            if (new_page.index_block) vmaDestroyVirtualBlock(new_page.index_block);
+            if (new_page.meshlet_block) vmaDestroyVirtualBlock(new_page.meshlet_block);
+            if (new_page.positions) {
+                parent.destroy_buffer(new_page.positions, new_page.position_allocation);
+            }
+            if (new_page.attributes) {
+                parent.destroy_buffer(new_page.attributes, new_page.attribute_allocation);
+            }
+            if (new_page.indices) {
+                parent.destroy_buffer(new_page.indices, new_page.index_allocation);
+            }
+            if (new_page.meshlets) {
+                parent.destroy_buffer(new_page.meshlets, new_page.meshlet_allocation);
+            }
+            throw;
+        }
+        vgi::log_dbg("Created geometry page {} ({} vertices, {} indices, {} meshlets)",
+                     *page_index, vertex_capacity, index_capacity, meshlet_capacity);
+
+        // The range always fits on a new page
+        std::optional<geometry_range> range =
+                this->try_allocate(*page_index, vertex_count, index_count, meshlet_count);
+        VGI_ASSERT(range.has_value());
+        return *range;
+    }
+
+    std::span<std::byte> geometry_pool::stage_positions(window& parent,
+                                                        const geometry_range& range) {
+        VGI_ASSERT(range.page < this->pages.size());
+        const page& target = this->pages[range.page];
+        const vk::DeviceSize offset = static_cast<vk::DeviceSize>(range.vertex_offset);
+        return parent.staging().stage(parent, range.vertex_count * this->position_size,
+                                      target.positions, target.position_allocation,
+                                      offset * this->position_size);
+    }
+
+    std::span<std::byte> geometry_pool::stage_attributes(window& parent,
+                                                         const geometry_range& range) {
+        VGI_ASSERT(range.page < this->pages.size());
+        const page& target = this->pages[range.page];
+        const vk::DeviceSize offset = static_cast<vk::DeviceSize>(range.vertex_offset);
+        return parent.staging().stage(parent, range.vertex_count * this->attribute_size,
+                                      target.attributes, target.attribute_allocation,
+                                      offset * this->attribute_size);
+    }
+
+    std::span<std::byte> geometry_pool::stage_indices(window& parent,
+                                                      const geometry_range& range) {
+        VGI_ASSERT(range.page < this->pages.size());
+        const page& target = this->pages[range.page];
+        return parent.staging().stage(parent, range.index_count * sizeof(uint32_t),
+                                      target.indices, target.index_allocation,
+                                      range.first_index * sizeof(uint32_t));
+    }
+
+    std::span<std::byte> geometry_pool::stage_meshlets(window& parent,
+                                                       const geometry_range& range) {
+        VGI_ASSERT(range.page < this->pages.size());
+        VGI_ASSERT(range.meshlet_allocation != VK_NULL_HANDLE);
+        const page& target = this->pages[range.page];
+        return parent.staging().stage(parent, range.meshlet_count * sizeof(meshlet),
+                                      target.meshlets, target.meshlet_allocation,
+                                      range.meshlets - target.meshlet_address);
+    }
+
+    void geometry_pool::upload(window& parent, const geometry_range& range,
+                               std::span<const std::byte> positions,
+                               std::span<const std::byte> attributes,
+                               std::span<const std::byte> indices) {
+        VGI_ASSERT(range.page < this->pages.size());
+        VGI_ASSERT(positions.size() == range.vertex_count * this->position_size);
+        VGI_ASSERT(attributes.size() == range.vertex_count * this->attribute_size);
+        VGI_ASSERT(indices.size() == range.index_count * sizeof(uint32_t));
+
+        const page& target = this->pages[range.page];
+        const vk::DeviceSize offset = static_cast<vk::DeviceSize>(range.vertex_offset);
+        staging_ring& staging = parent.staging();
+        staging.upload(parent, positions, target.positions, target.position_allocation,
+                       offset * this->position_size);
+        staging.upload(parent, attributes, target.attributes, target.attribute_allocation,
+                       offset * this->attribute_size);
+        staging.upload(parent, indices, target.indices, target.index_allocation,
+                       range.first_index * sizeof(uint32_t));
+    }
+
+    void geometry_pool::free(const geometry_range& range) noexcept {
+        if (!range) return;
+        this->retired[this->current_frame].push_back(range);
+    }
+
+    void geometry_pool::reclaim(uint32_t current_frame) noexcept {
+        VGI_ASSERT(current_frame < this->retired.size());
+        std::vector<geometry_range>& retired = this->retired[current_frame];
+        for (const geometry_range& range: retired) this->release(range);
+        retired.clear();
+        this->current_frame = current_frame;
+    }
+
+    void geometry_pool::destroy(const window& parent) && noexcept {
+        for (page& target: this->pages) {
+            // Any range still allocated is released alongside its page
+            vmaClearVirtualBlock(target.vertex_block);
+            vmaClearVirtualBlock(target.index_block);
+            vmaClearVirtualBlock(target.meshlet_block);
+            vmaDestroyVirtualBlock(target.vertex_block);
+            vmaDestroyVirtualBlock(target.index_block);
+            vmaDestroyVirtualBlock(target.meshlet_block);
+            parent.destroy_buffer(target.positions, target.position_allocation);
+            parent.destroy_buffer(target.attributes, target.attribute_allocation);
+            parent.destroy_buffer(target.indices, target.index_allocation);
+            parent.destroy_buffer(target.meshlets, target.meshlet_allocation);
+        }
+        this->pages.clear();
+        for (std::vector<geometry_range>& retired: this->retired) retired.clear();
+    }
+
+    void geometry_pool::release(const geometry_range& range) noexcept {
+        VGI_ASSERT(range.page < this->pages.size());
+        const page& target = this->pages[range.page];
+        vmaVirtualFree(target.vertex_block, range.vertex_allocation);
+        vmaVirtualFree(target.index_block, range.index_allocation);
+        if (range.meshlet_allocation != VK_NULL_HANDLE) {
+            vmaVirtualFree(target.meshlet_block, range.meshlet_allocation);
+        }
+    }
+
+    std::optional<geometry_range> geometry_pool::try_allocate(
+            uint32_t page_index, uint32_t vertex_count, uint32_t index_count,
+            uint32_t meshlet_count) const noexcept {
+        VGI_ASSERT(page_index < this->pages.size());
+        const page& target = this->pages[page_index];
+
+        auto vertices = try_suballocate(target.vertex_block, vertex_count);
+        if (!vertices) return std::nullopt;
+        auto indices = try_suballocate(target.index_block, index_count);
+        if (!indices) {
+            vmaVirtualFree(target.vertex_block, vertices->first);
+            return std::nullopt;
+        }
+
+        geometry_range range{
+                .positions = target.positions,
+                .attributes = target.attributes,
+                .indices = target.indices,
+                .page = page_index,
+                .vertex_offset = static_cast<int32_t>(vertices->second),
+                .vertex_count = vertex_count,
+                .first_index = static_cast<uint32_t>(indices->second),
+                .index_count = index_count,
+                .vertex_allocation = vertices->first,
+                .index_allocation = indices->first,
+        };
+        if (meshlet_count > 0) {
+            auto meshlets = try_suballocate(target.meshlet_block, meshlet_count);
+            if (!meshlets) {
+                vmaVirtualFree(target.vertex_block, vertices->first);
+                vmaVirtualFree(target.index_block, indices->first);
+                return std::nullopt;
+            }
+            range.meshlets = target.meshlet_address + meshlets->second * sizeof(meshlet);
+            range.meshlet_count = meshlet_count;
+            range.meshlet_allocation = meshlets->first;
+        }
+        return range;
+    }
+
+    uint32_t geometry_pool::checked_count(size_t count) {
+        std::optional<uint32_t> result = math::check_cast<uint32_t>(count);
+        if (!result) throw vgi_error{"too many elements for a geometry range"};
+        return *result;
+    }
+}  // namespace vgi
@@ -0,0 +1,268 @@
+/*! \file */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+#include <vgi/defs.hpp>
+#include <vgi/forward.hpp>
+#include <vgi/pipeline/vertex_input.hpp>
+#include <vgi/resource/meshlet.hpp>
+#include <vgi/vgi.hpp>
+#include <vgi/vulkan.hpp>
+
+namespace vgi {
+    /// @brief A range of vertices and indices sub-allocated from a `vgi::geometry_pool`
+    /// @details Ranges are plain values, which are released with `geometry_pool::free`. All the
+    /// ranges of the same page share their buffers, so they can be drawn one after the other with
+    /// a single `bind`.
+    struct geometry_range {
+        /// @brief Position stream of the page that contains the range
+        vk::Buffer positions;
+        /// @brief Attribute stream of the page that contains the range
+        vk::Buffer attributes;
+        /// @brief Index buffer of the page that contains the range
+        vk::Buffer indices;
+        /// @brief Index of the page that contains the range
+        uint32_t page = 0;
+        /// @brief Index of the first vertex of the range, within the page's vertex streams
+        int32_t vertex_offset = 0;
+        /// @brief Number of vertices of the range
+        uint32_t vertex_count = 0;
+        /// @brief Index of the first index of the range, within the page's index buffer
+        uint32_t first_index = 0;
+        /// @brief Number of indices of the range
+        uint32_t index_count = 0;
+        /// @brief Device address of the range's first meshlet, if it has any
+        vk::DeviceAddress meshlets = 0;
+        /// @brief Number of meshlets of the range
+        uint32_t meshlet_count = 0;
+        //! @cond Doxygen_Suppress
+        VmaVirtualAllocation vertex_allocation = VK_NULL_HANDLE;
+        VmaVirtualAllocation index_allocation = VK_NULL_HANDLE;
+        VmaVirtualAllocation meshlet_allocation = VK_NULL_HANDLE;
+        //! @endcond
+
+        /// @brief Binds the vertex and index buffers of the range's page
+        /// @param cmdbuf Command buffer into which the command is recorded.
+        /// @param vertex_binding Index of the vertex input binding of the position stream. The
+        /// attribute stream is bound to the next one.
+        /// @param streams Vertex streams to bind
+        inline void bind(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0,
+                         vertex_streams streams = vertex_streams::all) const noexcept {
+            const vk::Buffer buffers[] = {this->positions, this->attributes};
+            constexpr vk::DeviceSize offsets[] = {0, 0};
+            cmdbuf.bindVertexBuffers(vertex_binding, streams == vertex_streams::all ? 2 : 1,
+                                     buffers, offsets);
+            cmdbuf.bindIndexBuffer(this->indices, 0, vk::IndexType::eUint32);
+        }
+
+        /// @brief Draws the range using the bounded properties of the command buffer
+        /// @param cmdbuf Command buffer into which the command is recorded.
+        /// @param instance_count Number of instances to draw
+        /// @param first_instance Instance ID of the first instance to draw
+        /// @warning This method assumes that the range's page is the one currently bound.
+        inline void draw(vk::CommandBuffer cmdbuf, uint32_t instance_count = 1,
+                         uint32_t first_instance = 0) const noexcept {
+            cmdbuf.drawIndexed(this->index_count, instance_count, this->first_index,
+                               this->vertex_offset, first_instance);
+        }
+
+        /// @brief Binds the range's page and draws the range.
+        /// @details This is equivalent to calling `bind` and `draw` in sequence
+        inline void bind_and_draw(vk::CommandBuffer cmdbuf, uint32_t instance_count = 1,
+                                  uint32_t vertex_binding = 0,
+                                  vertex_streams streams = vertex_streams::all) const noexcept {
+            this->bind(cmdbuf, vertex_binding, streams);
+            this->draw(cmdbuf, instance_count);
+        }
+
+        /// @brief Parameters to draw the range with an indirect draw command
+        /// @param instance_count Number of instances to draw
+        /// @param first_instance Instance ID of the first instance to draw
+        constexpr vk::DrawIndexedIndirectCommand indirect(
+                uint32_t instance_count = 1, uint32_t first_instance = 0) const noexcept {
+            return vk::DrawIndexedIndirectCommand{
+                    .indexCount = this->index_count,
+                    .instanceCount = instance_count,
+                    .firstIndex = this->first_index,
+                    .vertexOffset = this->vertex_offset,
+                    .firstInstance = first_instance,
+            };
+        }
+
+        /// @brief Checks whether the range has been allocated
+        constexpr explicit operator bool() const noexcept {
+            return this->vertex_allocation != VK_NULL_HANDLE;
+        }
+    };
+
+    /// @brief Shared device storage for the vertices and indices of many meshes
+    /// @details The pool is made of a few large pages, each with a buffer for every vertex stream
+    /// (positions and attributes), a 32-bit index buffer and a meshlet buffer (see
+    /// `vgi::meshlet_culler`), which are sub-allocated with VMA's virtual blocks. Meshes only
+    /// hold a `vgi::geometry_range`, so all the meshes of a page can be drawn with a single bind,
+    /// using their `first_index` and `vertex_offset`.
+    ///
+    /// Released ranges are only reused once the device has finished with every frame that may
+    /// reference them.
+    class geometry_pool {
+    public:
+        /// @brief Default constructor
+        geometry_pool() = default;
+
+        /// @brief Creates a new pool. Pages are only created once they are needed.
+        /// @param position_stride Size of every element of the position stream, in bytes
+        /// @param attribute_stride Size of every element of the attribute stream, in bytes
+        /// @param page_size Size of the vertex streams of every page, in bytes. Index buffers are a
+        /// quarter of that size. Ranges that don't fit on a page get a page of their own.
+        geometry_pool(vk::DeviceSize position_stride, vk::DeviceSize attribute_stride,
+                      vk::DeviceSize page_size) noexcept :
+            position_size(position_stride), attribute_size(attribute_stride),
+            page_size(page_size) {
+            VGI_ASSERT(position_stride > 0 && attribute_stride > 0);
+        }
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        geometry_pool(geometry_pool&& other) noexcept :
+            pages(std::move(other.pages)), retired(std::move(other.retired)),
+            position_size(other.position_size), attribute_size(other.attribute_size),
+            page_size(other.page_size), current_frame(other.current_frame) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        geometry_pool& operator=(geometry_pool&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Size of every element of the position stream, in bytes
+        constexpr vk::DeviceSize position_stride() const noexcept { return this->position_size; }
+        /// @brief Size of every element of the attribute stream, in bytes
+        constexpr vk::DeviceSize attribute_stride() const noexcept { return this->attribute_size; }
+        /// @brief Number of pages created by the pool
+        inline size_t page_count() const noexcept { return this->pages.size(); }
+
+        /// @brief Sub-allocates a range of vertices and indices, creating a new page if needed
+        /// @param parent Window that owns the pool
+        /// @param vertex_count Number of vertices of the range
+        /// @param index_count Number of indices of the range
+        /// @param meshlet_count Number of meshlets of the range
+        geometry_range allocate(const window& parent, uint32_t vertex_count, uint32_t index_count,
+                                uint32_t meshlet_count = 0);
+
+        /// @brief Memory where the position stream of a range must be written
+        /// @param parent Window that owns the pool
+        /// @param range Range to be written
+        /// @return Region of `range.vertex_count * position_stride()` bytes
+        /// @warning The region must be written before registering another upload
+        /// @sa vgi::staging_ring::stage
+        std::span<std::byte> stage_positions(window& parent, const geometry_range& range);
+
+        /// @brief Memory where the attribute stream of a range must be written
+        /// @param parent Window that owns the pool
+        /// @param range Range to be written
+        /// @return Region of `range.vertex_count * attribute_stride()` bytes
+        /// @warning The region must be written before registering another upload
+        /// @sa vgi::staging_ring::stage
+        std::span<std::byte> stage_attributes(window& parent, const geometry_range& range);
+
+        /// @brief Memory where the indices of a range must be written
+        /// @param parent Window that owns the pool
+        /// @param range Range to be written
+        /// @return Region of `range.index_count` 32-bit indices, relative to the range's first
+        /// vertex
+        /// @warning The region must be written before registering another upload
+        /// @sa vgi::staging_ring::stage
+        std::span<std::byte> stage_indices(window& parent, const geometry_range& range);
+
+        /// @brief Memory where the meshlets of a range must be written
+        /// @param parent Window that owns the pool
+        /// @param range Range to be written. Must have been allocated with some meshlets.
+        /// @return Region of `range.meshlet_count` meshlets, whose indices are relative to the
+        /// range's first index
+        /// @warning The region must be written before registering another upload
+        /// @sa vgi::staging_ring::stage
+        std::span<std::byte> stage_meshlets(window& parent, const geometry_range& range);
+
+        /// @brief Sub-allocates a range and uploads its data through the window's staging ring
+        /// @tparam P Position type. Must be `position_stride()` bytes long.
+        /// @tparam A Attribute type. Must be `attribute_stride()` bytes long.
+        /// @param parent Window that owns the pool
+        /// @param positions Position stream of the range
+        /// @param attributes Attribute stream of the range. Must be as long as `positions`.
+        /// @param indices Indices of the range, relative to its first vertex
+        template<class P, class A>
+        geometry_range upload(window& parent, std::span<const P> positions,
+                              std::span<const A> attributes, std::span<const uint32_t> indices) {
+            VGI_ASSERT(sizeof(P) == this->position_size && sizeof(A) == this->attribute_size);
+            VGI_ASSERT(positions.size() == attributes.size());
+            geometry_range range = this->allocate(parent, checked_count(positions.size()),
+                                                  checked_count(indices.size()));
+            try {
+                this->upload(parent, range, std::as_bytes(positions), std::as_bytes(attributes),
+                             std::as_bytes(indices));
+            } catch (...) {
+                this->free(range);
+                throw;
+            }
+            return range;
+        }
+
+        /// @brief Releases a range once the device has finished with the frames that may use it
+        /// @param range Range to be released. Ranges must only be released once.
+        void free(const geometry_range& range) noexcept;
+
+        /// @brief Releases the ranges freed the last time a frame was recorded
+        /// @param current_frame Index of the frame. The device must have finished its previous use.
+        void reclaim(uint32_t current_frame) noexcept;
+
+        /// @brief Destroys the pool, with every range still allocated from it
+        /// @param parent Window that owns the pool
+        /// @warning The device must be idle
+        void destroy(const window& parent) && noexcept;
+
+        geometry_pool(const geometry_pool&) = delete;
+        geometry_pool& operator=(const geometry_pool&) = delete;
+
+    private:
+        struct page {
+            vk::Buffer positions;
+            VmaAllocation position_allocation;
+            vk::Buffer attributes;
+            VmaAllocation attribute_allocation;
+            VmaVirtualBlock vertex_block;
+            vk::Buffer indices;
+            VmaAllocation index_allocation;
+            VmaVirtualBlock index_block;
+            vk::Buffer meshlets;
+            VmaAllocation meshlet_allocation;
+            VmaVirtualBlock meshlet_block;
+            vk::DeviceAddress meshlet_address;
+        };
+
+        std::vector<page> pages;
+        std::array<std::vector<geometry_range>, VGI_MAX_FRAMES_IN_FLIGHT> retired;
+        vk::DeviceSize position_size = 1;
+        vk::DeviceSize attribute_size = 1;
+        vk::DeviceSize page_size = 0;
+        uint32_t current_frame = 0;
+
+        void upload(window& parent, const geometry_range& range,
+                    std::span<const std::byte> positions, std::span<const std::byte> attributes,
+                    std::span<const std::byte> indices);
+        std::optional<geometry_range> try_allocate(uint32_t page_index, uint32_t vertex_count,
+                                                   uint32_t index_count,
+                                                   uint32_t meshlet_count) const noexcept;
+        void release(const geometry_range& range) noexcept;
+        static uint32_t checked_count(size_t count);
+    };
+}  // namespace vgi
@@ -50,16 +50,14 @@ namespace vgi {
                     math::check_mul<vk::DeviceSize>(sizeof(T), size);
             if (!byte_size) throw vgi_error{"too many indices"};
 
-            auto [buffer, allocation] = parent.create_buffer(
+            auto [buffer, allocation] = parent.create_relocatable_buffer(
                     vk::BufferCreateInfo{
                             .size = byte_size.value(),
                             .usage = vk::BufferUsageFlagBits::eTransferSrc |
                                      vk::BufferUsageFlagBits::eTransferDst |
                                      vk::BufferUsageFlagBits::eIndexBuffer,
                     },
-                    VmaAllocationCreateInfo{
-                            .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                    });
+                    window::UPLOAD_ALLOCATION_INFO);
 
             this->buffer = buffer;
             this->allocation = allocation;
@@ -71,7 +69,7 @@ namespace vgi {
         /// @brief Move constructor operator
         /// @param other Value to be moved
         inline index_buffer(index_buffer&& other) noexcept :
-            buffer(std::move(other.buffer)),
+            buffer(std::exchange(other.buffer, nullptr)),
             allocation(std::exchange(other.allocation, VK_NULL_HANDLE)) {}
 
         /// @brief Move assignment operator
@@ -90,24 +88,31 @@ namespace vgi {
         /// calculations.
         inline void bind(vk::CommandBuffer cmdbuf, vk::DeviceSize offset = 0) const noexcept {
             VGI_ASSERT(offset <= MAX_SIZE);
-            cmdbuf.bindIndexBuffer(this->buffer, offset * sizeof(T), index_traits<T>::type);
+            cmdbuf.bindIndexBuffer(*this->buffer, offset * sizeof(T), index_traits<T>::type);
         }
 
         /// @brief Destroys the buffer
         /// @param parent Window used to create the buffer
         inline void destroy(const window& parent) && {
-            vmaDestroyBuffer(parent, this->buffer, this->allocation);
+            if (this->buffer) parent.destroy_buffer(*this->buffer, this->allocation);
         }
 
         /// @brief Casts to the underlying `vk::Buffer`
-        constexpr operator vk::Buffer() const noexcept { return this->buffer; }
+        /// @details Buffers may be replaced by defragmentation, so the result must not be cached
+        /// across frames.
+        constexpr operator vk::Buffer() const noexcept {
+            return this->buffer ? *this->buffer : vk::Buffer{};
+        }
         /// @brief Casts to the underlying `VkBuffer`
-        inline operator VkBuffer() const noexcept { return this->buffer; }
+        inline operator VkBuffer() const noexcept {
+            return this->buffer ? static_cast<VkBuffer>(*this->buffer) : VK_NULL_HANDLE;
+        }
         /// @brief Casts to the underlying `VmaAllocation`
         constexpr operator VmaAllocation() const noexcept { return this->allocation; }
 
     private:
-        vk::Buffer buffer;
+        // Owned by the window, which replaces it when defragmentation moves the buffer
+        const vk::Buffer* buffer = nullptr;
         VmaAllocation allocation = VK_NULL_HANDLE;
     };
 
@@ -0,0 +1,16 @@
+#include "instance.hpp"
+
+#include <optional>
+#include <vgi/math.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    uint32_t bind_instances(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                            std::span<const instance> instances, uint32_t binding) {
+        std::optional<uint32_t> count = math::check_cast<uint32_t>(instances.size());
+        if (!count) throw vgi_error{"too many instances"};
+
+        parent.transient().push(current_frame, instances).bind_vertices(cmdbuf, binding);
+        return *count;
+    }
+}  // namespace vgi
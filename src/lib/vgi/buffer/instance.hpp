@@ -0,0 +1,140 @@
+/*! \file */
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <span>
+#include <vgi/buffer/vertex.hpp>
+#include <vgi/pipeline/vertex_input.hpp>
+#include <vgi/vulkan.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    /// @brief Per-instance data of instanced draws, fetched at `vk::VertexInputRate::eInstance`
+    /// @details Its locations follow those of `vgi::vertex_attributes`, so that instanced
+    /// pipelines can fetch both vertex streams and the instance stream at once (see
+    /// `instanced_vertex_input`). Shaders read the transform as a `mat4` input, which takes up
+    /// four consecutive locations:
+    ///
+    /// ```glsl
+    /// layout (location = 6) in mat4 inTransform;
+    /// layout (location = 10) in vec4 inInstanceColor;
+    /// ```
+    struct instance {
+        /// @brief Shader input location of the first column of `transform`. The remaining columns
+        /// are on the next three locations.
+        constexpr static inline const uint32_t TRANSFORM = 6;
+        /// @brief Shader input location of `color`
+        constexpr static inline const uint32_t COLOR = TRANSFORM + 4;
+
+        /// @brief Model matrix of the instance
+        glm::mat4 transform{1.0f};
+        /// @brief RGBA color of the instance, as unsigned normalized 8-bit integers
+        glm::u8vec4 color{UINT8_MAX};
+
+        /// @brief Default constructor. Creates a white instance at the origin.
+        instance() = default;
+
+        /// @brief Creates a new instance, quantizing its color
+        /// @param transform Model matrix
+        /// @param color RGBA color
+        inline instance(const glm::mat4& transform,
+                        const glm::vec4& color = glm::vec4{1.0f}) noexcept :
+            transform(transform), color(vertex::pack_color(color)) {}
+
+        /// @brief Layout of the stream's attributes
+        /// @sa vgi::vertex_layout
+        constexpr static std::array<vertex_attribute, 5> attributes() noexcept {
+            return {{
+                    {
+                            .location = TRANSFORM,
+                            .format = vk::Format::eR32G32B32A32Sfloat,
+                            .offset = offsetof(instance, transform),
+                    },
+                    {
+                            .location = TRANSFORM + 1,
+                            .format = vk::Format::eR32G32B32A32Sfloat,
+                            .offset = offsetof(instance, transform) + sizeof(glm::vec4),
+                    },
+                    {
+                            .location = TRANSFORM + 2,
+                            .format = vk::Format::eR32G32B32A32Sfloat,
+                            .offset = offsetof(instance, transform) + 2 * sizeof(glm::vec4),
+                    },
+                    {
+                            .location = TRANSFORM + 3,
+                            .format = vk::Format::eR32G32B32A32Sfloat,
+                            .offset = offsetof(instance, transform) + 3 * sizeof(glm::vec4),
+                    },
+                    {
+                            .location = COLOR,
+                            .format = vk::Format::eR8G8B8A8Unorm,
+                            .offset = offsetof(instance, color),
+                    },
+            }};
+        }
+    };
+    static_assert(sizeof(instance) == 68);
+    static_assert(vertex_layout<instance>);
+    static_assert(instance::TRANSFORM > vertex_attributes::WEIGHTS);
+
+    /// @brief Vertex input of instanced pipelines, with the vertex streams on `binding` and
+    /// `binding + 1`, and the instance stream on `binding + 2`
+    /// @param binding Binding the positions are fetched from
+    constexpr vertex_input instanced_vertex_input(uint32_t binding = 0) noexcept {
+        return split_vertex_input(binding).with<instance>(binding + 2,
+                                                          vk::VertexInputRate::eInstance);
+    }
+
+    /// @brief A buffer used to store instances that persist across frames
+    /// @details Its contents may be uploaded with `vgi::staging_ring::upload`, and it's bound
+    /// like any other vertex buffer.
+    using instance_buffer = basic_vertex_buffer<instance>;
+    /// @brief A guard that destroys the instance buffer when dropped.
+    using instance_buffer_guard = vertex_buffer_guard<instance>;
+
+    /// @brief A mesh that can be drawn many times with a single call
+    template<class M>
+    concept instanced_drawable =
+            requires(const M& mesh, vk::CommandBuffer cmdbuf, uint32_t count, uint32_t binding) {
+                mesh.bind_and_draw(cmdbuf, count, binding);
+            };
+
+    /// @brief Copies instances into the frame's transient buffer, and binds them
+    /// @param parent Window whose transient buffer stores the instances
+    /// @param cmdbuf Command buffer into which the command is recorded
+    /// @param current_frame Index of the current frame
+    /// @param instances Instances to be bound
+    /// @param binding Index of the vertex input binding of the instance stream
+    /// @return Number of instances bound
+    /// @throws `vgi::vgi_error` if the frame's transient buffer runs out of memory
+    uint32_t bind_instances(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                            std::span<const instance> instances, uint32_t binding = 2);
+
+    /// @brief Draws a copy of a mesh for every instance, with a single draw per primitive
+    /// @details The bound pipeline must fetch the instance stream (i.e. with
+    /// `instanced_vertex_input`). Instances only live for the current frame, so meshes whose
+    /// instances don't change should bind an `instance_buffer` and draw it instead.
+    /// @tparam M Mesh type (i.e. `vgi::mesh`, `vgi::geometry_range` or `vgi::gltf::mesh`)
+    /// @param parent Window whose transient buffer stores the instances
+    /// @param cmdbuf Command buffer into which the commands are recorded
+    /// @param current_frame Index of the current frame
+    /// @param mesh Mesh to be drawn
+    /// @param instances Instances to be drawn
+    /// @param vertex_binding Index of the vertex input binding of the position stream. The
+    /// attribute and instance streams are bound to the next two.
+    /// @throws `vgi::vgi_error` if the frame's transient buffer runs out of memory
+    template<instanced_drawable M>
+    void draw_instances(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                        const M& mesh, std::span<const instance> instances,
+                        uint32_t vertex_binding = 0) {
+        if (instances.empty()) return;
+        const uint32_t count =
+                bind_instances(parent, cmdbuf, current_frame, instances, vertex_binding + 2);
+        mesh.bind_and_draw(cmdbuf, count, vertex_binding);
+    }
+}  // namespace vgi
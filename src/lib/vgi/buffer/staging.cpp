@@ -0,0 +1,388 @@
+#include "staging.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <tuple>
+#include <vgi/buffer/transfer.hpp>
+#include <vgi/math.hpp>
+#include <vgi/vgi.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    staging_ring::staging_ring(const window& parent, vk::DeviceSize byte_size) {
+        // Regions must be usable as the source of image copies, and every region must be flushable
+        // independently of its neighbours.
+        const vk::PhysicalDeviceLimits& limits = parent.device().props().limits;
+        this->alignment = std::max({limits.optimalBufferCopyOffsetAlignment,
+                                    limits.nonCoherentAtomSize, vk::DeviceSize{16}});
+
+        std::optional<vk::DeviceSize> aligned_size =
+                math::next_multiple_of<vk::DeviceSize>(byte_size, this->alignment);
+        if (!aligned_size) throw vgi_error{"staging ring is too large"};
+
+        VmaAllocationInfo info;
+        auto [buffer, allocation] = parent.create_buffer(
+                vk::BufferCreateInfo{
+                        .size = aligned_size.value(),
+                        .usage = vk::BufferUsageFlagBits::eTransferSrc,
+                },
+                VmaAllocationCreateInfo{
+                        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
+                                 VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                        .usage = VMA_MEMORY_USAGE_AUTO,
+                },
+                &info);
+
+        VkMemoryPropertyFlags mem_flags;
+        vmaGetAllocationMemoryProperties(parent, allocation, &mem_flags);
+
+        VGI_ASSERT(info.pMappedData != nullptr);
+        this->buffer = buffer;
+        this->allocation = allocation;
+        this->mapped = static_cast<std::byte*>(info.pMappedData);
+        this->size = aligned_size.value();
+        this->coherent = (mem_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+        const vk::SemaphoreTypeCreateInfo type_info{
+                .semaphoreType = vk::SemaphoreType::eTimeline,
+                .initialValue = 0,
+        };
+        this->timeline = parent->createSemaphore(vk::SemaphoreCreateInfo{.pNext = &type_info});
+    }
+
+    vk::CommandBuffer staging_ring::record(window& parent) {
+        if (this->pending.cmdbuf) return this->pending.cmdbuf;
+
+        if (!this->free_cmdbufs.empty()) {
+            this->pending.cmdbuf = this->free_cmdbufs.back();
+            this->free_cmdbufs.pop_back();
+        } else {
+            vkn::allocateCommandBuffers(
+                    parent,
+                    vk::CommandBufferAllocateInfo{.commandPool = parent.cmdpool,
+                                                  .level = vk::CommandBufferLevel::ePrimary,
+                                                  .commandBufferCount = 1},
+                    &this->pending.cmdbuf);
+        }
+
+        this->pending.cmdbuf.begin(vk::CommandBufferBeginInfo{
+                .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+        return this->pending.cmdbuf;
+    }
+
+    transfer_buffer staging_ring::allocate(window& parent, vk::DeviceSize byte_size,
+                                           vk::DeviceSize alignment) {
+        VGI_ASSERT(alignment > 0);
+
+        // Regions that would never fit inside the ring get their own buffer
+        if (byte_size > this->size) {
+            this->record(parent);
+            VmaAllocationInfo info;
+            auto [buffer, allocation] = parent.create_buffer(
+                    vk::BufferCreateInfo{
+                            .size = byte_size,
+                            .usage = vk::BufferUsageFlagBits::eTransferSrc,
+                    },
+                    VmaAllocationCreateInfo{
+                            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
+                                     VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                            .usage = VMA_MEMORY_USAGE_AUTO,
+                    },
+                    &info);
+
+            VGI_ASSERT(info.pMappedData != nullptr);
+            this->pending.dedicated.emplace_back(buffer, allocation);
+            return transfer_buffer{
+                    buffer, 0,
+                    std::span<std::byte>{static_cast<std::byte*>(info.pMappedData), byte_size}};
+        }
+
+        while (true) {
+            this->reclaim(parent);
+            if (std::optional<vk::DeviceSize> offset = this->try_reserve(byte_size, alignment)) {
+                this->record(parent);
+                return transfer_buffer{this->buffer, *offset,
+                                       std::span<std::byte>{this->mapped + *offset, byte_size}};
+            }
+
+            // Out of memory, so submit whatever is pending and wait for the device to release
+            // the oldest regions.
+            if (this->pending.cmdbuf) {
+                this->submit(parent);
+            } else if (!this->wait_oldest(parent)) [[unlikely]] {
+                throw vgi_error{"staging ring is out of memory"};
+            }
+        }
+    }
+
+    void staging_ring::upload(window& parent, std::span<const std::byte> src, vk::Buffer dst,
+                              vk::DeviceSize dst_offset) {
+        // Chunks are kept smaller than the ring, so that the device can consume one chunk while
+        // the next one is being written.
+        const vk::DeviceSize chunk_size = (std::max)(this->size / 2, this->alignment);
+        while (!src.empty()) {
+            const size_t byte_size = static_cast<size_t>((std::min)(
+                    static_cast<vk::DeviceSize>(src.size()), chunk_size));
+            transfer_buffer region = this->allocate(parent, byte_size);
+            std::memcpy(region->data(), src.data(), byte_size);
+            this->copy(region, dst, dst_offset);
+
+            src = src.subspan(byte_size);
+            dst_offset += byte_size;
+        }
+    }
+
+    std::span<std::byte> staging_ring::stage(window& parent, vk::DeviceSize byte_size,
+                                             vk::Buffer dst, VmaAllocation dst_allocation,
+                                             vk::DeviceSize dst_offset) {
+        if (std::byte* direct =
+                    this->write_directly(parent, dst_allocation, dst_offset, byte_size)) {
+            return std::span<std::byte>{direct, static_cast<size_t>(byte_size)};
+        }
+
+        transfer_buffer region = this->allocate(parent, byte_size);
+        this->copy(region, dst, dst_offset);
+        return region;
+    }
+
+    void staging_ring::upload(window& parent, std::span<const std::byte> src, vk::Buffer dst,
+                              VmaAllocation dst_allocation, vk::DeviceSize dst_offset) {
+        if (std::byte* direct =
+                    this->write_directly(parent, dst_allocation, dst_offset, src.size_bytes())) {
+            std::memcpy(direct, src.data(), src.size_bytes());
+        } else {
+            this->upload(parent, src, dst, dst_offset);
+        }
+    }
+
+    void staging_ring::copy(const transfer_buffer& src, vk::Buffer dst,
+                            vk::DeviceSize dst_offset) {
+        const std::span<std::byte> bytes = src;
+        if (bytes.empty()) return;
+        this->copies.push_back(queued_copy{
+                .src = src,
+                .dst = dst,
+                .region = vk::BufferCopy{.srcOffset = src.buffer_offset(),
+                                         .dstOffset = dst_offset,
+                                         .size = bytes.size()},
+        });
+    }
+
+    void staging_ring::submit(window& parent) {
+        vk::CommandBufferSubmitInfo cmdbuf_info;
+        vk::SemaphoreSubmitInfo signal_info;
+        if (!this->prepare(parent, cmdbuf_info, signal_info)) return;
+
+        parent.queue.submit2(vk::SubmitInfo2{
+                .commandBufferInfoCount = 1,
+                .pCommandBufferInfos = &cmdbuf_info,
+                .signalSemaphoreInfoCount = 1,
+                .pSignalSemaphoreInfos = &signal_info,
+        });
+    }
+
+    void staging_ring::reclaim(const window& parent) {
+        if (this->in_flight.empty()) return;
+        const uint64_t completed = parent->getSemaphoreCounterValue(this->timeline);
+        while (!this->in_flight.empty() && this->in_flight.front().value <= completed) {
+            this->release(parent, this->in_flight.front());
+            this->in_flight.pop_front();
+        }
+    }
+
+    void staging_ring::wait(window& parent) {
+        this->submit(parent);
+        while (this->wait_oldest(parent)) {
+        }
+    }
+
+    void staging_ring::destroy(const window& parent) && noexcept {
+        const auto destroy_batch = [&](batch& b) {
+            for (const auto& [buffer, allocation]: b.dedicated) {
+                parent.destroy_buffer(buffer, allocation);
+            }
+            if (b.cmdbuf) parent->freeCommandBuffers(parent.cmdpool, b.cmdbuf);
+        };
+
+        destroy_batch(this->pending);
+        for (batch& b: this->in_flight) destroy_batch(b);
+        if (!this->free_cmdbufs.empty()) {
+            parent->freeCommandBuffers(parent.cmdpool, this->free_cmdbufs);
+        }
+        if (this->timeline) parent->destroySemaphore(this->timeline);
+        parent.destroy_buffer(this->buffer, this->allocation);
+    }
+
+    std::optional<vk::DeviceSize> staging_ring::try_reserve(vk::DeviceSize byte_size,
+                                                            vk::DeviceSize alignment) noexcept {
+        // `head == tail` only happens when the ring is empty, so we may start over from the
+        // beginning to avoid wrapping around.
+        const bool empty = this->head == this->tail;
+        if (empty) this->head = this->tail = 0;
+
+        const vk::DeviceSize align = std::lcm(this->alignment, alignment);
+        std::optional<vk::DeviceSize> start =
+                math::next_multiple_of<vk::DeviceSize>(this->head, align);
+        std::optional<vk::DeviceSize> end;
+        if (start) end = math::check_add<vk::DeviceSize>(*start, byte_size);
+
+        // The head may never reach the tail unless the ring is empty, otherwise a full ring would
+        // be indistinguishable from an empty one.
+        vk::DeviceSize offset;
+        if (this->head >= this->tail) {
+            if (end && (*end < this->size || (*end == this->size && (empty || this->tail > 0)))) {
+                offset = *start;
+            } else if (byte_size < this->tail) {
+                offset = 0;
+            } else {
+                return std::nullopt;
+            }
+        } else if (end && *end < this->tail) {
+            offset = *start;
+        } else {
+            return std::nullopt;
+        }
+
+        this->head = offset + byte_size;
+        if (!this->pending.begin) this->pending.begin = offset;
+        this->pending.end = this->head;
+        return offset;
+    }
+
+    std::byte* staging_ring::write_directly(window& parent, VmaAllocation allocation,
+                                            vk::DeviceSize offset, vk::DeviceSize byte_size) {
+        // Only persistently mapped allocations are written to directly, since those are the ones
+        // that were placed on host-visible memory when asked to.
+        VmaAllocationInfo info;
+        vmaGetAllocationInfo(parent, allocation, &info);
+        if (info.pMappedData == nullptr) return nullptr;
+        VGI_ASSERT(offset <= info.size && byte_size <= info.size - offset);
+
+        // Make sure there is a pending batch, so that the write is flushed when it is submitted
+        this->record(parent);
+        this->direct_writes.push_back(
+                direct_write{.allocation = allocation, .offset = offset, .size = byte_size});
+        return static_cast<std::byte*>(info.pMappedData) + offset;
+    }
+
+    bool staging_ring::wait_oldest(const window& parent) {
+        if (this->in_flight.empty()) return false;
+        while (true) {
+            switch (parent->waitSemaphores(
+                    vk::SemaphoreWaitInfo{
+                            .semaphoreCount = 1,
+                            .pSemaphores = &this->timeline,
+                            .pValues = &this->in_flight.front().value,
+                    },
+                    UINT64_MAX)) {
+                case vk::Result::eSuccess:
+                    this->release(parent, this->in_flight.front());
+                    this->in_flight.pop_front();
+                    return true;
+                case vk::Result::eTimeout:
+                    [[unlikely]] continue;
+                default:
+                    VGI_UNREACHABLE;
+                    break;
+            }
+        }
+    }
+
+    void staging_ring::release(const window& parent, batch& b) {
+        if (b.begin) this->tail = b.end;
+        for (const auto& [buffer, allocation]: b.dedicated) {
+            parent.destroy_buffer(buffer, allocation);
+        }
+
+        // Keep the command buffer around for future batches
+        b.cmdbuf.reset();
+        this->free_cmdbufs.push_back(b.cmdbuf);
+    }
+
+    bool staging_ring::prepare(const window& parent, vk::CommandBufferSubmitInfo& cmdbuf_info,
+                               vk::SemaphoreSubmitInfo& signal_info) {
+        if (!this->pending.cmdbuf) return false;
+
+        // Group the queued copies by source and destination, merging the contiguous ones, so
+        // that each pair of buffers is copied with a single command.
+        std::ranges::stable_sort(this->copies, {}, [](const queued_copy& c) {
+            return std::make_tuple(static_cast<VkBuffer>(c.src), static_cast<VkBuffer>(c.dst),
+                                   c.region.dstOffset);
+        });
+
+        std::vector<vk::BufferCopy> regions;
+        for (size_t i = 0; i < this->copies.size();) {
+            const vk::Buffer src = this->copies[i].src;
+            const vk::Buffer dst = this->copies[i].dst;
+            regions.clear();
+            for (; i < this->copies.size() && this->copies[i].src == src &&
+                   this->copies[i].dst == dst;
+                 ++i) {
+                const vk::BufferCopy& region = this->copies[i].region;
+                if (!regions.empty() &&
+                    regions.back().srcOffset + regions.back().size == region.srcOffset &&
+                    regions.back().dstOffset + regions.back().size == region.dstOffset) {
+                    regions.back().size += region.size;
+                } else {
+                    regions.push_back(region);
+                }
+            }
+            this->pending.cmdbuf.copyBuffer(src, dst, regions);
+        }
+        this->copies.clear();
+
+        this->pending.cmdbuf.pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {},
+                vk::MemoryBarrier{
+                        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                        .dstAccessMask =
+                                vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+                },
+                {}, {});
+        this->pending.cmdbuf.end();
+
+        // Make the host writes of the batch visible to the device with a single call. Flushing
+        // coherent memory is a no-op, so direct writes are flushed regardless of their memory type.
+        std::vector<VmaAllocation> allocations;
+        std::vector<VkDeviceSize> offsets, sizes;
+        if (!this->coherent && this->pending.begin) {
+            const vk::DeviceSize begin = *this->pending.begin;
+            if (begin < this->pending.end) {
+                allocations.push_back(this->allocation);
+                offsets.push_back(begin);
+                sizes.push_back(this->pending.end - begin);
+            } else if (begin > this->pending.end) {
+                // The batch wrapped around the end of the ring
+                allocations.insert(allocations.end(), {this->allocation, this->allocation});
+                offsets.insert(offsets.end(), {begin, 0});
+                sizes.insert(sizes.end(), {this->size - begin, this->pending.end});
+            }
+        }
+        for (const auto& [buffer, allocation]: this->pending.dedicated) {
+            allocations.push_back(allocation);
+            offsets.push_back(0);
+            sizes.push_back(VK_WHOLE_SIZE);
+        }
+        for (const direct_write& write: this->direct_writes) {
+            allocations.push_back(write.allocation);
+            offsets.push_back(write.offset);
+            sizes.push_back(write.size);
+        }
+        this->direct_writes.clear();
+        if (!allocations.empty()) {
+            VGI_VMA_CHECK(vmaFlushAllocations(parent, static_cast<uint32_t>(allocations.size()),
+                                              allocations.data(), offsets.data(), sizes.data()));
+        }
+
+        this->pending.value = ++this->timeline_value;
+        cmdbuf_info = vk::CommandBufferSubmitInfo{.commandBuffer = this->pending.cmdbuf};
+        signal_info = vk::SemaphoreSubmitInfo{
+                .semaphore = this->timeline,
+                .value = this->pending.value,
+                .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+        };
+        this->in_flight.push_back(std::exchange(this->pending, {}));
+        return true;
+    }
+}  // namespace vgi
@@ -0,0 +1,239 @@
+/*! \file */
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <vgi/defs.hpp>
+#include <vgi/forward.hpp>
+#include <vgi/vgi.hpp>
+#include <vgi/vulkan.hpp>
+
+namespace vgi {
+    /// @brief A persistent, fixed-size and host-visible buffer used to stream data to the device
+    /// @details Memory is handed out in a ring. Every region belongs to the batch of copy commands
+    /// that was being recorded when it was allocated, and is reclaimed once the ring's timeline
+    /// semaphore reaches the value signaled by that batch, so staging memory stays bounded no
+    /// matter how much data is uploaded. When the ring runs out of memory, the pending batch is
+    /// submitted and the oldest batches are waited for until enough memory is released.
+    ///
+    /// Buffer copies queued with `copy` are grouped by source and destination, so that every
+    /// pair of buffers is copied with a single multi-region command when the batch is submitted.
+    /// The window submits the pending batch alongside each frame, with a single queue submission.
+    ///
+    /// Buffers that live on host-visible device memory (integrated GPUs, or discrete GPUs with
+    /// resizable BAR) and are persistently mapped skip the ring altogether when uploaded with
+    /// `stage` or with the `upload` overloads that take the buffer's allocation.
+    class staging_ring {
+    public:
+        /// @brief Default constructor
+        staging_ring() = default;
+
+        /// @brief Creates a new staging ring
+        /// @param parent Window that creates the ring
+        /// @param byte_size Number of bytes the ring can store
+        staging_ring(const window& parent, vk::DeviceSize byte_size);
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        staging_ring(staging_ring&& other) noexcept :
+            buffer(std::move(other.buffer)),
+            allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
+            mapped(std::exchange(other.mapped, nullptr)), size(std::exchange(other.size, 0)),
+            alignment(std::exchange(other.alignment, 1)), head(std::exchange(other.head, 0)),
+            tail(std::exchange(other.tail, 0)), coherent(other.coherent),
+            timeline(std::exchange(other.timeline, nullptr)),
+            timeline_value(std::exchange(other.timeline_value, 0)),
+            pending(std::exchange(other.pending, {})), copies(std::move(other.copies)),
+            direct_writes(std::move(other.direct_writes)),
+            in_flight(std::move(other.in_flight)), free_cmdbufs(std::move(other.free_cmdbufs)) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        staging_ring& operator=(staging_ring&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Number of bytes the ring can store
+        constexpr vk::DeviceSize capacity() const noexcept { return this->size; }
+
+        /// @brief Command buffer where the copies of the pending batch are recorded, beginning a
+        /// new batch if there is none
+        /// @param parent Window used to create the ring
+        /// @warning Allocating memory from the ring may submit the pending batch, so the command
+        /// buffer must be fetched again after every allocation.
+        vk::CommandBuffer record(window& parent);
+
+        /// @brief Allocates a region of the ring for the pending batch
+        /// @details Regions larger than the ring are backed by a dedicated buffer, which is
+        /// destroyed alongside the batch. The region is flushed when the batch is submitted.
+        /// @param parent Window used to create the ring
+        /// @param byte_size Size of the region, in bytes
+        /// @param alignment Minimum alignment of the region, within the underlying buffer
+        /// @return A transfer buffer that views the allocated region. It must not be destroyed.
+        transfer_buffer allocate(window& parent, vk::DeviceSize byte_size,
+                                 vk::DeviceSize alignment = 1);
+
+        /// @brief Queues a copy of a whole region of the ring into a buffer
+        /// @details Queued copies are recorded when the batch is submitted, grouped by source and
+        /// destination buffers, and with contiguous regions merged together.
+        /// @param src Region of the ring, as returned by `allocate`
+        /// @param dst Buffer where the data will be copied to
+        /// @param dst_offset Destination buffer offset, in bytes
+        /// @warning Queued copies must not overlap each other within the destination buffer.
+        void copy(const transfer_buffer& src, vk::Buffer dst, vk::DeviceSize dst_offset = 0);
+
+        /// @brief Copies host data into a buffer
+        /// @details Data larger than the ring is split into chunks, submitting the pending batch
+        /// and reclaiming memory between them as needed.
+        /// @param parent Window used to create the ring
+        /// @param src Data to be uploaded
+        /// @param dst Buffer where the data will be copied to
+        /// @param dst_offset Destination buffer offset, in bytes
+        void upload(window& parent, std::span<const std::byte> src, vk::Buffer dst,
+                    vk::DeviceSize dst_offset = 0);
+
+        /// @brief Copies host objects into a buffer
+        /// @details Data larger than the ring is split into chunks, submitting the pending batch
+        /// and reclaiming memory between them as needed.
+        /// @param parent Window used to create the ring
+        /// @param src Objects to be uploaded
+        /// @param dst Buffer where the data will be copied to
+        /// @param dst_offset Destination buffer offset, in bytes
+        template<class T>
+            requires(std::is_trivially_copyable_v<T> && !std::same_as<T, std::byte>)
+        inline void upload(window& parent, std::span<const T> src, vk::Buffer dst,
+                           vk::DeviceSize dst_offset = 0) {
+            this->upload(parent, std::as_bytes(src), dst, dst_offset);
+        }
+
+        /// @brief Memory where the data to be uploaded into a buffer must be written
+        /// @details If the buffer is persistently mapped, its own memory is returned and no copy
+        /// is recorded. Otherwise, a region of the ring is allocated and its copy into the buffer
+        /// is queued. Either way, the memory is flushed when the pending batch is submitted.
+        /// @param parent Window used to create the ring
+        /// @param byte_size Number of bytes to be written
+        /// @param dst Buffer where the data will be uploaded to
+        /// @param dst_allocation Allocation backing `dst`
+        /// @param dst_offset Destination buffer offset, in bytes
+        /// @warning The memory must be written before the pending batch is submitted, and the
+        /// buffer must not be in use by the device.
+        std::span<std::byte> stage(window& parent, vk::DeviceSize byte_size, vk::Buffer dst,
+                                   VmaAllocation dst_allocation, vk::DeviceSize dst_offset = 0);
+
+        /// @brief Copies host data into a buffer, writing it directly into the buffer's memory
+        /// when it is persistently mapped
+        /// @param parent Window used to create the ring
+        /// @param src Data to be uploaded
+        /// @param dst Buffer where the data will be copied to
+        /// @param dst_allocation Allocation backing `dst`
+        /// @param dst_offset Destination buffer offset, in bytes
+        /// @warning The buffer must not be in use by the device.
+        void upload(window& parent, std::span<const std::byte> src, vk::Buffer dst,
+                    VmaAllocation dst_allocation, vk::DeviceSize dst_offset = 0);
+
+        /// @brief Copies host objects into a buffer, writing them directly into the buffer's
+        /// memory when it is persistently mapped
+        /// @param parent Window used to create the ring
+        /// @param src Objects to be uploaded
+        /// @param dst Buffer where the data will be copied to
+        /// @param dst_allocation Allocation backing `dst`
+        /// @param dst_offset Destination buffer offset, in bytes
+        /// @warning The buffer must not be in use by the device.
+        template<class T>
+            requires(std::is_trivially_copyable_v<T> && !std::same_as<T, std::byte>)
+        inline void upload(window& parent, std::span<const T> src, vk::Buffer dst,
+                           VmaAllocation dst_allocation, vk::DeviceSize dst_offset = 0) {
+            this->upload(parent, std::as_bytes(src), dst, dst_allocation, dst_offset);
+        }
+
+        /// @brief Submits the pending batch to the device, if any
+        /// @details The batch ends with a memory barrier, so that commands submitted later to the
+        /// same queue observe the uploaded data. There is usually no need to call this, since
+        /// the window submits the pending batch alongside every frame.
+        /// @param parent Window used to create the ring
+        void submit(window& parent);
+
+        /// @brief Releases the memory of the batches the device has already finished with
+        /// @param parent Window used to create the ring
+        void reclaim(const window& parent);
+
+        /// @brief Submits the pending batch and waits until every batch is completed
+        /// @param parent Window used to create the ring
+        void wait(window& parent);
+
+        /// @brief Destroys the ring
+        /// @param parent Window used to create the ring
+        /// @warning The device must not be using any of the ring's batches
+        void destroy(const window& parent) && noexcept;
+
+        /// @brief Casts to the underlying `vk::Buffer`
+        constexpr operator vk::Buffer() const noexcept { return this->buffer; }
+        /// @brief Casts to the underlying `VkBuffer`
+        inline operator VkBuffer() const noexcept { return this->buffer; }
+        /// @brief Casts to the underlying `VmaAllocation`
+        constexpr operator VmaAllocation() const noexcept { return this->allocation; }
+
+        staging_ring(const staging_ring&) = delete;
+        staging_ring& operator=(const staging_ring&) = delete;
+
+    private:
+        struct batch {
+            vk::CommandBuffer cmdbuf;
+            uint64_t value = 0;
+            std::optional<vk::DeviceSize> begin;
+            vk::DeviceSize end = 0;
+            std::vector<std::pair<vk::Buffer, VmaAllocation>> dedicated;
+        };
+
+        struct queued_copy {
+            vk::Buffer src;
+            vk::Buffer dst;
+            vk::BufferCopy region;
+        };
+
+        struct direct_write {
+            VmaAllocation allocation;
+            vk::DeviceSize offset;
+            vk::DeviceSize size;
+        };
+
+        vk::Buffer buffer;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        std::byte* mapped = nullptr;
+        vk::DeviceSize size = 0;
+        vk::DeviceSize alignment = 1;
+        vk::DeviceSize head = 0;
+        vk::DeviceSize tail = 0;
+        bool coherent = true;
+        vk::Semaphore timeline;
+        uint64_t timeline_value = 0;
+        batch pending;
+        std::vector<queued_copy> copies;
+        std::vector<direct_write> direct_writes;
+        std::deque<batch> in_flight;
+        std::vector<vk::CommandBuffer> free_cmdbufs;
+
+        std::optional<vk::DeviceSize> try_reserve(vk::DeviceSize byte_size,
+                                                  vk::DeviceSize alignment) noexcept;
+        std::byte* write_directly(window& parent, VmaAllocation allocation, vk::DeviceSize offset,
+                                  vk::DeviceSize byte_size);
+        bool wait_oldest(const window& parent);
+        void release(const window& parent, batch& b);
+        bool prepare(const window& parent, vk::CommandBufferSubmitInfo& cmdbuf_info,
+                     vk::SemaphoreSubmitInfo& signal_info);
+
+        friend struct window;
+    };
+}  // namespace vgi
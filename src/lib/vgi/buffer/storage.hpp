@@ -1,12 +1,21 @@
 /*! \file */
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <concepts>
 #include <glm/glm.hpp>
 #include <span>
 #include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <vgi/buffer/transfer.hpp>
+#include <vgi/cmdbuf.hpp>
 #include <vgi/math.hpp>
+#include <vgi/memory.hpp>
 #include <vgi/pipeline.hpp>
+#include <vgi/pipeline/descriptor.hpp>
 #include <vgi/resource.hpp>
 #include <vgi/vulkan.hpp>
 #include <vgi/window.hpp>
@@ -15,16 +24,38 @@ namespace vgi {
     template<class T>
     concept storage = std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>;
 
+    /// @brief Specifies how the contents of a `vgi::storage_buffer` are updated
+    enum struct storage_mode {
+        /// @brief Every frame in flight has its own host-visible copy of the objects, which is
+        /// written directly by the host.
+        stream,
+        /// @brief Static data. A single device-local copy of the objects is uploaded once, and
+        /// never modified afterwards.
+        immutable,
+        /// @brief Every frame in flight has its own host-visible copy of the objects, which is
+        /// kept up to date with a host copy by only copying the ranges that changed since the
+        /// frame was last synchronized.
+        dynamic,
+    };
+
     /// @brief A buffer used to store objects
-    template<storage T>
+    /// @tparam T Type of the stored objects
+    /// @tparam Mode How the contents of the buffer are updated
+    template<storage T, storage_mode Mode = storage_mode::stream>
     struct storage_buffer {
+        /// @brief Maximum number of dirty ranges tracked per frame before they are merged into a
+        /// single range.
+        constexpr static inline const size_t MAX_DIRTY_RANGES = 64;
+
         /// @brief Default constructor.
         storage_buffer() = default;
 
         /// @brief Creates a new buffer
         /// @param parent Window that creates the buffer
         /// @param size Number of objects the buffer can store
-        explicit storage_buffer(const window& parent, vk::DeviceSize size = 1) : size(size) {
+        explicit storage_buffer(const window& parent, vk::DeviceSize size = 1)
+            requires(Mode != storage_mode::immutable)
+            : size(size) {
             auto byte_size = math::check_mul<vk::DeviceSize>(sizeof(T), size);
             if (byte_size) {
                 byte_size =
@@ -32,6 +63,7 @@ namespace vgi {
             }
 
             if (!byte_size) throw vgi_error{"too many objects"};
+            VmaAllocationInfo info;
             auto [buffer, allocation] = parent.create_buffer(
                     vk::BufferCreateInfo{
                             .size = byte_size.value(),
@@ -43,10 +75,48 @@ namespace vgi {
                             .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
                                      VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
                             .usage = VMA_MEMORY_USAGE_AUTO,
-                    });
+                    },
+                    &info);
+
+            VkMemoryPropertyFlags mem_flags;
+            vmaGetAllocationMemoryProperties(parent, allocation, &mem_flags);
+
+            VGI_ASSERT(info.pMappedData != nullptr);
+            this->buffer = buffer;
+            this->allocation = allocation;
+            this->mapped = static_cast<T*>(info.pMappedData);
+            this->coherent = (mem_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+            if constexpr (Mode == storage_mode::dynamic) {
+                this->state.values = make_unique_span_for_overwrite<T>(size);
+            }
+        }
+
+        /// @brief Creates a new static buffer and sets up the command and transfer buffers for the
+        /// upload
+        /// @param parent Window that creates the buffer
+        /// @param cmdbuf Command buffer used to register commands
+        /// @param transfer Transfer buffer used to move the data from host to device memory
+        /// @param src The objects to be uploaded
+        /// @param offset The offset from which the data will be written to the transfer buffer
+        storage_buffer(const window& parent, vk::CommandBuffer cmdbuf, transfer_buffer& transfer,
+                       std::span<const T> src, size_t offset = 0)
+            requires(Mode == storage_mode::immutable)
+            : size(src.size()) {
+            std::optional<vk::DeviceSize> byte_size =
+                    math::check_mul<vk::DeviceSize>(sizeof(T), src.size());
+            if (!byte_size) throw vgi_error{"too many objects"};
+
+            auto [buffer, allocation] = parent.create_buffer(
+                    vk::BufferCreateInfo{
+                            .size = byte_size.value(),
+                            .usage = vk::BufferUsageFlagBits::eTransferDst |
+                                     vk::BufferUsageFlagBits::eStorageBuffer,
+                    },
+                    VmaAllocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE});
 
             this->buffer = buffer;
             this->allocation = allocation;
+            transfer.template write_at<T>(cmdbuf, src, offset, this->buffer, 0);
         }
 
         /// @brief Move constructor
@@ -54,7 +124,8 @@ namespace vgi {
         storage_buffer(storage_buffer&& other) noexcept :
             buffer(std::move(other.buffer)),
             allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
-            size(std::exchange(other.size, 0)) {}
+            mapped(std::exchange(other.mapped, nullptr)), size(std::exchange(other.size, 0)),
+            coherent(other.coherent), state(std::move(other.state)) {}
 
         /// @brief Move assignment
         /// @param other Object to be moved
@@ -65,32 +136,88 @@ namespace vgi {
             return *this;
         }
 
+        /// @brief Number of objects the buffer can store
+        constexpr vk::DeviceSize capacity() const noexcept { return this->size; }
+
+        /// @brief Creates the information used to write this buffer to a descriptor set
+        /// @param current_frame Frame whose region of the buffer will be described
+        /// @return Structure specifying descriptor buffer information
+        inline vk::DescriptorBufferInfo descriptor_info(uint32_t current_frame) const noexcept {
+            VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+            const vk::DeviceSize stride = static_cast<vk::DeviceSize>(this->size) *
+                                          static_cast<vk::DeviceSize>(sizeof(T));
+            // Static buffers share a single copy between all frames
+            const vk::DeviceSize frame = Mode == storage_mode::immutable ? 0 : current_frame;
+            return {
+                    .buffer = this->buffer,
+                    .offset = stride * frame,
+                    .range = stride,
+            };
+        }
+
+        /// @brief Queues the writes needed for a descriptor pool's bindings to use this buffer
+        /// @param writer Writer where the descriptor writes will be queued
+        /// @param pool Descriptor pool to update
+        /// @param binding Slot to which bind the buffer
+        void update_descriptors(descriptor_writer& writer, const descriptor_pool& pool,
+                                uint32_t binding) const {
+            for (uint32_t i = 0; i < pool.size(); ++i) {
+                writer.write_buffer(pool[i], binding, vk::DescriptorType::eStorageBuffer,
+                                    this->descriptor_info(i));
+            }
+        }
+
         /// @brief Updates a descriptor pool's bindings so that they use this buffer
         /// @param parent Window used to create the descriptor pool and the buffer
         /// @param pool Descriptor pool to update
         /// @param binding Slot to which bind the buffer
-        void update_descriptors(const window& parent, descriptor_pool& pool,
+        void update_descriptors(const window& parent, const descriptor_pool& pool,
                                 uint32_t binding) const {
-            const vk::DeviceSize stride = static_cast<vk::DeviceSize>(this->size) *
-                                          static_cast<vk::DeviceSize>(sizeof(T));
+            descriptor_writer writer;
+            this->update_descriptors(writer, pool, binding);
+            writer.flush(parent);
+        }
 
-            for (uint32_t i = 0; i < pool.size(); ++i) {
-                const vk::DescriptorBufferInfo buf_info{
-                        .buffer = this->buffer,
-                        .offset = stride * static_cast<vk::DeviceSize>(i),
-                        .range = stride,
-                };
-
-                parent->updateDescriptorSets(
-                        vk::WriteDescriptorSet{
-                                .dstSet = pool[i],
-                                .dstBinding = binding,
-                                .descriptorCount = 1,
-                                .descriptorType = vk::DescriptorType::eStorageBuffer,
-                                .pBufferInfo = &buf_info,
-                        },
-                        {});
-            }
+        /// @brief Host view of a frame's objects, which can be read and written in place
+        /// @details The buffer is mapped for its entire lifetime, so accessing it through this
+        /// view performs no copies. Remember to `flush` the frame once done writing.
+        /// @param current_frame Frame whose objects will be accessed
+        inline std::span<T> data(uint32_t current_frame) const noexcept
+            requires(Mode == storage_mode::stream)
+        {
+            VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+            return std::span<T>{this->mapped + static_cast<size_t>(current_frame) * this->size,
+                                static_cast<size_t>(this->size)};
+        }
+
+        /// @brief Host copy of the objects, which every frame is synchronized with
+        inline std::span<const T> values() const noexcept
+            requires(Mode == storage_mode::dynamic)
+        {
+            return this->state.values;
+        }
+
+        /// @brief Makes the host writes to a range of a frame's objects visible to the device
+        /// @details This is a no-op when the buffer resides on host-coherent memory.
+        /// @param parent Window used to create the buffer
+        /// @param current_frame Frame whose objects will be flushed
+        /// @param offset Index of the first object to flush
+        /// @param count Number of objects to flush, or `VK_WHOLE_SIZE` to flush up to the end of
+        /// the frame
+        inline void flush(const window& parent, uint32_t current_frame, vk::DeviceSize offset = 0,
+                          vk::DeviceSize count = VK_WHOLE_SIZE) const
+            requires(Mode == storage_mode::stream)
+        {
+            VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+            VGI_ASSERT(offset <= this->size);
+            if (this->coherent) return;
+            if (count == VK_WHOLE_SIZE) count = this->size - offset;
+            VGI_ASSERT(count <= this->size - offset);
+
+            const vk::DeviceSize first =
+                    static_cast<vk::DeviceSize>(current_frame) * this->size + offset;
+            VGI_VMA_CHECK(vmaFlushAllocation(parent, this->allocation, first * sizeof(T),
+                                             count * sizeof(T)));
         }
 
         /// @brief Upload objects to the GPU
@@ -99,17 +226,14 @@ namespace vgi {
         /// @param current_frame Frame for which the buffer information will be updated
         /// @param offset Offset within the buffer where to write copied data
         inline void write(const window& parent, std::span<const T> src, uint32_t current_frame,
-                          vk::DeviceSize offset = 0) {
-            VGI_ASSERT(offset + src.size() <= this->size);
-            auto byte_offset = math::check_mul<vk::DeviceSize>(current_frame, this->size);
-            if (byte_offset) byte_offset = math::check_add<vk::DeviceSize>(*byte_offset, offset);
-            if (byte_offset) byte_offset = math::check_mul<vk::DeviceSize>(*byte_offset, sizeof(T));
-            if (!byte_offset) throw vgi_error{"offset is too large"};
+                          vk::DeviceSize offset = 0)
+            requires(Mode == storage_mode::stream)
+        {
+            std::optional<vk::DeviceSize> end = math::check_add<vk::DeviceSize>(offset, src.size());
+            if (!end || *end > this->size) throw vgi_error{"offset is too large"};
 
-            vk::detail::resultCheck(static_cast<vk::Result>(vmaCopyMemoryToAllocation(
-                                            parent, src.data(), this->allocation,
-                                            byte_offset.value(), src.size_bytes())),
-                                    __FUNCTION__);
+            std::ranges::copy(src, this->data(current_frame).begin() + offset);
+            this->flush(parent, current_frame, offset, src.size());
         }
 
         /// @brief Upload object to the GPU
@@ -118,14 +242,134 @@ namespace vgi {
         /// @param current_frame Frame for which the buffer information will be updated
         /// @param offset Offset within the buffer where to write copied data
         inline void write(const window& parent, const T& src, uint32_t current_frame,
-                          vk::DeviceSize offset = 0) {
+                          vk::DeviceSize offset = 0)
+            requires(Mode == storage_mode::stream)
+        {
             return write(parent, std::span<const T>(std::addressof(src), 1), current_frame, offset);
         }
 
+        /// @brief Updates the host copy of the objects, marking the range as dirty for every frame
+        /// @param src Elements to be written
+        /// @param offset Offset within the buffer where to write copied data
+        /// @sa vgi::storage_buffer::sync
+        inline void write(std::span<const T> src, vk::DeviceSize offset = 0)
+            requires(Mode == storage_mode::dynamic)
+        {
+            std::optional<vk::DeviceSize> end = math::check_add<vk::DeviceSize>(offset, src.size());
+            if (!end || *end > this->size) throw vgi_error{"offset is too large"};
+            if (src.empty()) return;
+
+            std::ranges::copy(src, this->state.values.begin() + offset);
+            for (std::vector<dirty_range>& ranges: this->state.dirty) {
+                if (ranges.size() >= MAX_DIRTY_RANGES) {
+                    // Too many scattered writes, collapse them into a single range
+                    dirty_range merged = ranges.front();
+                    for (const dirty_range& range: ranges) {
+                        merged.first = (std::min)(merged.first, range.first);
+                        merged.second = (std::max)(merged.second, range.second);
+                    }
+                    ranges.clear();
+                    ranges.push_back(merged);
+                }
+                ranges.emplace_back(offset, *end);
+            }
+        }
+
+        /// @brief Updates the host copy of an object, marking it as dirty for every frame
+        /// @param src Element to be written
+        /// @param offset Offset within the buffer where to write copied data
+        /// @sa vgi::storage_buffer::sync
+        inline void write(const T& src, vk::DeviceSize offset = 0)
+            requires(Mode == storage_mode::dynamic)
+        {
+            return write(std::span<const T>(std::addressof(src), 1), offset);
+        }
+
+        /// @brief Copies the ranges that changed since the last synchronization of a frame into
+        /// that frame's copy, flushing them all at once.
+        /// @param parent Window used to create the buffer
+        /// @param current_frame Frame to synchronize
+        void sync(const window& parent, uint32_t current_frame)
+            requires(Mode == storage_mode::dynamic)
+        {
+            VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+            std::vector<dirty_range>& ranges = this->state.dirty[current_frame];
+            if (ranges.empty()) return;
+
+            // Coalesce overlapping and adjacent ranges
+            std::ranges::sort(ranges);
+            size_t merged = 0;
+            for (size_t i = 1; i < ranges.size(); ++i) {
+                if (ranges[i].first <= ranges[merged].second) {
+                    ranges[merged].second = (std::max)(ranges[merged].second, ranges[i].second);
+                } else {
+                    ranges[++merged] = ranges[i];
+                }
+            }
+            ranges.resize(merged + 1);
+
+            const vk::DeviceSize first = static_cast<vk::DeviceSize>(current_frame) * this->size;
+            std::vector<VmaAllocation> allocations;
+            std::vector<VkDeviceSize> offsets, sizes;
+            if (!this->coherent) {
+                allocations.assign(ranges.size(), this->allocation);
+                offsets.reserve(ranges.size());
+                sizes.reserve(ranges.size());
+            }
+
+            for (const auto& [begin, end]: ranges) {
+                std::copy(this->state.values.begin() + begin, this->state.values.begin() + end,
+                          this->mapped + first + begin);
+                if (!this->coherent) {
+                    offsets.push_back((first + begin) * sizeof(T));
+                    sizes.push_back((end - begin) * sizeof(T));
+                }
+            }
+
+            if (!this->coherent) {
+                VGI_VMA_CHECK(vmaFlushAllocations(parent, static_cast<uint32_t>(allocations.size()),
+                                                  allocations.data(), offsets.data(),
+                                                  sizes.data()));
+            }
+            ranges.clear();
+        }
+
         /// @brief Destroys the buffer
         /// @param parent Window used to create the buffer
         inline void destroy(const window& parent) && noexcept {
-            vmaDestroyBuffer(parent, this->buffer, this->allocation);
+            parent.destroy_buffer(this->buffer, this->allocation);
+        }
+
+        /// @brief Creates a new static buffer, creates a transfer buffer with the required size
+        /// and sets up the command for the upload
+        /// @param parent Window that will create the buffer
+        /// @param cmdbuf Command buffer used to register commands
+        /// @param src The objects to be uploaded
+        /// @param min_size The minimum size of the transfer buffer
+        static inline std::pair<storage_buffer, transfer_buffer_guard> upload(
+                const window& parent, vk::CommandBuffer cmdbuf, std::span<const T> src,
+                size_t min_size = 0)
+            requires(Mode == storage_mode::immutable)
+        {
+            vgi::transfer_buffer_guard transfer{parent, (std::max)(src.size_bytes(), min_size)};
+            storage_buffer result{parent, cmdbuf, transfer, src};
+            return std::make_pair<storage_buffer, transfer_buffer_guard>(std::move(result),
+                                                                         std::move(transfer));
+        }
+
+        /// @brief Creates a new static buffer and uploads the data to the device, waiting for the
+        /// upload to complete.
+        /// @param parent Window that will create the buffer
+        /// @param src The objects to be uploaded
+        /// @warning If possible, avoid using this method and instead upload multiple buffers
+        /// simultaneously.
+        static inline storage_buffer upload_and_wait(window& parent, std::span<const T> src)
+            requires(Mode == storage_mode::immutable)
+        {
+            command_buffer cmdbuf{parent};
+            auto [buffer, transfer] = upload(parent, cmdbuf, src);
+            std::move(cmdbuf).submit_and_wait();
+            return std::move(buffer);
         }
 
         /// @brief Casts to the underlying `vk::Buffer`
@@ -139,12 +383,23 @@ namespace vgi {
         storage_buffer& operator=(const storage_buffer&) = delete;
 
     private:
+        using dirty_range = std::pair<vk::DeviceSize, vk::DeviceSize>;
+
+        struct dynamic_state {
+            unique_span<T> values;
+            std::array<std::vector<dirty_range>, window::MAX_FRAMES_IN_FLIGHT> dirty;
+        };
+
         vk::Buffer buffer;
         VmaAllocation allocation = VK_NULL_HANDLE;
-        vk::DeviceSize size;
+        T* mapped = nullptr;
+        vk::DeviceSize size = 0;
+        bool coherent = true;
+        [[no_unique_address]] std::conditional_t<Mode == storage_mode::dynamic, dynamic_state,
+                                                 std::monostate> state;
     };
 
     /// @brief A guard that destroys the storage buffer when dropped.
-    template<storage T>
-    using storage_buffer_guard = resource_guard<storage_buffer<T>>;
+    template<storage T, storage_mode Mode = storage_mode::stream>
+    using storage_buffer_guard = resource_guard<storage_buffer<T, Mode>>;
 }  // namespace vgi
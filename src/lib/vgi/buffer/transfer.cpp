@@ -45,12 +45,15 @@ namespace vgi {
         cmdbuf.copyBuffer(
                 this->buffer, dst,
                 vk::BufferCopy{
-                        .srcOffset = src_offset, .dstOffset = dst_offset, .size = src.size()});
+                        .srcOffset = this->base + src_offset,
+                        .dstOffset = dst_offset,
+                        .size = src.size()});
 
         return *end;
     }
 
     void transfer_buffer::flush(const window& parent) {
+        if (!this->allocation) return;
         VGI_VMA_CHECK(vmaFlushAllocation(parent, this->allocation, 0, VK_WHOLE_SIZE));
     }
 }  // namespace vgi
@@ -49,7 +49,7 @@ namespace vgi {
         inline transfer_buffer(transfer_buffer&& other) noexcept :
             buffer(std::move(other.buffer)),
             allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
-            bytes(std::exchange(other.bytes, {})) {}
+            base(std::exchange(other.base, 0)), bytes(std::exchange(other.bytes, {})) {}
 
         /// @brief Move assignment operator
         /// @param other Value to be moved
@@ -178,14 +178,24 @@ namespace vgi {
             return write<T>(std::span<const T>{std::addressof(src), 1}, offset);
         }
 
+        /// @brief Offset of the transfer buffer's memory within the underlying `vk::Buffer`, in
+        /// bytes
+        /// @details This is only non-zero for the regions handed out by a `vgi::staging_ring`, and
+        /// must be added to the offsets of copy commands that don't go through `write_at`.
+        constexpr vk::DeviceSize buffer_offset() const noexcept { return this->base; }
+
         /// @brief Flush the cache back to device memory
+        /// @details Regions of a `vgi::staging_ring` are flushed by the ring when submitted, so
+        /// this is a no-op for them.
         /// @param parent Window used to create the buffer
         void flush(const window& parent);
 
         /// @brief Destroys the buffer
+        /// @details Regions of a `vgi::staging_ring` are owned by the ring, so this is a no-op for
+        /// them.
         /// @param parent Window used to create the buffer
         inline void destroy(const window& parent) && {
-            vmaDestroyBuffer(parent, this->buffer, this->allocation);
+            if (this->allocation) parent.destroy_buffer(this->buffer, this->allocation);
         }
 
         /// @brief Casts to the underlying `vk::Buffer`
@@ -204,11 +214,18 @@ namespace vgi {
     private:
         vk::Buffer buffer;
         VmaAllocation allocation = VK_NULL_HANDLE;
+        vk::DeviceSize base = 0;
         std::span<std::byte> bytes;
 
+        transfer_buffer(vk::Buffer buffer, vk::DeviceSize base,
+                        std::span<std::byte> bytes) noexcept :
+            buffer(buffer), base(base), bytes(bytes) {}
+
         size_t write_at(std::span<const std::byte> src, size_t byte_offset);
         size_t write_at(vk::CommandBuffer cmdbuf, std::span<const std::byte> src, size_t src_offset,
                         vk::Buffer dst, vk::DeviceSize dst_offset);
+
+        friend class staging_ring;
     };
 
     /// @brief A guard that destroys the transfer buffer when dropped.
@@ -0,0 +1,101 @@
+#include "transient.hpp"
+
+#include <vgi/math.hpp>
+#include <vgi/vgi.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    transient_buffer::transient_buffer(const window& parent, vk::DeviceSize frame_size) {
+        // Every region must be usable as a dynamic uniform/storage buffer, and every frame must
+        // start at a boundary that can be flushed independently of its neighbours.
+        const vk::PhysicalDeviceLimits& limits = parent.device().props().limits;
+        this->alignment = std::max({limits.minUniformBufferOffsetAlignment,
+                                    limits.minStorageBufferOffsetAlignment,
+                                    limits.nonCoherentAtomSize, vk::DeviceSize{16}});
+
+        std::optional<vk::DeviceSize> aligned_size =
+                math::next_multiple_of<vk::DeviceSize>(frame_size, this->alignment);
+        std::optional<vk::DeviceSize> byte_size;
+        if (aligned_size) {
+            byte_size = math::check_mul<vk::DeviceSize>(aligned_size.value(),
+                                                        window::MAX_FRAMES_IN_FLIGHT);
+        }
+        if (!byte_size || byte_size.value() > UINT32_MAX)
+            throw vgi_error{"transient buffer is too large"};
+
+        VmaAllocationInfo info;
+        auto [buffer, allocation] = parent.create_buffer(
+                vk::BufferCreateInfo{
+                        .size = byte_size.value(),
+                        .usage = vk::BufferUsageFlagBits::eTransferSrc |
+                                 vk::BufferUsageFlagBits::eUniformBuffer |
+                                 vk::BufferUsageFlagBits::eStorageBuffer |
+                                 vk::BufferUsageFlagBits::eVertexBuffer |
+                                 vk::BufferUsageFlagBits::eIndexBuffer |
+                                 vk::BufferUsageFlagBits::eIndirectBuffer |
+                                 vk::BufferUsageFlagBits::eShaderDeviceAddress,
+                },
+                VmaAllocationCreateInfo{
+                        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
+                                 VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                        .usage = VMA_MEMORY_USAGE_AUTO,
+                },
+                &info);
+
+        VkMemoryPropertyFlags mem_flags;
+        vmaGetAllocationMemoryProperties(parent, allocation, &mem_flags);
+
+        VGI_ASSERT(info.pMappedData != nullptr);
+        this->buffer = buffer;
+        this->allocation = allocation;
+        this->mapped = static_cast<std::byte*>(info.pMappedData);
+        this->address = parent->getBufferAddress(vk::BufferDeviceAddressInfo{.buffer = buffer});
+        this->frame_size = aligned_size.value();
+        this->coherent = (mem_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    }
+
+    std::optional<transient_slice<std::byte>> transient_buffer::try_allocate(
+            uint32_t current_frame, vk::DeviceSize byte_size, vk::DeviceSize alignment) noexcept {
+        VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+        VGI_ASSERT(alignment > 0);
+
+        // Frames start at a multiple of the base alignment, so aligning the offset within the
+        // frame is enough, unless a bigger alignment is requested.
+        const vk::DeviceSize frame_start = this->frame_size * current_frame;
+        std::optional<vk::DeviceSize> offset = math::next_multiple_of<vk::DeviceSize>(
+                frame_start + this->heads[current_frame], std::max(this->alignment, alignment));
+        if (!offset) return std::nullopt;
+        std::optional<vk::DeviceSize> end = math::check_add<vk::DeviceSize>(*offset, byte_size);
+        if (!end || *end > frame_start + this->frame_size) [[unlikely]]
+            return std::nullopt;
+
+        this->heads[current_frame] = *end - frame_start;
+        return transient_slice<std::byte>{
+                .buffer = this->buffer,
+                .offset = *offset,
+                .data = std::span<std::byte>{this->mapped + *offset, byte_size},
+                .address = this->address + *offset,
+        };
+    }
+
+    transient_slice<std::byte> transient_buffer::allocate(uint32_t current_frame,
+                                                          vk::DeviceSize byte_size,
+                                                          vk::DeviceSize alignment) {
+        std::optional<transient_slice<std::byte>> slice =
+                this->try_allocate(current_frame, byte_size, alignment);
+        if (!slice) throw vgi_error{"transient buffer is out of memory"};
+        return slice.value();
+    }
+
+    void transient_buffer::flush(const window& parent, uint32_t current_frame) const {
+        VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+        if (this->coherent || this->heads[current_frame] == 0) return;
+        VGI_VMA_CHECK(vmaFlushAllocation(parent, this->allocation,
+                                         this->frame_size * current_frame,
+                                         this->heads[current_frame]));
+    }
+
+    void transient_buffer::destroy(const window& parent) && noexcept {
+        parent.destroy_buffer(this->buffer, this->allocation);
+    }
+}  // namespace vgi
@@ -0,0 +1,233 @@
+/*! \file */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vgi/defs.hpp>
+#include <vgi/forward.hpp>
+#include <vgi/math.hpp>
+#include <vgi/vgi.hpp>
+#include <vgi/vulkan.hpp>
+
+namespace vgi {
+    /// @brief A region of a `vgi::transient_buffer`.
+    /// @details The region is only valid until the frame it was allocated for is processed again.
+    /// @tparam T Type of the elements stored in the region
+    template<class T>
+    struct transient_slice {
+        /// @brief Buffer that contains the region
+        vk::Buffer buffer;
+        /// @brief Offset of the region from the start of the buffer, in bytes
+        vk::DeviceSize offset;
+        /// @brief Host view of the region
+        std::span<T> data;
+        /// @brief Device address of the region, for shaders that access it through a buffer
+        /// reference
+        vk::DeviceAddress address = 0;
+
+        /// @brief Offset to be passed to `vkCmdBindDescriptorSets` when the region is accessed
+        /// through a dynamic uniform or storage buffer descriptor
+        inline uint32_t dynamic_offset() const noexcept {
+            VGI_ASSERT(this->offset <= UINT32_MAX);
+            return static_cast<uint32_t>(this->offset);
+        }
+
+        /// @brief Creates the information used to write this region to a descriptor set
+        /// @return Structure specifying descriptor buffer information
+        inline vk::DescriptorBufferInfo descriptor_info() const noexcept {
+            return {
+                    .buffer = this->buffer,
+                    .offset = this->offset,
+                    .range = this->data.size_bytes(),
+            };
+        }
+
+        /// @brief Binds the region as a vertex buffer
+        /// @param cmdbuf Command buffer to which the region will be bound
+        /// @param binding Binding slot of the vertex buffer
+        inline void bind_vertices(vk::CommandBuffer cmdbuf, uint32_t binding = 0) const noexcept {
+            cmdbuf.bindVertexBuffers(binding, this->buffer, this->offset);
+        }
+
+        /// @brief Binds the region as an index buffer
+        /// @param cmdbuf Command buffer to which the region will be bound
+        inline void bind_indices(vk::CommandBuffer cmdbuf) const noexcept
+            requires(same_as_any<std::remove_const_t<T>, uint16_t, uint32_t>)
+        {
+            cmdbuf.bindIndexBuffer(this->buffer, this->offset,
+                                   sizeof(T) == sizeof(uint16_t) ? vk::IndexType::eUint16
+                                                                 : vk::IndexType::eUint32);
+        }
+    };
+
+    /// @brief A persistently mapped, host-visible buffer that hands out short-lived regions
+    /// @details The buffer is split into one region per frame in flight. Each region works as a
+    /// linear allocator which is reset once the device has finished with the frame it belongs to,
+    /// so it's well suited for transient data (i.e. per-draw uniforms accessed with dynamic
+    /// offsets, vertices and indices that are only used for a single frame, or indirect draws).
+    class transient_buffer {
+        using heads_type = std::array<vk::DeviceSize, VGI_MAX_FRAMES_IN_FLIGHT>;
+
+    public:
+        /// @brief Default constructor
+        transient_buffer() = default;
+
+        /// @brief Creates a new transient buffer
+        /// @param parent Window that creates the buffer
+        /// @param frame_size Number of bytes that can be allocated on each frame
+        transient_buffer(const window& parent, vk::DeviceSize frame_size);
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        transient_buffer(transient_buffer&& other) noexcept :
+            buffer(std::move(other.buffer)),
+            allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
+            mapped(std::exchange(other.mapped, nullptr)),
+            address(std::exchange(other.address, 0)),
+            frame_size(std::exchange(other.frame_size, 0)),
+            alignment(std::exchange(other.alignment, 1)), heads(std::exchange(other.heads, {})),
+            coherent(other.coherent) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        transient_buffer& operator=(transient_buffer&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Number of bytes that can be allocated on each frame
+        constexpr vk::DeviceSize capacity() const noexcept { return this->frame_size; }
+        /// @brief Number of bytes already allocated on a frame (including alignment padding)
+        /// @param current_frame Frame to be queried
+        inline vk::DeviceSize used(uint32_t current_frame) const noexcept {
+            VGI_ASSERT(current_frame < VGI_MAX_FRAMES_IN_FLIGHT);
+            return this->heads[current_frame];
+        }
+
+        /// @brief Allocates a region of memory for the current frame
+        /// @param current_frame Frame for which the region is allocated
+        /// @param byte_size Size of the region, in bytes
+        /// @param alignment Minimum alignment of the region. Regions are always aligned to the
+        /// device's minimum uniform and storage buffer offset alignment.
+        /// @return The allocated region, or `std::nullopt` if the frame has run out of memory
+        std::optional<transient_slice<std::byte>> try_allocate(
+                uint32_t current_frame, vk::DeviceSize byte_size,
+                vk::DeviceSize alignment = 1) noexcept;
+
+        /// @brief Allocates a region of memory for the current frame
+        /// @param current_frame Frame for which the region is allocated
+        /// @param byte_size Size of the region, in bytes
+        /// @param alignment Minimum alignment of the region. Regions are always aligned to the
+        /// device's minimum uniform and storage buffer offset alignment.
+        /// @return The allocated region
+        /// @throws `vgi::vgi_error` if the frame has run out of memory
+        transient_slice<std::byte> allocate(uint32_t current_frame, vk::DeviceSize byte_size,
+                                            vk::DeviceSize alignment = 1);
+
+        /// @brief Allocates an uninitialized array of objects for the current frame
+        /// @tparam T Type of the objects
+        /// @param current_frame Frame for which the region is allocated
+        /// @param count Number of objects to allocate
+        /// @return The allocated region
+        /// @throws `vgi::vgi_error` if the frame has run out of memory
+        template<class T>
+            requires(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>)
+        transient_slice<T> allocate(uint32_t current_frame, size_t count = 1) {
+            std::optional<vk::DeviceSize> byte_size =
+                    math::check_mul<vk::DeviceSize>(sizeof(T), count);
+            if (!byte_size) throw vgi_error{"too many transient objects"};
+
+            transient_slice<std::byte> slice =
+                    this->allocate(current_frame, byte_size.value(), alignof(T));
+            return transient_slice<T>{
+                    .buffer = slice.buffer,
+                    .offset = slice.offset,
+                    .data = std::span<T>{reinterpret_cast<T*>(slice.data.data()), count},
+                    .address = slice.address,
+            };
+        }
+
+        /// @brief Copies objects into a new region of the current frame
+        /// @tparam T Type of the objects
+        /// @param current_frame Frame for which the region is allocated
+        /// @param src Objects to be copied
+        /// @return The allocated region
+        /// @throws `vgi::vgi_error` if the frame has run out of memory
+        template<class T>
+            requires(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>)
+        transient_slice<T> push(uint32_t current_frame, std::span<const T> src) {
+            transient_slice<T> slice = this->allocate<T>(current_frame, src.size());
+            std::ranges::copy(src, slice.data.begin());
+            return slice;
+        }
+
+        /// @brief Copies an object into a new region of the current frame
+        /// @tparam T Type of the object
+        /// @param current_frame Frame for which the region is allocated
+        /// @param src Object to be copied
+        /// @return The allocated region
+        /// @throws `vgi::vgi_error` if the frame has run out of memory
+        template<class T>
+            requires(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>)
+        transient_slice<T> push(uint32_t current_frame, const T& src) {
+            return this->push(current_frame, std::span<const T>{std::addressof(src), 1});
+        }
+
+        /// @brief Creates the information used to write this buffer to a dynamic uniform or
+        /// storage buffer descriptor
+        /// @param range Size of the data accessed through the descriptor
+        /// @return Structure specifying descriptor buffer information
+        /// @sa vgi::transient_slice::dynamic_offset
+        inline vk::DescriptorBufferInfo descriptor_info(vk::DeviceSize range) const noexcept {
+            return {.buffer = this->buffer, .offset = 0, .range = range};
+        }
+
+        /// @brief Releases all the regions allocated for a frame
+        /// @param current_frame Frame whose regions are released
+        /// @warning The device must not be using any of the regions
+        inline void reset(uint32_t current_frame) noexcept {
+            VGI_ASSERT(current_frame < VGI_MAX_FRAMES_IN_FLIGHT);
+            this->heads[current_frame] = 0;
+        }
+
+        /// @brief Makes the host writes to a frame visible to the device
+        /// @details This is a no-op when the buffer resides on host-coherent memory.
+        /// @param parent Window used to create the buffer
+        /// @param current_frame Frame whose regions are flushed
+        void flush(const window& parent, uint32_t current_frame) const;
+
+        /// @brief Destroys the buffer
+        /// @param parent Window used to create the buffer
+        void destroy(const window& parent) && noexcept;
+
+        /// @brief Casts to the underlying `vk::Buffer`
+        constexpr operator vk::Buffer() const noexcept { return this->buffer; }
+        /// @brief Casts to the underlying `VkBuffer`
+        inline operator VkBuffer() const noexcept { return this->buffer; }
+        /// @brief Casts to the underlying `VmaAllocation`
+        constexpr operator VmaAllocation() const noexcept { return this->allocation; }
+
+        transient_buffer(const transient_buffer&) = delete;
+        transient_buffer& operator=(const transient_buffer&) = delete;
+
+    private:
+        vk::Buffer buffer;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        std::byte* mapped = nullptr;
+        vk::DeviceAddress address = 0;
+        vk::DeviceSize frame_size = 0;
+        vk::DeviceSize alignment = 1;
+        heads_type heads = {};
+        bool coherent = true;
+    };
+}  // namespace vgi
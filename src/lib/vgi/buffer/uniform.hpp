@@ -7,6 +7,7 @@
 #include <type_traits>
 #include <vgi/math.hpp>
 #include <vgi/pipeline.hpp>
+#include <vgi/pipeline/descriptor.hpp>
 #include <vgi/resource.hpp>
 #include <vgi/vulkan.hpp>
 #include <vgi/window.hpp>
@@ -30,6 +31,7 @@ namespace vgi {
                     math::check_mul<vk::DeviceSize>(sizeof(T), window::MAX_FRAMES_IN_FLIGHT);
 
             if (!byte_size) throw vgi_error{"too many uniform objects"};
+            VmaAllocationInfo info;
             auto [buffer, allocation] = parent.create_buffer(
                     vk::BufferCreateInfo{
                             .size = byte_size.value(),
@@ -41,17 +43,25 @@ namespace vgi {
                             .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
                                      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
                             .usage = VMA_MEMORY_USAGE_AUTO,
-                    });
+                    },
+                    &info);
+
+            VkMemoryPropertyFlags mem_flags;
+            vmaGetAllocationMemoryProperties(parent, allocation, &mem_flags);
 
+            VGI_ASSERT(info.pMappedData != nullptr);
             this->buffer = buffer;
             this->allocation = allocation;
+            this->mapped = static_cast<T*>(info.pMappedData);
+            this->coherent = (mem_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
         }
 
         /// @brief Move constructor
         /// @param other Object to be moved
         uniform_buffer(uniform_buffer&& other) noexcept :
             buffer(std::move(other.buffer)),
-            allocation(std::exchange(other.allocation, VK_NULL_HANDLE)) {}
+            allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
+            mapped(std::exchange(other.mapped, nullptr)), coherent(other.coherent) {}
 
         /// @brief Move assignment
         /// @param other Object to be moved
@@ -62,31 +72,65 @@ namespace vgi {
             return *this;
         }
 
+        /// @brief Creates the information used to write this buffer to a descriptor set
+        /// @param current_frame Frame whose region of the buffer will be described
+        /// @return Structure specifying descriptor buffer information
+        inline vk::DescriptorBufferInfo descriptor_info(uint32_t current_frame) const noexcept {
+            VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+            const vk::DeviceSize stride = static_cast<vk::DeviceSize>(sizeof(T));
+            return {
+                    .buffer = this->buffer,
+                    .offset = stride * static_cast<vk::DeviceSize>(current_frame),
+                    .range = stride,
+            };
+        }
+
+        /// @brief Queues the writes needed for a descriptor pool's bindings to use this uniform
+        /// buffer
+        /// @param writer Writer where the descriptor writes will be queued
+        /// @param pool Descriptor pool to update
+        /// @param binding Slot to which bind the uniform buffer
+        void update_descriptors(descriptor_writer& writer, const descriptor_pool& pool,
+                                uint32_t binding) const {
+            for (uint32_t i = 0; i < pool.size(); ++i) {
+                writer.write_buffer(pool[i], binding, vk::DescriptorType::eUniformBuffer,
+                                    this->descriptor_info(i));
+            }
+        }
+
         /// @brief Updates a descriptor pool's bindings so that they use this uniform buffer
         /// @param parent Window used to create the descriptor pool and the buffer
         /// @param pool Descriptor pool to update
         /// @param binding Slot to which bind the uniform buffer
-        void update_descriptors(const window& parent, vgi::descriptor_pool& pool,
+        void update_descriptors(const window& parent, const descriptor_pool& pool,
                                 uint32_t binding) const {
-            const vk::DeviceSize stride = static_cast<vk::DeviceSize>(sizeof(T));
+            descriptor_writer writer;
+            this->update_descriptors(writer, pool, binding);
+            writer.flush(parent);
+        }
 
-            for (uint32_t i = 0; i < pool.size(); ++i) {
-                const vk::DescriptorBufferInfo buf_info{
-                        .buffer = this->buffer,
-                        .offset = stride * static_cast<vk::DeviceSize>(i),
-                        .range = stride,
-                };
-
-                parent->updateDescriptorSets(
-                        vk::WriteDescriptorSet{
-                                .dstSet = pool[i],
-                                .dstBinding = binding,
-                                .descriptorCount = 1,
-                                .descriptorType = vk::DescriptorType::eUniformBuffer,
-                                .pBufferInfo = &buf_info,
-                        },
-                        {});
-            }
+        /// @brief Host view of a frame's uniform object, which can be written in place
+        /// @details The buffer is mapped for its entire lifetime, so writing through this view
+        /// performs no copies. Remember to `flush` the frame once done writing.
+        /// @param current_frame Frame whose uniform object will be accessed
+        /// @warning The memory may be uncached, so it should only be written sequentially, never
+        /// read.
+        inline std::span<T, 1> data(uint32_t current_frame) const noexcept {
+            VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+            return std::span<T, 1>{this->mapped + current_frame, 1};
+        }
+
+        /// @brief Makes the host writes to a frame's uniform object visible to the device
+        /// @details This is a no-op when the buffer resides on host-coherent memory.
+        /// @param parent Window used to create the buffer
+        /// @param current_frame Frame whose uniform object will be flushed
+        inline void flush(const window& parent, uint32_t current_frame) const {
+            VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+            if (this->coherent) return;
+            VGI_VMA_CHECK(vmaFlushAllocation(parent, this->allocation,
+                                             static_cast<vk::DeviceSize>(current_frame) *
+                                                     static_cast<vk::DeviceSize>(sizeof(T)),
+                                             sizeof(T)));
         }
 
         /// @brief Upload uniform objects to the GPU
@@ -94,19 +138,14 @@ namespace vgi {
         /// @param src Elements to be uploaded
         /// @param current_frame Frame for which the uniform buffer information will be updated
         inline void write(const window& parent, const T& src, uint32_t current_frame) {
-            VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
-            vk::detail::resultCheck(static_cast<vk::Result>(vmaCopyMemoryToAllocation(
-                                            parent, std::addressof(src), this->allocation,
-                                            static_cast<vk::DeviceSize>(current_frame) *
-                                                    static_cast<vk::DeviceSize>(sizeof(T)),
-                                            sizeof(T))),
-                                    __FUNCTION__);
+            this->data(current_frame)[0] = src;
+            this->flush(parent, current_frame);
         }
 
         /// @brief Destroys the buffer
         /// @param parent Window used to create the buffer
         inline void destroy(const window& parent) && noexcept {
-            vmaDestroyBuffer(parent, this->buffer, this->allocation);
+            parent.destroy_buffer(this->buffer, this->allocation);
         }
 
         /// @brief Casts to the underlying `vk::Buffer`
@@ -122,6 +161,8 @@ namespace vgi {
     private:
         vk::Buffer buffer;
         VmaAllocation allocation = VK_NULL_HANDLE;
+        T* mapped = nullptr;
+        bool coherent = true;
     };
 
     /// @brief A guard that destroys the uniform buffer when dropped.
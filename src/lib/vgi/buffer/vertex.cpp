@@ -1,25 +1,97 @@
 #include "vertex.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <glm/gtc/packing.hpp>
 #include <vgi/math.hpp>
 
 namespace vgi {
-    vertex_buffer::vertex_buffer(const window& parent, vk::DeviceSize size) {
-        std::optional<vk::DeviceSize> byte_size =
-                math::check_mul<vk::DeviceSize>(sizeof(vertex), size);
+    glm::u16vec4 vertex::pack_origin(const glm::vec3& origin) noexcept {
+        return glm::packHalf(glm::vec4{origin, 1.0f});
+    }
+
+    glm::vec3 vertex::unpack_origin(const glm::u16vec4& origin) noexcept {
+        return glm::vec3{glm::unpackHalf(origin)};
+    }
+
+    // Like `glm::sign`, but never returns zero
+    static glm::vec2 sign_not_zero(const glm::vec2& v) noexcept {
+        return glm::vec2{v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f};
+    }
+
+    glm::i16vec2 vertex::pack_normal(const glm::vec3& normal) noexcept {
+        // Project onto the octahedron, and fold the lower hemisphere over the upper one
+        const float norm = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+        if (norm == 0.0f) return glm::i16vec2{0};
+
+        glm::vec2 result = glm::vec2{normal} / norm;
+        if (normal.z < 0.0f) {
+            result = (1.0f - glm::abs(glm::vec2{result.y, result.x})) * sign_not_zero(result);
+        }
+        return glm::packSnorm<int16_t>(result);
+    }
+
+    glm::vec3 vertex::unpack_normal(const glm::i16vec2& normal) noexcept {
+        const glm::vec2 encoded = glm::unpackSnorm<float>(normal);
+        glm::vec3 result{encoded, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y)};
+        if (result.z < 0.0f) {
+            const glm::vec2 folded =
+                    (1.0f - glm::abs(glm::vec2{result.y, result.x})) * sign_not_zero(encoded);
+            result.x = folded.x;
+            result.y = folded.y;
+        }
+        return glm::normalize(result);
+    }
+
+    glm::u8vec4 vertex::pack_color(const glm::vec4& color) noexcept {
+        return glm::packUnorm<uint8_t>(color);
+    }
+
+    glm::u8vec4 vertex::pack_weights(const glm::vec4& weights) noexcept {
+        const float sum = weights.x + weights.y + weights.z + weights.w;
+        if (sum <= 0.0f) return glm::u8vec4{0};
+
+        glm::u8vec4 result = glm::packUnorm<uint8_t>(weights / sum);
+        // Rounding may break the sum of the weights, so the difference is made up by the
+        // strongest one
+        glm::length_t strongest = 0;
+        for (glm::length_t i = 1; i < 4; ++i) {
+            if (result[i] > result[strongest]) strongest = i;
+        }
+        const int total = int{result.x} + int{result.y} + int{result.z} + int{result.w};
+        const int adjusted = int{result[strongest]} + 255 - total;
+        result[strongest] = static_cast<uint8_t>(std::clamp(adjusted, 0, 255));
+        return result;
+    }
+
+    void vertex::copy_positions(std::span<const vertex> vertices, std::byte* dest) noexcept {
+        for (const vertex& value: vertices) {
+            std::memcpy(dest, std::addressof(value.position), sizeof(vertex_position));
+            dest += sizeof(vertex_position);
+        }
+    }
+
+    void vertex::copy_attributes(std::span<const vertex> vertices, std::byte* dest) noexcept {
+        for (const vertex& value: vertices) {
+            std::memcpy(dest, std::addressof(value.attributes), sizeof(vertex_attributes));
+            dest += sizeof(vertex_attributes);
+        }
+    }
+
+    std::pair<const vk::Buffer*, VmaAllocation> create_vertex_buffer(const window& parent,
+                                                                     vk::DeviceSize size,
+                                                                     vk::DeviceSize stride) {
+        std::optional<vk::DeviceSize> byte_size = math::check_mul<vk::DeviceSize>(stride, size);
         if (!byte_size) throw vgi_error{"too many vertices"};
 
-        auto [buffer, allocation] = parent.create_buffer(
+        return parent.create_relocatable_buffer(
                 vk::BufferCreateInfo{
                         .size = byte_size.value(),
                         .usage = vk::BufferUsageFlagBits::eTransferSrc |
                                  vk::BufferUsageFlagBits::eTransferDst |
                                  vk::BufferUsageFlagBits::eVertexBuffer,
                 },
-                VmaAllocationCreateInfo{
-                        .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                });
-
-        this->buffer = buffer;
-        this->allocation = allocation;
+                window::UPLOAD_ALLOCATION_INFO);
     }
 }  // namespace vgi
@@ -1,108 +1,206 @@
 /*! \file */
 #pragma once
 
+#include <array>
 #include <concepts>
+#include <cstddef>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <span>
+#include <tuple>
 #include <type_traits>
+#include <vgi/pipeline/vertex_input.hpp>
 #include <vgi/resource.hpp>
 #include <vgi/vulkan.hpp>
 #include <vgi/window.hpp>
 
 namespace vgi {
-    /// @brief Represents a meshes' vertex on device memory
-    struct vertex {
-        /// @brief Position
-        glm::vec3 origin;
-        /// @brief RGBA color
-        glm::vec4 color;
+    /// @brief Position stream of a vertex on device memory
+    /// @details Positions are stored apart from the other attributes, so that passes which only
+    /// need positions (depth pre-passes, shadows, picking) only fetch a quarter of every vertex.
+    struct vertex_position {
+        /// @brief Shader input location of `origin`
+        constexpr static inline const uint32_t ORIGIN = 0;
+
+        /// @brief Position, as half-precision floats (with a `w` of one)
+        glm::u16vec4 origin;
+
+        /// @brief Layout of the stream's attributes
+        /// @sa vgi::vertex_layout
+        constexpr static std::array<vertex_attribute, 1> attributes() noexcept {
+            return {{
+                    {
+                            .location = ORIGIN,
+                            .format = vk::Format::eR16G16B16A16Sfloat,
+                            .offset = offsetof(vertex_position, origin),
+                    },
+            }};
+        }
+    };
+    static_assert(sizeof(vertex_position) == 8);
+    static_assert(vertex_layout<vertex_position>);
+
+    /// @brief Attribute stream of a vertex on device memory, with everything but its position
+    /// @details Attributes are stored in a compact, quantized format, which the vertex input stage
+    /// expands back to floats. Only normals must be decoded by shaders, since they are
+    /// octahedral-encoded.
+    struct vertex_attributes {
+        /// @brief Shader input location of `color`
+        constexpr static inline const uint32_t COLOR = 1;
+        /// @brief Shader input location of `tex`
+        constexpr static inline const uint32_t TEX = 2;
+        /// @brief Shader input location of `normal`
+        constexpr static inline const uint32_t NORMAL = 3;
+        /// @brief Shader input location of `joints`
+        constexpr static inline const uint32_t JOINTS = 4;
+        /// @brief Shader input location of `weights`
+        constexpr static inline const uint32_t WEIGHTS = 5;
+
         /// @brief Texture coordinates
         glm::vec2 tex;
-        /// @brief Normal vector
-        glm::vec3 normal;
+        /// @brief Octahedral-encoded normal vector, as signed normalized 16-bit integers
+        glm::i16vec2 normal;
+        /// @brief RGBA color, as unsigned normalized 8-bit integers
+        glm::u8vec4 color;
         /// @brief Indices of the joints
-        glm::uvec4 joints{0};
-        /// @brief How strongly the joint influences the vertex
-        glm::vec4 weights{0.0f};
-
-        //! @cond Doxygen_Supress
-        constexpr static vk::VertexInputBindingDescription input_binding(
-                uint32_t binding = 0,
-                vk::VertexInputRate input_rate = vk::VertexInputRate::eVertex) noexcept {
-            return vk::VertexInputBindingDescription{
-                    .binding = binding,
-                    .stride = sizeof(vertex),
-                    .inputRate = input_rate,
-            };
-        }
+        glm::u8vec4 joints{0};
+        /// @brief How strongly the joint influences the vertex, as unsigned normalized 8-bit
+        /// integers
+        glm::u8vec4 weights{0};
 
-        constexpr static std::array<vk::VertexInputAttributeDescription, 6> input_attributes(
-                uint32_t binding = 0) noexcept {
+        /// @brief Layout of the stream's attributes
+        /// @sa vgi::vertex_layout
+        constexpr static std::array<vertex_attribute, 5> attributes() noexcept {
             return {{
                     {
-                            .location = 0,
-                            .binding = binding,
-                            .format = vk::Format::eR32G32B32Sfloat,
-                            .offset = offsetof(vertex, origin),
-                    },
-                    {
-                            .location = 1,
-                            .binding = binding,
-                            .format = vk::Format::eR32G32B32A32Sfloat,
-                            .offset = offsetof(vertex, color),
+                            .location = COLOR,
+                            .format = vk::Format::eR8G8B8A8Unorm,
+                            .offset = offsetof(vertex_attributes, color),
                     },
                     {
-                            .location = 2,
-                            .binding = binding,
+                            .location = TEX,
                             .format = vk::Format::eR32G32Sfloat,
-                            .offset = offsetof(vertex, tex),
+                            .offset = offsetof(vertex_attributes, tex),
                     },
                     {
-                            .location = 3,
-                            .binding = binding,
-                            .format = vk::Format::eR32G32B32Sfloat,
-                            .offset = offsetof(vertex, normal),
+                            .location = NORMAL,
+                            .format = vk::Format::eR16G16Snorm,
+                            .offset = offsetof(vertex_attributes, normal),
                     },
                     {
-                            .location = 4,
-                            .binding = binding,
-                            .format = vk::Format::eR32G32B32A32Uint,
-                            .offset = offsetof(vertex, joints),
+                            .location = JOINTS,
+                            .format = vk::Format::eR8G8B8A8Uint,
+                            .offset = offsetof(vertex_attributes, joints),
                     },
                     {
-                            .location = 5,
-                            .binding = binding,
-                            .format = vk::Format::eR32G32B32A32Sfloat,
-                            .offset = offsetof(vertex, weights),
+                            .location = WEIGHTS,
+                            .format = vk::Format::eR8G8B8A8Unorm,
+                            .offset = offsetof(vertex_attributes, weights),
                     },
             }};
         }
     };
+    static_assert(sizeof(vertex_attributes) == 24);
+    static_assert(vertex_layout<vertex_attributes>);
+
+    /// @brief Represents a meshes' vertex, with both of its streams
+    /// @details Vertices are only assembled on the host. On device memory, their position and
+    /// attribute streams are stored in separate buffers.
+    struct vertex {
+        /// @brief Position of the vertex
+        vertex_position position;
+        /// @brief Remaining attributes of the vertex
+        vertex_attributes attributes;
+
+        /// @brief Default constructor
+        vertex() = default;
+
+        /// @brief Creates a new vertex, quantizing its attributes
+        /// @param origin Position
+        /// @param color RGBA color
+        /// @param tex Texture coordinates
+        /// @param normal Normal vector
+        /// @param joints Indices of the joints
+        /// @param weights How strongly the joint influences the vertex
+        inline vertex(const glm::vec3& origin, const glm::vec4& color, const glm::vec2& tex,
+                      const glm::vec3& normal, const glm::u8vec4& joints = glm::u8vec4{0},
+                      const glm::vec4& weights = glm::vec4{0.0f}) noexcept :
+            position{.origin = pack_origin(origin)},
+            attributes{
+                    .tex = tex,
+                    .normal = pack_normal(normal),
+                    .color = pack_color(color),
+                    .joints = joints,
+                    .weights = pack_weights(weights),
+            } {}
+
+        /// @brief Quantizes a position
+        static glm::u16vec4 pack_origin(const glm::vec3& origin) noexcept;
+        /// @brief Decodes a quantized position
+        static glm::vec3 unpack_origin(const glm::u16vec4& origin) noexcept;
+        /// @brief Octahedral-encodes a normal vector
+        /// @param normal Normal vector. Needs not be normalized.
+        static glm::i16vec2 pack_normal(const glm::vec3& normal) noexcept;
+        /// @brief Decodes an octahedral-encoded normal vector
+        static glm::vec3 unpack_normal(const glm::i16vec2& normal) noexcept;
+        /// @brief Quantizes a color
+        static glm::u8vec4 pack_color(const glm::vec4& color) noexcept;
+        /// @brief Quantizes the joint weights, making sure they still add up to one
+        static glm::u8vec4 pack_weights(const glm::vec4& weights) noexcept;
+
+        /// @brief Copies the position stream of some vertices
+        /// @param vertices Vertices to be copied
+        /// @param dest Memory with room for `vertices.size()` positions. Needs not be aligned.
+        static void copy_positions(std::span<const vertex> vertices, std::byte* dest) noexcept;
+        /// @brief Copies the attribute stream of some vertices
+        /// @param vertices Vertices to be copied
+        /// @param dest Memory with room for `vertices.size()` attributes. Needs not be aligned.
+        static void copy_attributes(std::span<const vertex> vertices, std::byte* dest) noexcept;
+    };
+    static_assert(sizeof(vertex) == sizeof(vertex_position) + sizeof(vertex_attributes));
+
+    /// @brief Vertex input of pipelines that fetch both vertex streams, with positions on
+    /// `binding` and the remaining attributes on `binding + 1`
+    /// @param binding Binding the positions are fetched from
+    constexpr vertex_input split_vertex_input(uint32_t binding = 0) noexcept {
+        return vertex_input::of<vertex_position>(binding).with<vertex_attributes>(binding + 1);
+    }
+
+    //! @cond Doxygen_Suppress
+    std::pair<const vk::Buffer*, VmaAllocation> create_vertex_buffer(const window& parent,
+                                                                     vk::DeviceSize size,
+                                                                     vk::DeviceSize stride);
     //! @endcond
 
     /// @brief A buffer used to store the vertices of a mesh
-    struct vertex_buffer {
+    /// @tparam V Layout of the vertices
+    template<vertex_layout V>
+    struct basic_vertex_buffer {
         /// @brief Maximum number of vertices a buffer can be made to store
         constexpr static inline const vk::DeviceSize MAX_SIZE =
-                (std::numeric_limits<vk::DeviceSize>::max)() / sizeof(vertex);
+                (std::numeric_limits<vk::DeviceSize>::max)() / sizeof(V);
 
         /// @brief Default constructor.
-        vertex_buffer() = default;
+        basic_vertex_buffer() = default;
         /// @brief Creates a vertex buffer of the specified size
         /// @param parent Window that creates the buffer
         /// @param size Number of vertices the buffer can store
-        vertex_buffer(const window& parent, vk::DeviceSize size);
-        vertex_buffer(const vertex_buffer&) = delete;
-        vertex_buffer& operator=(const vertex_buffer&) = delete;
+        basic_vertex_buffer(const window& parent, vk::DeviceSize size) {
+            std::tie(this->buffer, this->allocation) =
+                    create_vertex_buffer(parent, size, sizeof(V));
+        }
+        basic_vertex_buffer(const basic_vertex_buffer&) = delete;
+        basic_vertex_buffer& operator=(const basic_vertex_buffer&) = delete;
 
         /// @brief Move constructor operator
         /// @param other Value to be moved
-        inline vertex_buffer(vertex_buffer&& other) noexcept :
-            buffer(std::move(other.buffer)),
+        inline basic_vertex_buffer(basic_vertex_buffer&& other) noexcept :
+            buffer(std::exchange(other.buffer, nullptr)),
             allocation(std::exchange(other.allocation, VK_NULL_HANDLE)) {}
 
         /// @brief Move assignment operator
         /// @param other Value to be moved
-        inline vertex_buffer& operator=(vertex_buffer&& other) noexcept {
+        inline basic_vertex_buffer& operator=(basic_vertex_buffer&& other) noexcept {
             if (this == &other) [[unlikely]]
                 return *this;
             std::destroy_at(this);
@@ -118,28 +216,36 @@ namespace vgi {
         inline void bind(vk::CommandBuffer cmdbuf, uint32_t binding = 0,
                          vk::DeviceSize offset = 0) const noexcept {
             VGI_ASSERT(offset <= MAX_SIZE);
-            offset *= sizeof(vertex);
-            cmdbuf.bindVertexBuffers(binding, 1, &this->buffer, &offset);
+            offset *= sizeof(V);
+            cmdbuf.bindVertexBuffers(binding, 1, this->buffer, &offset);
         }
 
         /// @brief Destroys the buffer
         /// @param parent Window used to create the buffer
         inline void destroy(const window& parent) && {
-            vmaDestroyBuffer(parent, this->buffer, this->allocation);
+            if (this->buffer) parent.destroy_buffer(*this->buffer, this->allocation);
         }
 
         /// @brief Casts to the underlying `vk::Buffer`
-        constexpr operator vk::Buffer() const noexcept { return this->buffer; }
+        /// @details Buffers may be replaced by defragmentation, so the result must not be cached
+        /// across frames.
+        constexpr operator vk::Buffer() const noexcept {
+            return this->buffer ? *this->buffer : vk::Buffer{};
+        }
         /// @brief Casts to the underlying `VkBuffer`
-        inline operator VkBuffer() const noexcept { return this->buffer; }
+        inline operator VkBuffer() const noexcept {
+            return this->buffer ? static_cast<VkBuffer>(*this->buffer) : VK_NULL_HANDLE;
+        }
         /// @brief Casts to the underlying `VmaAllocation`
         constexpr operator VmaAllocation() const noexcept { return this->allocation; }
 
     private:
-        vk::Buffer buffer;
+        // Owned by the window, which replaces it when defragmentation moves the buffer
+        const vk::Buffer* buffer = nullptr;
         VmaAllocation allocation = VK_NULL_HANDLE;
     };
 
     /// @brief A guard that destroys the vertex buffer when dropped.
-    using vertex_buffer_guard = resource_guard<vertex_buffer>;
+    template<vertex_layout V>
+    using vertex_buffer_guard = resource_guard<basic_vertex_buffer<V>>;
 }  // namespace vgi
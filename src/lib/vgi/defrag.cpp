@@ -0,0 +1,218 @@
+#include "defrag.hpp"
+
+#include <exception>
+
+#include "alloc.hpp"
+#include "log.hpp"
+#include "window.hpp"
+
+namespace vgi {
+    void defragmenter::start(const window& parent, const defrag_budget& budget) {
+        if (this->running()) {
+            this->stop_requested = false;
+            return;
+        }
+
+        const VmaDefragmentationInfo info{
+                .flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT,
+                .maxBytesPerPass = budget.max_bytes,
+                .maxAllocationsPerPass = budget.max_moves,
+        };
+        VGI_VMA_CHECK(vmaBeginDefragmentation(parent, &info, &this->context));
+        this->budget = budget;
+        this->stop_requested = false;
+    }
+
+    void defragmenter::step(window& parent, uint32_t current_frame) {
+        if (!this->running()) return;
+        if (this->pass_frame) {
+            // The pass may only be completed once the device is done with the frame that recorded
+            // its copies, which also guarantees no earlier frame uses the old buffers anymore.
+            if (*this->pass_frame != current_frame) return;
+            this->end_pass(parent);
+            if (!this->running()) return;
+        }
+        if (this->stop_requested) {
+            this->finish(parent);
+            return;
+        }
+
+        this->pass = {};
+        const VkResult result = vmaBeginDefragmentationPass(parent, this->context, &this->pass);
+        if (result == VK_SUCCESS) {
+            // There is nothing left to move
+            this->finish(parent);
+            return;
+        } else if (result != VK_INCOMPLETE) [[unlikely]] {
+            VGI_VMA_CHECK(result);
+        }
+
+        // Copies are recorded at the head of a new staging batch, so that uploads queued from now
+        // on (which already target the new buffers) land after them, while the ones queued before
+        // (which target the old buffers) are submitted first.
+        staging_ring& staging = parent.staging();
+        staging.submit(parent);
+        const vk::CommandBuffer cmdbuf = staging.record(parent);
+        cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands,
+                               vk::PipelineStageFlagBits::eTransfer, {},
+                               vk::MemoryBarrier{
+                                       .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                                       .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+                               },
+                               {}, {});
+
+        const auto deadline = std::chrono::steady_clock::now() + this->budget.max_time;
+        for (uint32_t i = 0; i < this->pass.moveCount; ++i) {
+            VmaDefragmentationMove& move = this->pass.pMoves[i];
+            auto it = this->buffers.find(move.srcAllocation);
+
+            VmaAllocationInfo info;
+            vmaGetAllocationInfo(parent, move.srcAllocation, &info);
+            if (it == this->buffers.end() || info.pMappedData != nullptr ||
+                std::chrono::steady_clock::now() >= deadline) {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                continue;
+            }
+
+            relocatable& target = it->second;
+            // Buffers must be created and destroyed with the same callbacks VMA uses for its own
+            const vk::Buffer new_buffer = parent->createBuffer(
+                    vk::BufferCreateInfo{
+                            .flags = target.flags,
+                            .size = target.size,
+                            .usage = target.usage,
+                            .sharingMode = vk::SharingMode::eExclusive,
+                    },
+                    host_callbacks(alloc_scope::vma));
+            try {
+                VGI_VMA_CHECK(vmaBindBufferMemory(parent, move.dstTmpAllocation, new_buffer));
+            } catch (...) {
+                parent->destroyBuffer(new_buffer, host_callbacks(alloc_scope::vma));
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                throw;
+            }
+
+            cmdbuf.copyBuffer(target.buffer, new_buffer, vk::BufferCopy{.size = target.size});
+            this->moves.push_back(pending_move{
+                    .index = i, .old_buffer = target.buffer, .new_buffer = new_buffer});
+            // Commands recorded from now on already use the new buffer
+            target.buffer = new_buffer;
+        }
+
+        cmdbuf.pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {},
+                vk::MemoryBarrier{
+                        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                        .dstAccessMask =
+                                vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+                },
+                {}, {});
+        this->pass_frame = current_frame;
+    }
+
+    const vk::Buffer& defragmenter::track(vk::Buffer buffer, VmaAllocation allocation,
+                                          const vk::BufferCreateInfo& create_info) {
+        VGI_ASSERT(create_info.pNext == nullptr);
+        const relocatable value{
+                .buffer = buffer,
+                .flags = create_info.flags,
+                .size = create_info.size,
+                .usage = create_info.usage,
+        };
+        auto [it, inserted] = this->buffers.emplace(allocation, value);
+        VGI_ASSERT(inserted);
+        return it->second.buffer;
+    }
+
+    bool defragmenter::release(vk::Buffer buffer, VmaAllocation allocation) noexcept {
+        this->buffers.erase(allocation);
+
+        // Buffers being moved are destroyed alongside the pass, since the device may still be
+        // copying them, and so is their memory.
+        for (auto it = this->moves.begin(); it != this->moves.end(); ++it) {
+            VmaDefragmentationMove& move = this->pass.pMoves[it->index];
+            if (move.srcAllocation != allocation) continue;
+
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+            this->retired.push_back(it->old_buffer);
+            this->retired.push_back(it->new_buffer);
+            this->moves.erase(it);
+            return true;
+        }
+
+        // Any other allocation of the pass is freed by VMA when the pass is completed
+        if (VmaDefragmentationMove* move = this->find_move(allocation)) {
+            move->operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+            this->retired.push_back(buffer);
+            return true;
+        }
+        return false;
+    }
+
+    bool defragmenter::release(vk::Image image, VmaAllocation allocation) noexcept {
+        if (VmaDefragmentationMove* move = this->find_move(allocation)) {
+            move->operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+            this->retired_images.push_back(image);
+            return true;
+        }
+        return false;
+    }
+
+    VmaDefragmentationMove* defragmenter::find_move(VmaAllocation allocation) noexcept {
+        if (!this->pass_frame || allocation == VK_NULL_HANDLE) return nullptr;
+        for (uint32_t i = 0; i < this->pass.moveCount; ++i) {
+            if (this->pass.pMoves[i].srcAllocation == allocation) return &this->pass.pMoves[i];
+        }
+        return nullptr;
+    }
+
+    void defragmenter::destroy(const window& parent) && noexcept {
+        if (this->pass_frame) {
+            try {
+                this->end_pass(parent);
+            } catch (const std::exception& e) {
+                vgi::log_warn("Error completing defragmentation pass: {}", e.what());
+            } catch (...) {
+                vgi::log_warn("Unexpected error completing defragmentation pass");
+            }
+        }
+        this->finish(parent);
+        this->buffers.clear();
+    }
+
+    void defragmenter::end_pass(const window& parent) {
+        VGI_ASSERT(this->pass_frame.has_value());
+        const bool moved = !this->moves.empty() || !this->retired.empty();
+
+        // The memory of the old buffers is released by VMA
+        const vk::AllocationCallbacks* callbacks = host_callbacks(alloc_scope::vma);
+        for (const pending_move& move: this->moves) {
+            parent->destroyBuffer(move.old_buffer, callbacks);
+        }
+        for (vk::Buffer buffer: this->retired) parent->destroyBuffer(buffer, callbacks);
+        for (vk::Image image: this->retired_images) parent->destroyImage(image, callbacks);
+        this->moves.clear();
+        this->retired.clear();
+        this->retired_images.clear();
+        this->pass_frame.reset();
+
+        const VkResult result = vmaEndDefragmentationPass(parent, this->context, &this->pass);
+        // Stop once everything has been moved, or when none of the proposed moves was possible
+        if (result == VK_SUCCESS || !moved) {
+            this->finish(parent);
+        } else if (result != VK_INCOMPLETE) [[unlikely]] {
+            VGI_VMA_CHECK(result);
+        }
+    }
+
+    void defragmenter::finish(const window& parent) noexcept {
+        if (!this->running()) return;
+        VGI_ASSERT(!this->pass_frame.has_value());
+
+        VmaDefragmentationStats stats;
+        vmaEndDefragmentation(parent, std::exchange(this->context, VK_NULL_HANDLE), &stats);
+        this->stop_requested = false;
+        vgi::log_dbg("Defragmentation moved {} allocations ({} bytes), releasing {} bytes",
+                     stats.allocationsMoved, stats.bytesMoved, stats.bytesFreed);
+    }
+}  // namespace vgi
@@ -0,0 +1,144 @@
+/*! \file */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <vgi/defs.hpp>
+#include <vgi/forward.hpp>
+#include <vgi/vgi.hpp>
+#include <vgi/vulkan.hpp>
+
+namespace vgi {
+    /// @brief Limits of a single incremental defragmentation pass
+    struct defrag_budget {
+        /// @brief Maximum number of bytes moved by a pass. Zero means no limit.
+        vk::DeviceSize max_bytes = 16 * 1024 * 1024;
+        /// @brief Maximum number of allocations moved by a pass. Zero means no limit.
+        uint32_t max_moves = 64;
+        /// @brief Maximum host time spent recording the moves of a pass. Once exceeded, the
+        /// remaining moves of the pass are skipped.
+        std::chrono::microseconds max_time{500};
+    };
+
+    /// @brief Incrementally compacts the device memory of a window, one pass at a time
+    /// @details Every pass records the copies of the allocations it moves at the start of a
+    /// frame, before any upload staged during the frame, and is completed once the device has finished with that frame (when its slot is
+    /// reused), so defragmenting never stalls the device.
+    ///
+    /// Only relocatable buffers (see `window::create_relocatable_buffer`) are ever moved. Their
+    /// `vk::Buffer` is owned by the defragmenter, and replaced by a new one bound to the new
+    /// memory as soon as the move is recorded. Persistently mapped buffers are never moved, since
+    /// the host may write to their old memory while the move is in flight, and neither are images,
+    /// since their views may be referenced by descriptor sets.
+    class defragmenter {
+    public:
+        /// @brief Default constructor
+        defragmenter() = default;
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        defragmenter(defragmenter&& other) noexcept :
+            buffers(std::move(other.buffers)),
+            context(std::exchange(other.context, VK_NULL_HANDLE)), budget(other.budget),
+            pass(std::exchange(other.pass, {})),
+            pass_frame(std::exchange(other.pass_frame, std::nullopt)),
+            moves(std::move(other.moves)), retired(std::move(other.retired)),
+            retired_images(std::move(other.retired_images)),
+            stop_requested(std::exchange(other.stop_requested, false)) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        defragmenter& operator=(defragmenter&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Whether a defragmentation is in progress
+        constexpr bool running() const noexcept { return this->context != VK_NULL_HANDLE; }
+
+        /// @brief Starts a new defragmentation, if none is in progress
+        /// @param parent Window that owns the defragmenter
+        /// @param budget Limits of every pass
+        void start(const window& parent, const defrag_budget& budget);
+
+        /// @brief Stops the defragmentation once the pass in flight, if any, is completed
+        void stop() noexcept { this->stop_requested = this->running(); }
+
+        /// @brief Completes the pass of the frame (if any), and starts a new one
+        /// @details The copies of the new pass are recorded into the window's staging ring, ahead
+        /// of any upload queued afterwards, and submitted alongside the frame.
+        /// @param parent Window that owns the defragmenter
+        /// @param current_frame Index of the frame. The device must have finished its previous use.
+        void step(window& parent, uint32_t current_frame);
+
+        /// @brief Registers a new relocatable buffer
+        /// @param buffer Buffer bound to `allocation`
+        /// @param allocation Allocation of the buffer
+        /// @param create_info Information used to create the buffer, used to create it again
+        /// whenever it's moved
+        /// @return Handle that always holds the current buffer of the allocation
+        const vk::Buffer& track(vk::Buffer buffer, VmaAllocation allocation,
+                                const vk::BufferCreateInfo& create_info);
+
+        /// @brief Unregisters a buffer that is about to be destroyed
+        /// @details The pass in flight proposes moves for every kind of allocation (even the ones
+        /// it ignores), and VMA reads them when the pass is completed, so allocations referenced
+        /// by the pass may only be released alongside it.
+        /// @param buffer Buffer bound to `allocation`
+        /// @param allocation Allocation of the buffer
+        /// @return `true` if the defragmenter takes care of destroying the buffer and its memory,
+        /// because its allocation is referenced by the pass in flight, `false` otherwise
+        bool release(vk::Buffer buffer, VmaAllocation allocation) noexcept;
+
+        /// @brief Unregisters an image that is about to be destroyed
+        /// @param image Image bound to `allocation`
+        /// @param allocation Allocation of the image
+        /// @return `true` if the defragmenter takes care of destroying the image and its memory,
+        /// because its allocation is referenced by the pass in flight, `false` otherwise
+        /// @sa release(vk::Buffer, VmaAllocation)
+        bool release(vk::Image image, VmaAllocation allocation) noexcept;
+
+        /// @brief Completes any pending work and stops the defragmentation
+        /// @param parent Window that owns the defragmenter
+        /// @warning The device must be idle
+        void destroy(const window& parent) && noexcept;
+
+        defragmenter(const defragmenter&) = delete;
+        defragmenter& operator=(const defragmenter&) = delete;
+
+    private:
+        struct relocatable {
+            vk::Buffer buffer;
+            vk::BufferCreateFlags flags;
+            vk::DeviceSize size;
+            vk::BufferUsageFlags usage;
+        };
+
+        struct pending_move {
+            uint32_t index;
+            vk::Buffer old_buffer;
+            vk::Buffer new_buffer;
+        };
+
+        std::unordered_map<VmaAllocation, relocatable> buffers;
+        VmaDefragmentationContext context = VK_NULL_HANDLE;
+        defrag_budget budget;
+        VmaDefragmentationPassMoveInfo pass{};
+        std::optional<uint32_t> pass_frame;
+        std::vector<pending_move> moves;
+        std::vector<vk::Buffer> retired;
+        std::vector<vk::Image> retired_images;
+        bool stop_requested = false;
+
+        VmaDefragmentationMove* find_move(VmaAllocation allocation) noexcept;
+        void end_pass(const window& parent);
+        void finish(const window& parent) noexcept;
+    };
+}  // namespace vgi
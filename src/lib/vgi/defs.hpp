@@ -14,6 +14,49 @@
 #define VGI_MAX_FRAMES_IN_FLIGHT 2
 #endif
 
+#ifdef VGI_TRANSIENT_BUFFER_SIZE
+#if VGI_TRANSIENT_BUFFER_SIZE <= 0
+#error "Transient buffer size must be a positive integer greater than zero"
+#endif
+#else
+/// @brief Number of bytes of transient memory that can be allocated for each frame in flight.
+#define VGI_TRANSIENT_BUFFER_SIZE (4 * 1024 * 1024)
+#endif
+
+#ifdef VGI_STAGING_BUFFER_SIZE
+#if VGI_STAGING_BUFFER_SIZE <= 0
+#error "Staging buffer size must be a positive integer greater than zero"
+#endif
+#else
+/// @brief Number of bytes of host memory used to stream uploads to the device.
+#define VGI_STAGING_BUFFER_SIZE (16 * 1024 * 1024)
+#endif
+
+#ifdef VGI_GEOMETRY_PAGE_SIZE
+#if VGI_GEOMETRY_PAGE_SIZE <= 0
+#error "Geometry page size must be a positive integer greater than zero"
+#endif
+#else
+/// @brief Number of bytes of vertex memory of every page of a window's geometry pool. Each page
+/// also has a quarter of that memory for indices.
+#define VGI_GEOMETRY_PAGE_SIZE (64 * 1024 * 1024)
+#endif
+
+#ifdef VGI_FRAME_ARENA_SIZE
+#if VGI_FRAME_ARENA_SIZE <= 0
+#error "Frame arena size must be a positive integer greater than zero"
+#endif
+#else
+/// @brief Number of bytes of host memory initially reserved by each frame in flight for scratch
+/// data. Arenas grow as needed, and keep their memory for the following frames.
+#define VGI_FRAME_ARENA_SIZE (256 * 1024)
+#endif
+
+#ifndef VGI_HOST_ALLOCATOR
+/// @brief Whether the host allocations of Vulkan, VMA and SDL are routed through vgi's allocator
+#define VGI_HOST_ALLOCATOR 1
+#endif
+
 #ifndef VGI_CONCAT
 /// @brief Concatenates two identifers. Useful for code generating macros
 #define VGI_CONCAT(x, y) VGI_CONCAT_(x, y)
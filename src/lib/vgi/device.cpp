@@ -23,9 +23,14 @@ namespace vgi {
 
     bool device::is_supported() const noexcept {
         // Check that all required features are supported
+        const auto& feats_1_2 = this->feats_chain.get<vk::PhysicalDeviceVulkan12Features>();
         const auto& feats_1_3 = this->feats_chain.get<vk::PhysicalDeviceVulkan13Features>();
 
-        if (!feats_1_3.dynamicRendering) {
+        if (!feats_1_2.bufferDeviceAddress) {
+            log_warn("Device '{}' does not support the feature 'bufferDeviceAddress'",
+                     this->name());
+            return false;
+        } else if (!feats_1_3.dynamicRendering) {
             log_warn("Device '{}' does not support the feature 'dynamicRendering'", this->name());
             return false;
         } else if (!feats_1_3.synchronization2) {
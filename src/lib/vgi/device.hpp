@@ -51,6 +51,10 @@ namespace vgi {
         inline const vk::PhysicalDeviceFeatures& feats() const noexcept {
             return this->feats_chain.get<vk::PhysicalDeviceFeatures2>().features;
         }
+        /// @brief Features of the device introduced in Vulkan 1.2
+        inline const vk::PhysicalDeviceVulkan12Features& feats_1_2() const noexcept {
+            return this->feats_chain.get<vk::PhysicalDeviceVulkan12Features>();
+        }
 
         /// @brief Iterator over all the queue family properties
         /// @return Iterator of `const vk::QueueFamilyProperties&`
@@ -0,0 +1,103 @@
+#include "draw_list.hpp"
+
+#include <algorithm>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "arena.hpp"
+#include "buffer/transient.hpp"
+#include "math.hpp"
+#include "memory.hpp"
+#include "vgi.hpp"
+
+namespace vgi {
+    uint32_t draw_list::add_transform(const glm::mat4& transform) {
+        std::optional<uint32_t> index = math::check_cast<uint32_t>(this->transforms.size());
+        if (!index) throw vgi_error{"too many transforms"};
+        this->transforms.push_back(transform);
+        return *index;
+    }
+
+    void draw_list::add(const geometry_range& range, uint32_t transform, uint32_t material) {
+        VGI_ASSERT(range);
+        VGI_ASSERT(transform < this->transforms.size());
+        if (this->entries.size() >= UINT32_MAX) throw vgi_error{"too many draws"};
+        this->entries.push_back(entry{
+                .range = range,
+                .data = draw_data{.transform = transform, .material = material},
+        });
+    }
+
+    void draw_list::record(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                           vk::PipelineLayout layout, const vk::PushConstantRange& push_constants,
+                           vertex_streams streams) {
+        if (this->entries.empty()) return;
+        VGI_ASSERT(push_constants.size >= sizeof(draw_list_constants));
+
+        // Draws of the same page are recorded together, in the order they were added. They are
+        // bucketed with a counting sort, whose scratch only lives until the end of the frame.
+        frame_arena& arena = parent.arena();
+        uint32_t page_count = 0;
+        for (const entry& value: this->entries) {
+            page_count = (std::max)(page_count, value.range.page + 1);
+        }
+        std::pmr::vector<uint32_t> firsts(page_count + 1, 0, arena.allocator<uint32_t>());
+        for (const entry& value: this->entries) ++firsts[value.range.page + 1];
+        for (uint32_t page = 0; page < page_count; ++page) firsts[page + 1] += firsts[page];
+
+        std::pmr::vector<uint32_t> heads(firsts.begin(), firsts.end() - 1,
+                                         arena.allocator<uint32_t>());
+        unique_span<uint32_t> order =
+                make_unique_span_for_overwrite<uint32_t>(this->entries.size(), arena);
+        for (uint32_t i = 0; i < this->entries.size(); ++i) {
+            order[heads[this->entries[i].range.page]++] = i;
+        }
+
+        // The instance index of every draw is its position once sorted
+        transient_buffer& transient = parent.transient();
+        transient_slice<glm::mat4> transforms =
+                transient.push(current_frame, std::span<const glm::mat4>{this->transforms});
+        transient_slice<draw_data> draws =
+                transient.allocate<draw_data>(current_frame, this->entries.size());
+        transient_slice<vk::DrawIndexedIndirectCommand> commands =
+                transient.allocate<vk::DrawIndexedIndirectCommand>(current_frame,
+                                                                   this->entries.size());
+        for (uint32_t i = 0; i < this->entries.size(); ++i) {
+            const entry& value = this->entries[order[i]];
+            draws.data[i] = value.data;
+            commands.data[i] = value.range.indirect(1, i);
+        }
+
+        const draw_list_constants constants{
+                .draws = draws.address,
+                .transforms = transforms.address,
+        };
+        cmdbuf.pushConstants(layout, push_constants.stageFlags, push_constants.offset,
+                             sizeof(constants), static_cast<const void*>(&constants));
+
+        const vk::PhysicalDeviceFeatures& feats = parent.device().feats();
+        const bool indirect = feats.multiDrawIndirect && feats.drawIndirectFirstInstance;
+        for (uint32_t page = 0; page < page_count; ++page) {
+            const uint32_t first = firsts[page];
+            const uint32_t last = firsts[page + 1];
+            if (first == last) continue;
+
+            this->entries[order[first]].range.bind(cmdbuf, 0, streams);
+            if (indirect) {
+                cmdbuf.drawIndexedIndirect(
+                        commands.buffer,
+                        commands.offset + first * sizeof(vk::DrawIndexedIndirectCommand),
+                        last - first, sizeof(vk::DrawIndexedIndirectCommand));
+            } else {
+                for (uint32_t i = first; i < last; ++i) {
+                    const vk::DrawIndexedIndirectCommand& command = commands.data[i];
+                    cmdbuf.drawIndexed(command.indexCount, command.instanceCount,
+                                       command.firstIndex, command.vertexOffset,
+                                       command.firstInstance);
+                }
+            }
+        }
+    }
+}  // namespace vgi
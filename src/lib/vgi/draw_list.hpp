@@ -0,0 +1,122 @@
+/*! \file */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+#include <vgi/buffer/geometry.hpp>
+#include <vgi/vulkan.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    /// @brief Per-draw data of a `vgi::draw_list`, as read by shaders
+    struct draw_data {
+        /// @brief Index of the draw's model matrix within the transforms of the list
+        uint32_t transform;
+        /// @brief Index of the draw's material, as defined by the application
+        uint32_t material;
+    };
+
+    /// @brief Device addresses of the data of a `vgi::draw_list`, written as push constants
+    struct draw_list_constants {
+        /// @brief Address of the `vgi::draw_data` of every draw
+        vk::DeviceAddress draws;
+        /// @brief Address of the model matrices of the list
+        vk::DeviceAddress transforms;
+    };
+
+    /// @brief Collects the draws of a frame, and records them with a handful of commands
+    /// @details Draws are batched by geometry page, and every batch is recorded with a single
+    /// bind and a single `vkCmdDrawIndexedIndirect`. Per-draw data is packed into the window's
+    /// transient buffer (with any scratch of the packing allocated from `window::arena`), and
+    /// shaders find it through the `gl_InstanceIndex` of the draw, and the device addresses
+    /// pushed by `record`:
+    ///
+    /// ```glsl
+    /// #extension GL_EXT_buffer_reference : require
+    ///
+    /// layout (buffer_reference, std430) readonly buffer Draws { uvec2 draws[]; };
+    /// layout (buffer_reference, std430) readonly buffer Transforms { mat4 transforms[]; };
+    /// layout (push_constant, std430) uniform PC { Draws draws; Transforms transforms; };
+    ///
+    /// uvec2 draw = draws.draws[gl_InstanceIndex]; // Transform and material indices
+    /// mat4 model = transforms.transforms[draw.x];
+    /// ```
+    ///
+    /// Devices without `multiDrawIndirect` or `drawIndirectFirstInstance` fall back to one
+    /// `vkCmdDrawIndexed` per draw, which is still free of per-draw binds and push constants.
+    class draw_list {
+    public:
+        /// @brief Push constant range written by `record`
+        /// @param offset Offset of the range within the pipeline's push constants
+        /// @param stages Shader stages that read the draw data
+        constexpr static vk::PushConstantRange push_constant_range(
+                uint32_t offset = 0,
+                vk::ShaderStageFlags stages = vk::ShaderStageFlagBits::eVertex) noexcept {
+            return vk::PushConstantRange{
+                    .stageFlags = stages,
+                    .offset = offset,
+                    .size = sizeof(draw_list_constants),
+            };
+        }
+
+        /// @brief Default constructor
+        draw_list() = default;
+
+        /// @brief Number of draws in the list
+        inline size_t size() const noexcept { return this->entries.size(); }
+        /// @brief Checks whether the list has no draws
+        inline bool empty() const noexcept { return this->entries.empty(); }
+
+        /// @brief Adds a model matrix, which may be shared by many draws
+        /// @param transform Model matrix
+        /// @return Index of the matrix within the list
+        uint32_t add_transform(const glm::mat4& transform);
+
+        /// @brief Adds a draw of a geometry range
+        /// @param range Range to be drawn
+        /// @param transform Index of the draw's model matrix (see `add_transform`)
+        /// @param material Index of the draw's material
+        void add(const geometry_range& range, uint32_t transform, uint32_t material = 0);
+
+        /// @brief Adds a draw of a geometry range, with its own model matrix
+        /// @param range Range to be drawn
+        /// @param transform Model matrix of the draw
+        /// @param material Index of the draw's material
+        inline void add(const geometry_range& range, const glm::mat4& transform,
+                        uint32_t material = 0) {
+            this->add(range, this->add_transform(transform), material);
+        }
+
+        /// @brief Records all the draws of the list
+        /// @details The pipeline must already be bound, and its layout must include
+        /// `push_constants`.
+        /// @param parent Window that owns the geometry of the draws
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param current_frame Index of the current frame
+        /// @param layout Layout of the bound pipeline
+        /// @param push_constants Push constant range of the list (see `push_constant_range`)
+        /// @param streams Vertex streams to bind
+        /// @throws `vgi::vgi_error` if the frame's transient buffer runs out of memory
+        void record(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                    vk::PipelineLayout layout,
+                    const vk::PushConstantRange& push_constants = push_constant_range(),
+                    vertex_streams streams = vertex_streams::all);
+
+        /// @brief Removes every draw and transform, keeping the memory for the next frame
+        inline void clear() noexcept {
+            this->entries.clear();
+            this->transforms.clear();
+        }
+
+    private:
+        struct entry {
+            geometry_range range;
+            draw_data data;
+        };
+
+        std::vector<entry> entries;
+        std::vector<glm::mat4> transforms;
+    };
+}  // namespace vgi
@@ -5,4 +5,5 @@
 namespace vgi {
     struct window;
     struct frame;
+    struct transfer_buffer;
 }  // namespace vgi
@@ -0,0 +1,114 @@
+/*! \file */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <limits>
+
+namespace vgi::math {
+    /// @brief A bounding sphere
+    /// @details Spheres with a negative radius are empty, and contain nothing at all.
+    struct sphere {
+        /// @brief Center of the sphere
+        glm::vec3 center{0.0f};
+        /// @brief Radius of the sphere
+        float radius = -1.0f;
+
+        /// @brief Checks whether the sphere is empty
+        constexpr bool empty() const noexcept { return this->radius < 0.0f; }
+
+        /// @brief Grows the sphere so that it also contains another one
+        /// @param other Sphere to be contained
+        inline void extend(const sphere& other) noexcept {
+            if (other.empty()) return;
+            if (this->empty()) {
+                *this = other;
+                return;
+            }
+
+            const glm::vec3 offset = other.center - this->center;
+            const float distance = glm::length(offset);
+            if (distance + other.radius <= this->radius) return;
+            if (distance + this->radius <= other.radius) {
+                *this = other;
+                return;
+            }
+
+            const float radius = 0.5f * (distance + this->radius + other.radius);
+            this->center += offset * ((radius - this->radius) / distance);
+            this->radius = radius;
+        }
+
+        /// @brief Bounding sphere of the sphere, after an affine transformation
+        /// @details Non-uniform scales grow the sphere by the largest of them.
+        /// @param transform Affine transformation matrix
+        inline sphere transform(const glm::mat4& transform) const noexcept {
+            if (this->empty()) return *this;
+            const float scale = std::sqrt((std::max)({
+                    glm::dot(glm::vec3{transform[0]}, glm::vec3{transform[0]}),
+                    glm::dot(glm::vec3{transform[1]}, glm::vec3{transform[1]}),
+                    glm::dot(glm::vec3{transform[2]}, glm::vec3{transform[2]}),
+            }));
+            return sphere{
+                    .center = glm::vec3{transform * glm::vec4{this->center, 1.0f}},
+                    .radius = this->radius * scale,
+            };
+        }
+    };
+    static_assert(sizeof(sphere) == 4 * sizeof(float));
+
+    /// @brief An axis-aligned bounding box
+    /// @details A default-constructed box is empty, and becomes valid once it's extended with a
+    /// point or another box.
+    struct aabb {
+        /// @brief Minimum corner of the box
+        glm::vec3 min{(std::numeric_limits<float>::max)()};
+        /// @brief Maximum corner of the box
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+        /// @brief Checks whether the box is empty
+        constexpr bool empty() const noexcept {
+            return this->min.x > this->max.x || this->min.y > this->max.y ||
+                   this->min.z > this->max.z;
+        }
+
+        /// @brief Center of the box
+        inline glm::vec3 center() const noexcept { return 0.5f * (this->min + this->max); }
+        /// @brief Half of the size of the box, along every axis
+        inline glm::vec3 extent() const noexcept { return 0.5f * (this->max - this->min); }
+
+        /// @brief Grows the box so that it also contains a point
+        /// @param point Point to be contained
+        inline void extend(const glm::vec3& point) noexcept {
+            this->min = glm::min(this->min, point);
+            this->max = glm::max(this->max, point);
+        }
+
+        /// @brief Grows the box so that it also contains another one
+        /// @param other Box to be contained
+        inline void extend(const aabb& other) noexcept {
+            this->min = glm::min(this->min, other.min);
+            this->max = glm::max(this->max, other.max);
+        }
+
+        /// @brief Bounding box of the box, after an affine transformation
+        /// @param transform Affine transformation matrix
+        inline aabb transform(const glm::mat4& transform) const noexcept {
+            if (this->empty()) return *this;
+            // The extent of the result is the extent of the box, projected onto every axis
+            const glm::mat3 basis{transform};
+            const glm::vec3 center = glm::vec3{transform * glm::vec4{this->center(), 1.0f}};
+            const glm::vec3 extent = glm::mat3{glm::abs(basis[0]), glm::abs(basis[1]),
+                                               glm::abs(basis[2])} *
+                                     this->extent();
+            return aabb{.min = center - extent, .max = center + extent};
+        }
+
+        /// @brief Sphere that contains the whole box
+        inline sphere bounding_sphere() const noexcept {
+            if (this->empty()) return sphere{};
+            return sphere{.center = this->center(), .radius = glm::length(this->extent())};
+        }
+    };
+}  // namespace vgi::math
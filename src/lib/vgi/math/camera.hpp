@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cmath>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <vgi/forward.hpp>
+#include <vgi/math/frustum.hpp>
 #include <vgi/vulkan.hpp>
 
 namespace vgi::math {
@@ -111,6 +113,32 @@ namespace vgi::math {
         inline glm::mat4 projection(const vk::Extent2D& extent) const noexcept {
             return this->projection(extent.width, extent.height);
         }
+
+        /// @brief Size on screen, in pixels, of a unit of length one unit away from the camera
+        /// @details Dividing it by the distance to an object gives the number of pixels per unit
+        /// of length at the object's position.
+        /// @param height Height of the projection region, in pixels
+        inline float projection_scale(float height) const noexcept {
+            return 0.5f * height / std::tan(0.5f * this->fovy);
+        }
+
+        /// @brief Size on screen, in pixels, of a unit of length one unit away from the camera
+        /// @param extent Extent of the projection region
+        inline float projection_scale(const vk::Extent2D& extent) const noexcept {
+            return this->projection_scale(static_cast<float>(extent.height));
+        }
+
+        /// @brief Returns the frustum of the camera, in world space
+        /// @param aspect Aspect ratio of the projection region
+        inline math::frustum view_frustum(float aspect) const noexcept {
+            return math::frustum{this->projection(aspect) * this->view()};
+        }
+
+        /// @brief Returns the frustum of the camera, in world space
+        /// @param extent Extent of the projection region
+        inline math::frustum view_frustum(const vk::Extent2D& extent) const noexcept {
+            return math::frustum{this->projection(extent) * this->view()};
+        }
     };
 
     /// @brief A camera with orthographic projection
@@ -0,0 +1,113 @@
+#include "frustum.hpp"
+
+#include <vgi/arch.hpp>
+#include <vgi/defs.hpp>
+
+#if defined(VGI_ARCH_X86_64) || defined(__SSE__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VGI_FRUSTUM_SSE 1
+#include <xmmintrin.h>
+#elif defined(VGI_ARCH_AARCH64)
+#define VGI_FRUSTUM_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace vgi::math {
+    static glm::vec4 normalize_plane(const glm::vec4& plane) noexcept {
+        return plane / glm::length(glm::vec3{plane});
+    }
+
+    frustum::frustum(const glm::mat4& view_projection) noexcept {
+        // Gribb & Hartmann: every plane is a combination of the rows of the matrix
+        const glm::mat4 rows = glm::transpose(view_projection);
+        this->planes[left_plane] = normalize_plane(rows[3] + rows[0]);
+        this->planes[right_plane] = normalize_plane(rows[3] - rows[0]);
+        this->planes[bottom_plane] = normalize_plane(rows[3] + rows[1]);
+        this->planes[top_plane] = normalize_plane(rows[3] - rows[1]);
+        this->planes[near_plane] = normalize_plane(rows[2]);
+        this->planes[far_plane] = normalize_plane(rows[3] - rows[2]);
+    }
+
+    bool frustum::intersects(const sphere& sphere) const noexcept {
+        if (sphere.empty()) return false;
+        for (const glm::vec4& plane: this->planes) {
+            if (glm::dot(glm::vec3{plane}, sphere.center) + plane.w < -sphere.radius) return false;
+        }
+        return true;
+    }
+
+    bool frustum::intersects(const aabb& box) const noexcept {
+        if (box.empty()) return false;
+        for (const glm::vec4& plane: this->planes) {
+            // Test the corner of the box that is furthest along the plane's normal
+            const glm::vec3 corner = glm::mix(box.min, box.max,
+                                              glm::greaterThanEqual(glm::vec3{plane},
+                                                                    glm::vec3{0.0f}));
+            if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0.0f) return false;
+        }
+        return true;
+    }
+
+    size_t frustum::cull(std::span<const sphere> spheres,
+                         std::span<uint32_t> visible) const noexcept {
+        VGI_ASSERT(visible.size() >= spheres.size());
+        VGI_ASSERT(spheres.size() <= UINT32_MAX);
+
+        size_t count = 0;
+        size_t i = 0;
+#if defined(VGI_FRUSTUM_SSE)
+        // Spheres are transposed into registers with the same component of four spheres
+        for (; i + 4 <= spheres.size(); i += 4) {
+            const float* src = reinterpret_cast<const float*>(spheres.data() + i);
+            __m128 x = _mm_loadu_ps(src);
+            __m128 y = _mm_loadu_ps(src + 4);
+            __m128 z = _mm_loadu_ps(src + 8);
+            __m128 radius = _mm_loadu_ps(src + 12);
+            _MM_TRANSPOSE4_PS(x, y, z, radius);
+
+            const __m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), radius);
+            __m128 inside = _mm_cmpge_ps(radius, _mm_setzero_ps());
+            for (const glm::vec4& plane: this->planes) {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)),
+                                             _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+                distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, neg_radius));
+            }
+
+            const int mask = _mm_movemask_ps(inside);
+            for (uint32_t j = 0; j < 4; ++j) {
+                visible[count] = static_cast<uint32_t>(i) + j;
+                count += (mask >> j) & 1;
+            }
+        }
+#elif defined(VGI_FRUSTUM_NEON)
+        // Spheres are de-interleaved into registers with the same component of four spheres
+        for (; i + 4 <= spheres.size(); i += 4) {
+            const float32x4x4_t values =
+                    vld4q_f32(reinterpret_cast<const float*>(spheres.data() + i));
+            const float32x4_t neg_radius = vnegq_f32(values.val[3]);
+            uint32x4_t inside = vcgeq_f32(values.val[3], vdupq_n_f32(0.0f));
+            for (const glm::vec4& plane: this->planes) {
+                float32x4_t distance = vdupq_n_f32(plane.w);
+                distance = vmlaq_n_f32(distance, values.val[0], plane.x);
+                distance = vmlaq_n_f32(distance, values.val[1], plane.y);
+                distance = vmlaq_n_f32(distance, values.val[2], plane.z);
+                inside = vandq_u32(inside, vcgeq_f32(distance, neg_radius));
+            }
+
+            uint32_t lanes[4];
+            vst1q_u32(lanes, inside);
+            for (uint32_t j = 0; j < 4; ++j) {
+                visible[count] = static_cast<uint32_t>(i) + j;
+                count += lanes[j] & 1;
+            }
+        }
+#endif
+
+        for (; i < spheres.size(); ++i) {
+            visible[count] = static_cast<uint32_t>(i);
+            count += this->intersects(spheres[i]) ? 1 : 0;
+        }
+        return count;
+    }
+}  // namespace vgi::math
@@ -0,0 +1,54 @@
+/*! \file */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vgi/math/bounds.hpp>
+
+namespace vgi::math {
+    /// @brief The six planes that enclose the volume seen by a camera
+    /// @details Planes are stored as `(normal, distance)`, with their normals facing inwards, so
+    /// that a point `p` is inside the frustum when `dot(plane, vec4(p, 1)) >= 0` for every plane.
+    struct frustum {
+        /// @brief Index of every plane within `planes`
+        enum plane_index : size_t {
+            left_plane,
+            right_plane,
+            bottom_plane,
+            top_plane,
+            near_plane,
+            far_plane,
+        };
+
+        /// @brief Normalized planes of the frustum
+        std::array<glm::vec4, 6> planes{};
+
+        /// @brief Default constructor. The resulting frustum contains everything.
+        frustum() = default;
+
+        /// @brief Extracts the frustum of a view-projection matrix
+        /// @param view_projection Matrix that transforms from world to clip space, with a depth
+        /// range of `[0, 1]`
+        explicit frustum(const glm::mat4& view_projection) noexcept;
+
+        /// @brief Checks whether a sphere is (at least partially) inside the frustum
+        /// @param sphere Sphere to be tested. Empty spheres are never inside.
+        bool intersects(const sphere& sphere) const noexcept;
+
+        /// @brief Checks whether a box is (at least partially) inside the frustum
+        /// @details The test is conservative, so boxes near the corners of the frustum may be
+        /// reported as inside even if they are not.
+        /// @param box Box to be tested. Empty boxes are never inside.
+        bool intersects(const aabb& box) const noexcept;
+
+        /// @brief Tests many spheres against the frustum, four at a time on SIMD-capable targets
+        /// @param spheres Spheres to be tested
+        /// @param visible Output for the indices of the spheres that are inside the frustum. Must
+        /// be at least as long as `spheres`.
+        /// @return Number of spheres inside the frustum, written at the start of `visible`
+        size_t cull(std::span<const sphere> spheres, std::span<uint32_t> visible) const noexcept;
+    };
+}  // namespace vgi::math
@@ -0,0 +1,349 @@
+#include "occlusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vgi/arch.hpp>
+#include <vgi/defs.hpp>
+
+#if defined(VGI_ARCH_X86_64) || defined(__SSE__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VGI_OCCLUSION_SSE 1
+#include <xmmintrin.h>
+#elif defined(VGI_ARCH_AARCH64)
+#define VGI_OCCLUSION_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace vgi::math {
+    namespace {
+        // Pixels processed at once, on the widest instruction set available
+#if defined(VGI_OCCLUSION_SSE)
+        struct lanes {
+            __m128 value;
+        };
+        struct lane_mask {
+            __m128 value;
+        };
+
+        inline lanes splat(float x) noexcept { return {_mm_set1_ps(x)}; }
+        inline lanes ramp(float x) noexcept {
+            return {_mm_setr_ps(x, x + 1.0f, x + 2.0f, x + 3.0f)};
+        }
+        inline lanes load(const float* src) noexcept { return {_mm_loadu_ps(src)}; }
+        inline void store(float* dst, lanes x) noexcept { _mm_storeu_ps(dst, x.value); }
+        inline lanes operator+(lanes a, lanes b) noexcept { return {_mm_add_ps(a.value, b.value)}; }
+        inline lanes operator*(lanes a, lanes b) noexcept { return {_mm_mul_ps(a.value, b.value)}; }
+        inline lanes lane_min(lanes a, lanes b) noexcept { return {_mm_min_ps(a.value, b.value)}; }
+        inline lane_mask operator>=(lanes a, lanes b) noexcept {
+            return {_mm_cmpge_ps(a.value, b.value)};
+        }
+        inline lane_mask operator<(lanes a, lanes b) noexcept {
+            return {_mm_cmplt_ps(a.value, b.value)};
+        }
+        inline lane_mask operator&(lane_mask a, lane_mask b) noexcept {
+            return {_mm_and_ps(a.value, b.value)};
+        }
+        inline lanes select(lane_mask mask, lanes a, lanes b) noexcept {
+            return {_mm_or_ps(_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value))};
+        }
+        inline bool any(lane_mask mask) noexcept { return _mm_movemask_ps(mask.value) != 0; }
+#elif defined(VGI_OCCLUSION_NEON)
+        struct lanes {
+            float32x4_t value;
+        };
+        struct lane_mask {
+            uint32x4_t value;
+        };
+
+        inline lanes splat(float x) noexcept { return {vdupq_n_f32(x)}; }
+        inline lanes ramp(float x) noexcept {
+            const float values[] = {x, x + 1.0f, x + 2.0f, x + 3.0f};
+            return {vld1q_f32(values)};
+        }
+        inline lanes load(const float* src) noexcept { return {vld1q_f32(src)}; }
+        inline void store(float* dst, lanes x) noexcept { vst1q_f32(dst, x.value); }
+        inline lanes operator+(lanes a, lanes b) noexcept { return {vaddq_f32(a.value, b.value)}; }
+        inline lanes operator*(lanes a, lanes b) noexcept { return {vmulq_f32(a.value, b.value)}; }
+        inline lanes lane_min(lanes a, lanes b) noexcept { return {vminq_f32(a.value, b.value)}; }
+        inline lane_mask operator>=(lanes a, lanes b) noexcept {
+            return {vcgeq_f32(a.value, b.value)};
+        }
+        inline lane_mask operator<(lanes a, lanes b) noexcept {
+            return {vcltq_f32(a.value, b.value)};
+        }
+        inline lane_mask operator&(lane_mask a, lane_mask b) noexcept {
+            return {vandq_u32(a.value, b.value)};
+        }
+        inline lanes select(lane_mask mask, lanes a, lanes b) noexcept {
+            return {vbslq_f32(mask.value, a.value, b.value)};
+        }
+        inline bool any(lane_mask mask) noexcept { return vmaxvq_u32(mask.value) != 0; }
+#else
+        struct lanes {
+            float value[occlusion_buffer::LANES];
+        };
+        struct lane_mask {
+            bool value[occlusion_buffer::LANES];
+        };
+
+        template<class T, class F>
+        inline T lanewise(F&& f) noexcept {
+            T result;
+            for (uint32_t i = 0; i < occlusion_buffer::LANES; ++i) result.value[i] = f(i);
+            return result;
+        }
+
+        inline lanes splat(float x) noexcept {
+            return lanewise<lanes>([&](uint32_t) { return x; });
+        }
+        inline lanes ramp(float x) noexcept {
+            return lanewise<lanes>([&](uint32_t i) { return x + static_cast<float>(i); });
+        }
+        inline lanes load(const float* src) noexcept {
+            return lanewise<lanes>([&](uint32_t i) { return src[i]; });
+        }
+        inline void store(float* dst, lanes x) noexcept {
+            std::copy(std::begin(x.value), std::end(x.value), dst);
+        }
+        inline lanes operator+(lanes a, lanes b) noexcept {
+            return lanewise<lanes>([&](uint32_t i) { return a.value[i] + b.value[i]; });
+        }
+        inline lanes operator*(lanes a, lanes b) noexcept {
+            return lanewise<lanes>([&](uint32_t i) { return a.value[i] * b.value[i]; });
+        }
+        inline lanes lane_min(lanes a, lanes b) noexcept {
+            return lanewise<lanes>([&](uint32_t i) { return (std::min)(a.value[i], b.value[i]); });
+        }
+        inline lane_mask operator>=(lanes a, lanes b) noexcept {
+            return lanewise<lane_mask>([&](uint32_t i) { return a.value[i] >= b.value[i]; });
+        }
+        inline lane_mask operator<(lanes a, lanes b) noexcept {
+            return lanewise<lane_mask>([&](uint32_t i) { return a.value[i] < b.value[i]; });
+        }
+        inline lane_mask operator&(lane_mask a, lane_mask b) noexcept {
+            return lanewise<lane_mask>([&](uint32_t i) { return a.value[i] && b.value[i]; });
+        }
+        inline lanes select(lane_mask mask, lanes a, lanes b) noexcept {
+            return lanewise<lanes>(
+                    [&](uint32_t i) { return mask.value[i] ? a.value[i] : b.value[i]; });
+        }
+        inline bool any(lane_mask mask) noexcept {
+            return std::ranges::any_of(mask.value, [](bool x) { return x; });
+        }
+#endif
+
+        // Transforms a point from clip space into pixel coordinates and depth
+        inline glm::vec3 to_screen(const glm::vec4& clip, float width, float height) noexcept {
+            const glm::vec3 ndc = glm::vec3{clip} / clip.w;
+            return glm::vec3{(ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z};
+        }
+    }  // namespace
+
+    occlusion_buffer::occlusion_buffer(uint32_t width, uint32_t height) :
+        buffer_width(width), buffer_height(height),
+        stride((width + LANES - 1) / LANES * LANES) {
+        VGI_ASSERT(width > 0 && height > 0);
+        // Rows are padded, so that the pixels of a row can always be loaded `LANES` at a time
+        this->depths.resize(static_cast<size_t>(this->stride) * height, 1.0f);
+    }
+
+    void occlusion_buffer::begin(const glm::mat4& view_projection) noexcept {
+        this->view_projection = view_projection;
+        this->triangles.clear();
+        std::ranges::fill(this->depths, 1.0f);
+    }
+
+    void occlusion_buffer::add_occluder(std::span<const glm::vec3> positions,
+                                        std::span<const uint32_t> indices,
+                                        const glm::mat4& model) {
+        VGI_ASSERT(indices.size() % 3 == 0);
+        const glm::mat4 mvp = this->view_projection * model;
+        const float width = static_cast<float>(this->buffer_width);
+        const float height = static_cast<float>(this->buffer_height);
+
+        this->triangles.reserve(this->triangles.size() + indices.size() / 3);
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            glm::vec3 v[3];
+            bool clipped = false;
+            for (size_t j = 0; j < 3 && !clipped; ++j) {
+                VGI_ASSERT(indices[i + j] < positions.size());
+                const glm::vec4 clip = mvp * glm::vec4{positions[indices[i + j]], 1.0f};
+                // Dropping an occluder only makes culling less aggressive, so triangles that
+                // cross the near plane are skipped instead of clipped
+                clipped = clip.w <= 0.0f || clip.z < 0.0f;
+                v[j] = to_screen(clip, width, height);
+            }
+            if (clipped) continue;
+
+            float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                         (v[1].y - v[0].y) * (v[2].x - v[0].x);
+            if (!(std::abs(area) > 0.0f)) continue;
+            // Both windings are rasterized, with their edges facing inwards
+            if (area < 0.0f) {
+                std::swap(v[1], v[2]);
+                area = -area;
+            }
+
+            triangle& result = this->triangles.emplace_back();
+            for (glm::length_t j = 0; j < 3; ++j) {
+                const glm::vec3& a = v[j];
+                const glm::vec3& b = v[(j + 1) % 3];
+                result.edge_x[j] = a.y - b.y;
+                result.edge_y[j] = b.x - a.x;
+                // Edges are moved inwards by half a pixel, so only fully covered pixels pass
+                result.edge_c[j] = -(result.edge_x[j] * a.x + result.edge_y[j] * a.y) -
+                                   0.5f * (std::abs(result.edge_x[j]) + std::abs(result.edge_y[j]));
+            }
+
+            // Depth is taken at the farthest point of every pixel
+            const glm::vec3 e1 = v[1] - v[0];
+            const glm::vec3 e2 = v[2] - v[0];
+            const float dzdx = (e1.z * e2.y - e2.z * e1.y) / area;
+            const float dzdy = (e2.z * e1.x - e1.z * e2.x) / area;
+            result.depth = glm::vec3{dzdx, dzdy,
+                                     v[0].z - dzdx * v[0].x - dzdy * v[0].y +
+                                             0.5f * (std::abs(dzdx) + std::abs(dzdy))};
+            result.bounds = glm::vec4{glm::min(glm::min(glm::vec2{v[0]}, glm::vec2{v[1]}),
+                                               glm::vec2{v[2]}),
+                                      glm::max(glm::max(glm::vec2{v[0]}, glm::vec2{v[1]}),
+                                               glm::vec2{v[2]})};
+        }
+    }
+
+    void occlusion_buffer::rasterize(worker_pool* workers) noexcept {
+        const uint32_t bands = (this->buffer_height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+        auto band = [this](size_t i) noexcept {
+            const uint32_t first_row = static_cast<uint32_t>(i) * BAND_HEIGHT;
+            this->rasterize_band(first_row,
+                                 (std::min)(first_row + BAND_HEIGHT, this->buffer_height));
+        };
+
+        // Bands cover disjoint rows, so they can be rasterized in parallel
+        if (workers != nullptr) {
+            workers->run(bands, band);
+        } else {
+            for (uint32_t i = 0; i < bands; ++i) band(i);
+        }
+    }
+
+    void occlusion_buffer::rasterize_band(uint32_t first_row, uint32_t last_row) noexcept {
+        const float max_x = static_cast<float>(this->buffer_width - 1);
+        for (const triangle& tri: this->triangles) {
+            // Rows and columns whose pixel centers may be inside the triangle, within the band
+            const float top =
+                    (std::max)(std::ceil(tri.bounds.y - 0.5f), static_cast<float>(first_row));
+            const float bottom =
+                    (std::min)(std::floor(tri.bounds.w - 0.5f), static_cast<float>(last_row - 1));
+            const float left = (std::max)(std::ceil(tri.bounds.x - 0.5f), 0.0f);
+            const float right = (std::min)(std::floor(tri.bounds.z - 0.5f), max_x);
+            if (top > bottom || left > right) continue;
+
+            const uint32_t x0 = static_cast<uint32_t>(left) / LANES * LANES;
+            const uint32_t x1 = static_cast<uint32_t>(right);
+            const lanes edge_x[] = {splat(tri.edge_x[0]), splat(tri.edge_x[1]),
+                                    splat(tri.edge_x[2])};
+            const lanes depth_x = splat(tri.depth.x);
+            const lanes zero = splat(0.0f);
+
+            for (uint32_t y = static_cast<uint32_t>(top); y <= static_cast<uint32_t>(bottom); ++y) {
+                const float py = static_cast<float>(y) + 0.5f;
+                const lanes edge_row[] = {splat(tri.edge_y[0] * py + tri.edge_c[0]),
+                                          splat(tri.edge_y[1] * py + tri.edge_c[1]),
+                                          splat(tri.edge_y[2] * py + tri.edge_c[2])};
+                const lanes depth_row = splat(tri.depth.y * py + tri.depth.z);
+
+                float* row = this->depths.data() + static_cast<size_t>(y) * this->stride;
+                for (uint32_t x = x0; x <= x1; x += LANES) {
+                    const lanes px = ramp(static_cast<float>(x) + 0.5f);
+                    const lane_mask inside = (edge_x[0] * px + edge_row[0] >= zero) &
+                                             (edge_x[1] * px + edge_row[1] >= zero) &
+                                             (edge_x[2] * px + edge_row[2] >= zero);
+                    if (!any(inside)) continue;
+
+                    const lanes depth = depth_x * px + depth_row;
+                    const lanes current = load(row + x);
+                    store(row + x, select(inside, lane_min(current, depth), current));
+                }
+            }
+        }
+    }
+
+    bool occlusion_buffer::visible(const aabb& box) const noexcept {
+        if (box.empty()) return false;
+        const float width = static_cast<float>(this->buffer_width);
+        const float height = static_cast<float>(this->buffer_height);
+
+        // Screen-space bounds of the box, and the depth of its nearest point
+        glm::vec2 min_screen{(std::numeric_limits<float>::max)()};
+        glm::vec2 max_screen{std::numeric_limits<float>::lowest()};
+        float nearest = (std::numeric_limits<float>::max)();
+        for (uint32_t i = 0; i < 8; ++i) {
+            const glm::vec3 corner{i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y,
+                                   i & 4 ? box.max.z : box.min.z};
+            const glm::vec4 clip = this->view_projection * glm::vec4{corner, 1.0f};
+            // Boxes that cross the near plane can't be projected
+            if (clip.w <= 0.0f || clip.z < 0.0f) return true;
+
+            const glm::vec3 screen = to_screen(clip, width, height);
+            min_screen = glm::min(min_screen, glm::vec2{screen});
+            max_screen = glm::max(max_screen, glm::vec2{screen});
+            nearest = (std::min)(nearest, screen.z);
+        }
+
+        // Every pixel touched by the box is tested, so it's visible if any of them is farther
+        const float left = (std::max)(std::floor(min_screen.x), 0.0f);
+        const float right = (std::min)(std::floor(max_screen.x), width - 1.0f);
+        const float top = (std::max)(std::floor(min_screen.y), 0.0f);
+        const float bottom = (std::min)(std::floor(max_screen.y), height - 1.0f);
+        if (left > right || top > bottom) return false;
+
+        const uint32_t x0 = static_cast<uint32_t>(left) / LANES * LANES;
+        const uint32_t x1 = static_cast<uint32_t>(right);
+        const lanes first = splat(left);
+        const lanes last = splat(right + 1.0f);
+        const lanes depth = splat(nearest);
+        for (uint32_t y = static_cast<uint32_t>(top); y <= static_cast<uint32_t>(bottom); ++y) {
+            const float* row = this->depths.data() + static_cast<size_t>(y) * this->stride;
+            for (uint32_t x = x0; x <= x1; x += LANES) {
+                const lanes px = ramp(static_cast<float>(x));
+                if (any((px >= first) & (px < last) & (load(row + x) >= depth))) return true;
+            }
+        }
+        return false;
+    }
+
+    size_t occlusion_buffer::cull(std::span<const aabb> boxes, std::span<uint32_t> indices,
+                                  worker_pool* workers) {
+        auto cull_range = [&](size_t begin, size_t end) noexcept {
+            size_t count = 0;
+            for (size_t i = begin; i < end; ++i) {
+                VGI_ASSERT(indices[i] < boxes.size());
+                indices[begin + count] = indices[i];
+                count += this->visible(boxes[indices[i]]) ? 1 : 0;
+            }
+            return count;
+        };
+        if (workers == nullptr || indices.size() <= CULL_CHUNK) {
+            return cull_range(0, indices.size());
+        }
+
+        // Every chunk is compacted in place, and then moved after the previous ones
+        const size_t chunks = (indices.size() + CULL_CHUNK - 1) / CULL_CHUNK;
+        this->chunk_counts.resize(chunks);
+        workers->run(chunks, [&](size_t chunk) noexcept {
+            const size_t begin = chunk * CULL_CHUNK;
+            this->chunk_counts[chunk] =
+                    cull_range(begin, (std::min)(begin + CULL_CHUNK, indices.size()));
+        });
+
+        size_t count = 0;
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            const auto begin = indices.begin() + static_cast<ptrdiff_t>(chunk * CULL_CHUNK);
+            std::copy_n(begin, this->chunk_counts[chunk],
+                        indices.begin() + static_cast<ptrdiff_t>(count));
+            count += this->chunk_counts[chunk];
+        }
+        return count;
+    }
+}  // namespace vgi::math
@@ -0,0 +1,102 @@
+/*! \file */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+#include <vgi/math/bounds.hpp>
+#include <vgi/workers.hpp>
+
+namespace vgi::math {
+    /// @brief A low resolution depth buffer, rasterized on the host from occluder meshes, which
+    /// tests whether objects are hidden behind them
+    /// @details Occluders are drawn with a half-space rasterizer that shades several pixels at
+    /// once, on the widest instruction set available (SSE on x86, NEON on AArch64, and plain
+    /// scalar code elsewhere). Rasterization is conservative, so objects are never culled by
+    /// mistake: occluders only cover the pixels they fully contain, at the farthest depth they
+    /// have within them, and triangles that cross the near plane are dropped.
+    ///
+    /// Every frame goes through these steps, before any draw is recorded:
+    /// 1. `begin` clears the buffer for a new camera.
+    /// 2. `add_occluder` queues the triangles of every occluder (i.e. walls or terrain, usually
+    ///    simplified versions of them).
+    /// 3. `rasterize` draws the occluders, with a task per band of rows.
+    /// 4. `cull` filters the objects that were already inside the frustum (see
+    ///    `vgi::math::frustum::cull`), so that only the visible ones are drawn.
+    ///
+    /// Both `rasterize` and `cull` run on a `vgi::worker_pool`, if one is provided.
+    class occlusion_buffer {
+    public:
+        /// @brief Number of pixels rasterized at once
+        constexpr static inline const uint32_t LANES = 4;
+        /// @brief Number of rows rasterized by every task
+        constexpr static inline const uint32_t BAND_HEIGHT = 16;
+        /// @brief Number of objects tested by every task
+        constexpr static inline const size_t CULL_CHUNK = 256;
+
+        /// @brief Default constructor
+        occlusion_buffer() = default;
+
+        /// @brief Creates a new occlusion buffer
+        /// @param width Width of the buffer, in pixels
+        /// @param height Height of the buffer, in pixels
+        occlusion_buffer(uint32_t width, uint32_t height);
+
+        /// @brief Width of the buffer, in pixels
+        inline uint32_t width() const noexcept { return this->buffer_width; }
+        /// @brief Height of the buffer, in pixels
+        inline uint32_t height() const noexcept { return this->buffer_height; }
+
+        /// @brief Clears the depth and the occluders of the buffer
+        /// @param view_projection Matrix that transforms from world to clip space, with a depth
+        /// range of `[0, 1]`
+        void begin(const glm::mat4& view_projection) noexcept;
+
+        /// @brief Queues the triangles of an occluder to be rasterized
+        /// @param positions Positions of the occluder's vertices, in model space
+        /// @param indices Indices of the occluder's triangles
+        /// @param model Model matrix of the occluder
+        void add_occluder(std::span<const glm::vec3> positions, std::span<const uint32_t> indices,
+                          const glm::mat4& model = glm::mat4{1.0f});
+
+        /// @brief Rasterizes the queued occluders
+        /// @param workers Pool that rasterizes the bands of the buffer in parallel, if any
+        void rasterize(worker_pool* workers = nullptr) noexcept;
+
+        /// @brief Checks whether any part of a box may be visible past the occluders
+        /// @param box Box to be tested, in world space. Empty boxes are never visible.
+        bool visible(const aabb& box) const noexcept;
+
+        /// @brief Filters a list of objects, keeping only the ones that may be visible
+        /// @param boxes Bounding boxes of every object, in world space
+        /// @param indices Indices of the objects to be tested, which are overwritten with the
+        /// indices of the visible ones (in the same order)
+        /// @param workers Pool that tests the objects in parallel, if any
+        /// @return Number of visible objects, written at the start of `indices`
+        size_t cull(std::span<const aabb> boxes, std::span<uint32_t> indices,
+                    worker_pool* workers = nullptr);
+
+    private:
+        // A triangle set up for rasterization, in pixel coordinates. Every edge is a half-space
+        // `x * edge_x + y * edge_y + edge_c >= 0`, and depth is a plane over the screen.
+        struct triangle {
+            glm::vec3 edge_x;
+            glm::vec3 edge_y;
+            glm::vec3 edge_c;
+            glm::vec3 depth;
+            glm::vec4 bounds;
+        };
+
+        std::vector<float> depths;
+        std::vector<triangle> triangles;
+        std::vector<size_t> chunk_counts;
+        glm::mat4 view_projection{1.0f};
+        uint32_t buffer_width = 0;
+        uint32_t buffer_height = 0;
+        uint32_t stride = 0;
+
+        void rasterize_band(uint32_t first_row, uint32_t last_row) noexcept;
+    };
+}  // namespace vgi::math
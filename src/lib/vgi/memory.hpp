@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <functional>
 #include <memory>
+#include <memory_resource>
 #include <new>
 #include <span>
 #include <stdexcept>
@@ -22,6 +23,9 @@ namespace vgi {
                                            (!std::is_volatile_v<U> || std::is_volatile_v<T>);
 
     /// A simple host buffer with constant size, usefull as an unresizable 'std::vector'
+    /// @details Spans allocate their elements with the global allocation functions, unless a
+    /// memory resource (i.e. a `vgi::frame_arena`) is provided, in which case their storage is
+    /// returned to that resource when destroyed.
     template<class T>
     struct unique_span {
         //! @cond Doxygen_Suppress
@@ -45,12 +49,22 @@ namespace vgi {
         /// @param len Number of elements stored
         constexpr unique_span(pointer VGI_RESTRICT ptr, size_t len) noexcept : ptr(ptr), len(len) {}
 
+        /// @brief Creates a new span that takes ownership of the provided pointer, destroying it's
+        /// members and returning it to `resource` when destroyed
+        /// @param ptr Pointer to the elements, allocated from `resource`
+        /// @param len Number of elements stored
+        /// @param resource Memory resource that allocated `ptr`
+        constexpr unique_span(pointer VGI_RESTRICT ptr, size_t len,
+                              std::pmr::memory_resource& resource) noexcept :
+            ptr(ptr), len(len), resource(&resource) {}
+
         /// @brief Move constructor
         /// @param other Object to move
         template<class U>
             requires(unique_span_move_constructor<U, T>)
         constexpr unique_span(unique_span<U>&& other) noexcept :
-            ptr(std::exchange(other.ptr, nullptr)), len(std::exchange(other.len, 0)) {}
+            ptr(std::exchange(other.ptr, nullptr)), len(std::exchange(other.len, 0)),
+            resource(std::exchange(other.resource, nullptr)) {}
 
         /// @brief Move assignment
         /// @param other Object to move
@@ -92,6 +106,35 @@ namespace vgi {
             this->len = size;
         }
 
+        /// @brief Creates a new span by moving the values from `other` into storage allocated from
+        /// `resource`
+        /// @param other Vector with elements to move to the span
+        /// @param resource Memory resource used to allocate the elements
+        template<class R>
+            requires(!unique_span_move_constructor<R, T> && std::ranges::sized_range<R> &&
+                     std::ranges::input_range<R> &&
+                     std::constructible_from<value_type, std::ranges::range_rvalue_reference_t<R>>)
+        unique_span(R&& other, std::pmr::memory_resource& resource) {
+            size_t size = std::ranges::size(other);
+            if (size == 0) return;
+            std::optional<size_t> byte_size = math::check_mul(size, sizeof(T));
+            if (!byte_size) throw std::bad_alloc{};
+
+            value_type* VGI_RESTRICT data =
+                    static_cast<value_type*>(resource.allocate(byte_size.value(), alignof(T)));
+            try {
+                std::ranges::uninitialized_move(std::ranges::begin(other), std::ranges::end(other),
+                                                data, data + size);
+            } catch (...) {
+                resource.deallocate(data, byte_size.value(), alignof(T));
+                throw;
+            }
+
+            this->ptr = data;
+            this->len = size;
+            this->resource = &resource;
+        }
+
         template<class R>
             requires(!unique_span_move_constructor<R, T> && std::ranges::sized_range<R> &&
                      std::ranges::input_range<R> &&
@@ -101,6 +144,11 @@ namespace vgi {
             return *this;
         }
 
+        /// @return The memory resource the elements were allocated from, or `nullptr` if they were
+        /// allocated with the global allocation functions
+        constexpr std::pmr::memory_resource* memory_resource() const noexcept {
+            return this->resource;
+        }
         /// @return The number of elements stored by the span
         constexpr size_type size() const noexcept { return this->ptr ? this->len : 0; }
         /// @brief Checks whether the container is empty
@@ -187,6 +235,7 @@ namespace vgi {
         constexpr void swap(unique_span& other) noexcept {
             std::swap(this->ptr, other.ptr);
             std::swap(this->len, other.len);
+            std::swap(this->resource, other.resource);
         }
 
         /// @brief Returns a non-owning view to the container's data
@@ -204,8 +253,12 @@ namespace vgi {
             if constexpr (!std::is_trivially_destructible_v<T>) {
                 std::destroy_n(this->ptr, this->len);
             }
-            ::operator delete(this->ptr, sizeof(T) * this->len,
-                              static_cast<std::align_val_t>(alignof(T)));
+            if (this->resource) {
+                this->resource->deallocate(this->ptr, sizeof(T) * this->len, alignof(T));
+            } else {
+                ::operator delete(this->ptr, sizeof(T) * this->len,
+                                  static_cast<std::align_val_t>(alignof(T)));
+            }
         }
 
         unique_span(const unique_span&) = delete;
@@ -214,6 +267,7 @@ namespace vgi {
     private:
         value_type* VGI_RESTRICT ptr = nullptr;
         size_t len = 0;
+        std::pmr::memory_resource* resource = nullptr;
 
         template<class U>
         friend struct unique_span;
@@ -235,6 +289,23 @@ namespace vgi {
         return unique_span<T>{ptr, n};
     }
 
+    /// @brief Allocate a `unique_span` from a memory resource without initializing the values
+    /// @tparam T Type of the elements to allocate
+    /// @param n Number of elements to allocate
+    /// @param resource Memory resource used to allocate the elements (i.e. a `vgi::frame_arena`)
+    /// @return A container with `n` uninitialized elements of `T`
+    template<class T>
+    inline unique_span<T> make_unique_span_for_overwrite(size_t n,
+                                                         std::pmr::memory_resource& resource) {
+        if (n == 0) return unique_span<T>{};
+        std::optional<size_t> byte_size = math::check_mul(n, sizeof(T));
+        if (!byte_size) throw std::bad_alloc{};
+
+        T* VGI_RESTRICT ptr = static_cast<T*>(resource.allocate(byte_size.value(), alignof(T)));
+        VGI_ASSERT(ptr != nullptr);
+        return unique_span<T>{ptr, n, resource};
+    }
+
     /// @brief Specializes the `std::swap` algorithm for `vgi::unique_span`. Swaps the contents of
     /// `lhs` and `rhs`. Calls `lhs.swap(rhs)`
     /// @param lhs container whose contents to swap
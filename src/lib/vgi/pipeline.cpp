@@ -55,14 +55,8 @@ namespace vgi {
                 vertex.stage_info(vk::ShaderStageFlagBits::eVertex),
                 fragment.stage_info(vk::ShaderStageFlagBits::eFragment)};
 
-        const auto vertex_binding = vertex::input_binding(options.vertex_binding);
-        const auto vertex_attributes = vertex::input_attributes(options.vertex_binding);
-        const vk::PipelineVertexInputStateCreateInfo vertex_input_state{
-                .vertexBindingDescriptionCount = 1,
-                .pVertexBindingDescriptions = &vertex_binding,
-                .vertexAttributeDescriptionCount = std::size(vertex_attributes),
-                .pVertexAttributeDescriptions = vertex_attributes.data(),
-        };
+        const vk::PipelineVertexInputStateCreateInfo vertex_input_state =
+                options.input.create_info();
 
         // Input assembly state describes how primitives are assembled
         const vk::PipelineInputAssemblyStateCreateInfo input_assembly_state{
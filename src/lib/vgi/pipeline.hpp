@@ -4,8 +4,10 @@
 #include <optional>
 #include <span>
 
+#include "buffer/vertex.hpp"
 #include "memory.hpp"
 #include "pipeline/shader.hpp"
+#include "pipeline/vertex_input.hpp"
 #include "resource.hpp"
 #include "vulkan.hpp"
 #include "window.hpp"
@@ -123,8 +125,10 @@ namespace vgi {
 
     /// @brief Information used to create a graphics pipeline
     struct graphics_pipeline_options {
-        /// @brief Binding where the vertex information is located
-        uint32_t vertex_binding = 0;
+        /// @brief Vertex attributes fetched by the pipeline
+        /// @details Pipelines should only fetch the streams their vertex shader consumes (i.e.
+        /// `vertex_input::of<vertex_position>()` for depth-only passes)
+        vertex_input input = split_vertex_input();
         /// @brief The topology of the vertex data
         vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
         /// @brief The triangle rendering mode.
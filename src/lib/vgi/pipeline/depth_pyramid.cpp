@@ -0,0 +1,203 @@
+#include "depth_pyramid.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <tuple>
+#include <vgi/pipeline/descriptor.hpp>
+#include <vgi/vgi.hpp>
+
+namespace vgi {
+    // Matches the bindings of the `depth_pyramid.comp` shader
+    constexpr static inline const vk::DescriptorSetLayoutBinding PYRAMID_BINDINGS[] = {
+            {
+                    .binding = 0,
+                    .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            },
+            {
+                    .binding = 1,
+                    .descriptorType = vk::DescriptorType::eStorageImage,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            },
+    };
+
+    depth_pyramid::depth_pyramid(const window& parent, const shader_stage& shader) :
+        pipeline(parent, shader, std::span{PYRAMID_BINDINGS}) {
+        try {
+            this->sampler = parent->createSampler(vk::SamplerCreateInfo{
+                    .magFilter = vk::Filter::eNearest,
+                    .minFilter = vk::Filter::eNearest,
+                    .mipmapMode = vk::SamplerMipmapMode::eNearest,
+                    .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+                    .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+                    .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+                    .maxLod = VK_LOD_CLAMP_NONE,
+            });
+        } catch (...) {
+            std::move(this->pipeline).destroy(parent);
+            throw;
+        }
+    }
+
+    void depth_pyramid::prepare(const window& parent, vk::CommandBuffer cmdbuf) {
+        const vk::Extent2D draw_size = parent.draw_size();
+        if (this->image && draw_size == this->source_size) return;
+        if (this->image) {
+            // Previous frames may still be reading the pyramid
+            parent->waitIdle();
+            this->destroy_image(parent);
+        }
+
+        // Levels are powers of two, so that every texel covers exactly four of the previous level
+        const vk::Extent2D size{std::bit_floor(draw_size.width), std::bit_floor(draw_size.height)};
+        const uint32_t levels = std::bit_width((std::max)(size.width, size.height));
+        std::tie(this->image, this->allocation) = parent.create_image(
+                vk::ImageCreateInfo{
+                        .imageType = vk::ImageType::e2D,
+                        .format = vk::Format::eR32Sfloat,
+                        .extent = {size.width, size.height, UINT32_C(1)},
+                        .mipLevels = levels,
+                        .arrayLayers = 1,
+                        .samples = vk::SampleCountFlagBits::e1,
+                        .tiling = vk::ImageTiling::eOptimal,
+                        .usage = vk::ImageUsageFlagBits::eSampled |
+                                 vk::ImageUsageFlagBits::eStorage,
+                        .sharingMode = vk::SharingMode::eExclusive,
+                },
+                VmaAllocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE});
+
+        try {
+            vk::ImageViewCreateInfo view_info{
+                    .image = this->image,
+                    .viewType = vk::ImageViewType::e2D,
+                    .format = vk::Format::eR32Sfloat,
+                    .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                                         .baseMipLevel = 0,
+                                         .levelCount = levels,
+                                         .baseArrayLayer = 0,
+                                         .layerCount = 1},
+            };
+            this->full_view = parent->createImageView(view_info);
+
+            this->level_views.reserve(levels);
+            this->level_descriptors.reserve(levels);
+            view_info.subresourceRange.levelCount = 1;
+            for (uint32_t i = 0; i < levels; ++i) {
+                view_info.subresourceRange.baseMipLevel = i;
+                this->level_views.push_back(parent->createImageView(view_info));
+                this->level_descriptors.emplace_back(parent, this->pipeline);
+            }
+
+            // Every level reads the previous one, except for the first, whose source changes with
+            // the swapchain image (see `build`)
+            descriptor_writer writer;
+            for (uint32_t i = 0; i < levels; ++i) {
+                for (uint32_t j = 0; j < window::MAX_FRAMES_IN_FLIGHT; ++j) {
+                    const vk::DescriptorSet set = this->level_descriptors[i][j];
+                    if (i > 0) {
+                        writer.write_image(set, 0, vk::DescriptorType::eCombinedImageSampler,
+                                           vk::DescriptorImageInfo{
+                                                   .sampler = this->sampler,
+                                                   .imageView = this->level_views[i - 1],
+                                                   .imageLayout = vk::ImageLayout::eGeneral,
+                                           });
+                    }
+                    writer.write_image(set, 1, vk::DescriptorType::eStorageImage,
+                                       vk::DescriptorImageInfo{
+                                               .imageView = this->level_views[i],
+                                               .imageLayout = vk::ImageLayout::eGeneral,
+                                       });
+                }
+            }
+            writer.flush(parent);
+        } catch (...) {
+            this->destroy_image(parent);
+            throw;
+        }
+
+        this->source_size = draw_size;
+        this->pyramid_size = size;
+        cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                               vk::PipelineStageFlagBits::eComputeShader, {}, {}, {},
+                               vk::ImageMemoryBarrier{
+                                       .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                        vk::AccessFlagBits::eShaderWrite,
+                                       .oldLayout = vk::ImageLayout::eUndefined,
+                                       .newLayout = vk::ImageLayout::eGeneral,
+                                       .image = this->image,
+                                       .subresourceRange = {
+                                               .aspectMask = vk::ImageAspectFlagBits::eColor,
+                                               .levelCount = levels,
+                                               .layerCount = 1,
+                                       }});
+    }
+
+    void depth_pyramid::build(const window& parent, vk::CommandBuffer cmdbuf,
+                              uint32_t current_frame) {
+        VGI_ASSERT(this->image);
+        VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+
+        descriptor_writer writer;
+        writer.write_image(this->level_descriptors[0][current_frame], 0,
+                           vk::DescriptorType::eCombinedImageSampler,
+                           vk::DescriptorImageInfo{
+                                   .sampler = this->sampler,
+                                   .imageView = parent.depth_view(),
+                                   .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                           });
+        writer.flush(parent);
+
+        // Reads of the previous build (i.e. by last frame's culling) must be done before the
+        // pyramid is overwritten
+        const vk::MemoryBarrier write_after_read{
+                .srcAccessMask = vk::AccessFlagBits::eShaderRead,
+                .dstAccessMask = vk::AccessFlagBits::eShaderWrite,
+        };
+        const vk::MemoryBarrier read_after_write{
+                .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+        };
+        cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                               vk::PipelineStageFlagBits::eComputeShader, {}, write_after_read, {},
+                               {});
+
+        this->pipeline.bind(cmdbuf);
+        for (uint32_t i = 0; i < this->levels(); ++i) {
+            cmdbuf.bindDescriptorSets(vk::PipelineBindPoint::eCompute, this->pipeline, 0,
+                                      this->level_descriptors[i][current_frame], {});
+            const uint32_t width = (std::max)(this->pyramid_size.width >> i, UINT32_C(1));
+            const uint32_t height = (std::max)(this->pyramid_size.height >> i, UINT32_C(1));
+            this->pipeline.dispatch(cmdbuf, (width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+                                    (height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE);
+
+            // Every level is the source of the next one
+            cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                   vk::PipelineStageFlagBits::eComputeShader, {}, read_after_write,
+                                   {}, {});
+        }
+    }
+
+    void depth_pyramid::destroy_image(const window& parent) noexcept {
+        for (descriptor_pool& pool: this->level_descriptors) std::move(pool).destroy(parent);
+        for (vk::ImageView view: this->level_views) parent->destroyImageView(view);
+        if (this->full_view) parent->destroyImageView(this->full_view);
+        if (this->image) parent.destroy_image(this->image, this->allocation);
+
+        this->level_descriptors.clear();
+        this->level_views.clear();
+        this->full_view = nullptr;
+        this->image = nullptr;
+        this->allocation = VK_NULL_HANDLE;
+        this->source_size = vk::Extent2D{};
+        this->pyramid_size = vk::Extent2D{};
+    }
+
+    void depth_pyramid::destroy(const window& parent) && noexcept {
+        this->destroy_image(parent);
+        if (this->sampler) parent->destroySampler(this->sampler);
+        std::move(this->pipeline).destroy(parent);
+    }
+}  // namespace vgi
@@ -0,0 +1,114 @@
+/*! \file */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <vgi/pipeline.hpp>
+#include <vgi/resource.hpp>
+#include <vgi/vulkan.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    /// @brief A hierarchical depth buffer (Hi-Z), where every texel of a mip level holds the
+    /// farthest depth of the texels it covers on the previous one
+    /// @details The pyramid is built from the window's depth attachment by the
+    /// `depth_pyramid.comp` shader, one dispatch per mip level. Its first level is the largest
+    /// power of two that fits within the draw size, so every texel of a level covers exactly four
+    /// of the previous one (except for the first, which covers the footprint of the attachment).
+    ///
+    /// Reductions are done with `max` in the shader, so the pyramid doesn't depend on min/max
+    /// samplers. The image always stays in `eGeneral` layout, and is meant to be read with
+    /// `texelFetch` on the level whose texels cover the tested bounds (see
+    /// `vgi::occlusion_culler`).
+    class depth_pyramid {
+    public:
+        /// @brief Side of the (square) workgroups of the shader
+        constexpr static inline const uint32_t WORKGROUP_SIZE = 8;
+
+        /// @brief Default constructor
+        depth_pyramid() = default;
+
+        /// @brief Creates a new depth pyramid
+        /// @details The pyramid's image is created by the first call to `prepare`.
+        /// @param parent Window that will create the pyramid
+        /// @param shader The compiled `depth_pyramid.comp` shader
+        depth_pyramid(const window& parent, const shader_stage& shader);
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        depth_pyramid(depth_pyramid&& other) noexcept :
+            pipeline(std::move(other.pipeline)), sampler(std::exchange(other.sampler, nullptr)),
+            image(std::exchange(other.image, nullptr)),
+            allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
+            full_view(std::exchange(other.full_view, nullptr)),
+            level_views(std::move(other.level_views)),
+            level_descriptors(std::move(other.level_descriptors)),
+            source_size(std::exchange(other.source_size, {})),
+            pyramid_size(std::exchange(other.pyramid_size, {})) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        depth_pyramid& operator=(depth_pyramid&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Size of the first level of the pyramid, in texels
+        inline vk::Extent2D size() const noexcept { return this->pyramid_size; }
+        /// @brief Number of mip levels of the pyramid
+        inline uint32_t levels() const noexcept {
+            return static_cast<uint32_t>(this->level_views.size());
+        }
+        /// @brief View of every level of the pyramid, in `eGeneral` layout
+        inline vk::ImageView view() const noexcept { return this->full_view; }
+        /// @brief Nearest, clamped sampler suited to fetch texels from the pyramid
+        inline vk::Sampler texel_sampler() const noexcept { return this->sampler; }
+
+        /// @brief (Re)creates the pyramid if the draw size of the window has changed
+        /// @details Must be called on every frame before the pyramid is referenced by any command
+        /// of the frame, since recreating it waits for the device to be idle. Levels created this
+        /// way hold undefined depths until the pyramid is first built.
+        /// @param parent Window whose depth attachment will be reduced
+        /// @param cmdbuf Command buffer into which the layout transition is recorded
+        void prepare(const window& parent, vk::CommandBuffer cmdbuf);
+
+        /// @brief Builds every level of the pyramid from the depth attachment of the frame
+        /// @details Must be recorded while the window's rendering is suspended (see
+        /// `window::suspend_rendering`). Once it returns, the pyramid is visible to compute
+        /// shaders.
+        /// @param parent Window whose depth attachment is reduced
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param current_frame Index of the current frame
+        void build(const window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame);
+
+        /// @brief Destroys the pyramid
+        /// @param parent Window used to create the pyramid
+        void destroy(const window& parent) && noexcept;
+
+        depth_pyramid(const depth_pyramid&) = delete;
+        depth_pyramid& operator=(const depth_pyramid&) = delete;
+
+    private:
+        compute_pipeline pipeline;
+        vk::Sampler sampler;
+        vk::Image image;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        vk::ImageView full_view;
+        std::vector<vk::ImageView> level_views;
+        // Every level has a set per frame, since the first one reads the depth attachment of the
+        // frame's swapchain image
+        std::vector<descriptor_pool> level_descriptors;
+        vk::Extent2D source_size{};
+        vk::Extent2D pyramid_size{};
+
+        void destroy_image(const window& parent) noexcept;
+    };
+
+    /// @brief A guard that destroys the depth pyramid when dropped.
+    using depth_pyramid_guard = resource_guard<depth_pyramid>;
+}  // namespace vgi
@@ -0,0 +1,66 @@
+#include "descriptor.hpp"
+
+#include <vgi/math.hpp>
+#include <vgi/vgi.hpp>
+
+namespace vgi {
+    descriptor_writer& descriptor_writer::write_buffer(vk::DescriptorSet set, uint32_t binding,
+                                                       vk::DescriptorType type,
+                                                       const vk::DescriptorBufferInfo& info,
+                                                       uint32_t array_element) {
+        const vk::DescriptorBufferInfo& stored = this->buffer_infos.emplace_back(info);
+        this->writes.push_back(vk::WriteDescriptorSet{
+                .dstSet = set,
+                .dstBinding = binding,
+                .dstArrayElement = array_element,
+                .descriptorCount = 1,
+                .descriptorType = type,
+                .pBufferInfo = &stored,
+        });
+        return *this;
+    }
+
+    descriptor_writer& descriptor_writer::write_image(vk::DescriptorSet set, uint32_t binding,
+                                                      vk::DescriptorType type,
+                                                      const vk::DescriptorImageInfo& info,
+                                                      uint32_t array_element) {
+        const vk::DescriptorImageInfo& stored = this->image_infos.emplace_back(info);
+        this->writes.push_back(vk::WriteDescriptorSet{
+                .dstSet = set,
+                .dstBinding = binding,
+                .dstArrayElement = array_element,
+                .descriptorCount = 1,
+                .descriptorType = type,
+                .pImageInfo = &stored,
+        });
+        return *this;
+    }
+
+    void descriptor_writer::flush(const window& parent) {
+        if (this->writes.empty()) return;
+        std::optional<uint32_t> write_count = math::check_cast<uint32_t>(this->writes.size());
+        if (!write_count) throw vgi_error{"too many descriptor writes"};
+
+        parent->updateDescriptorSets(write_count.value(), this->writes.data(), 0, nullptr);
+        this->clear();
+    }
+
+    descriptor_update_template::descriptor_update_template(
+            const window& parent, const pipeline& pipeline,
+            std::span<const vk::DescriptorUpdateTemplateEntry> entries) {
+        std::optional<uint32_t> entry_count = math::check_cast<uint32_t>(entries.size());
+        if (!entry_count) throw vgi_error{"too many descriptor update template entries"};
+
+        this->handle = parent->createDescriptorUpdateTemplate(
+                vk::DescriptorUpdateTemplateCreateInfo{
+                        .descriptorUpdateEntryCount = entry_count.value(),
+                        .pDescriptorUpdateEntries = entries.data(),
+                        .templateType = vk::DescriptorUpdateTemplateType::eDescriptorSet,
+                        .descriptorSetLayout = pipeline,
+                });
+    }
+
+    void descriptor_update_template::destroy(const window& parent) && {
+        if (this->handle) parent->destroyDescriptorUpdateTemplate(this->handle);
+    }
+}  // namespace vgi
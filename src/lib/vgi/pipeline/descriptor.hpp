@@ -0,0 +1,168 @@
+/*! \file */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <vgi/pipeline.hpp>
+#include <vgi/resource.hpp>
+#include <vgi/vulkan.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    /// @brief Accumulates descriptor writes so that they can be submitted to the driver with a
+    /// single call to `vkUpdateDescriptorSets`
+    struct descriptor_writer {
+        /// @brief Default constructor
+        descriptor_writer() = default;
+
+        /// @brief Queues a write of buffer descriptors
+        /// @param set Descriptor set to update
+        /// @param binding Binding within the set to update
+        /// @param type Type of the descriptor
+        /// @param info Buffer information of the descriptor
+        /// @param array_element Starting element within the binding's array
+        /// @return A reference to the writer, to allow chaining calls
+        descriptor_writer& write_buffer(vk::DescriptorSet set, uint32_t binding,
+                                        vk::DescriptorType type,
+                                        const vk::DescriptorBufferInfo& info,
+                                        uint32_t array_element = 0);
+
+        /// @brief Queues a write of image descriptors
+        /// @param set Descriptor set to update
+        /// @param binding Binding within the set to update
+        /// @param type Type of the descriptor
+        /// @param info Image information of the descriptor
+        /// @param array_element Starting element within the binding's array
+        /// @return A reference to the writer, to allow chaining calls
+        descriptor_writer& write_image(vk::DescriptorSet set, uint32_t binding,
+                                       vk::DescriptorType type, const vk::DescriptorImageInfo& info,
+                                       uint32_t array_element = 0);
+
+        /// @brief Number of writes waiting to be flushed
+        inline size_t size() const noexcept { return this->writes.size(); }
+        /// @brief Checks whether there are no writes waiting to be flushed
+        inline bool empty() const noexcept { return this->writes.empty(); }
+
+        /// @brief Submits all the queued writes with a single driver call, and clears the writer
+        /// @param parent Window that created the descriptor sets
+        void flush(const window& parent);
+
+        /// @brief Discards all the queued writes
+        inline void clear() noexcept {
+            this->writes.clear();
+            this->buffer_infos.clear();
+            this->image_infos.clear();
+        }
+
+    private:
+        // Deques are used so that the pointers stored in `writes` remain stable when new
+        // descriptors are queued.
+        std::vector<vk::WriteDescriptorSet> writes;
+        std::deque<vk::DescriptorBufferInfo> buffer_infos;
+        std::deque<vk::DescriptorImageInfo> image_infos;
+    };
+
+    /// @brief A descriptor update template, used to update every binding of a descriptor set from
+    /// a single host structure with one driver call.
+    /// @details Useful for fixed layouts (i.e. materials), where the same bindings are written for
+    /// many descriptor sets.
+    struct descriptor_update_template {
+        /// @brief Default constructor
+        descriptor_update_template() = default;
+
+        /// @brief Creates a new descriptor update template
+        /// @param parent Window that will create the template
+        /// @param pipeline Pipeline whose descriptor set layout will be updated with the template
+        /// @param entries Description of where each descriptor is located within the host
+        /// structure passed to `update`
+        descriptor_update_template(const window& parent, const pipeline& pipeline,
+                                   std::span<const vk::DescriptorUpdateTemplateEntry> entries);
+
+        /// @brief Creates a new descriptor update template
+        /// @param parent Window that will create the template
+        /// @param pipeline Pipeline whose descriptor set layout will be updated with the template
+        /// @param entries Description of where each descriptor is located within the host
+        /// structure passed to `update`
+        descriptor_update_template(
+                const window& parent, const pipeline& pipeline,
+                std::initializer_list<vk::DescriptorUpdateTemplateEntry> entries) :
+            descriptor_update_template(
+                    parent, pipeline,
+                    std::span<const vk::DescriptorUpdateTemplateEntry>{entries.begin(),
+                                                                       entries.size()}) {}
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        descriptor_update_template(descriptor_update_template&& other) noexcept :
+            handle(std::exchange(other.handle, nullptr)) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        descriptor_update_template& operator=(descriptor_update_template&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Updates all the bindings described by the template
+        /// @param parent Window that created the descriptor set
+        /// @param set Descriptor set to update
+        /// @param data Pointer to the host structure containing the descriptor information
+        inline void update(const window& parent, vk::DescriptorSet set,
+                           const void* data) const noexcept {
+            VGI_ASSERT(this->handle);
+            parent->updateDescriptorSetWithTemplate(set, this->handle, data);
+        }
+
+        /// @brief Updates all the bindings described by the template
+        /// @tparam T Type of the host structure
+        /// @param parent Window that created the descriptor set
+        /// @param set Descriptor set to update
+        /// @param data Host structure containing the descriptor information
+        template<class T>
+            requires(std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>)
+        inline void update(const window& parent, vk::DescriptorSet set,
+                           const T& data) const noexcept {
+            this->update(parent, set, static_cast<const void*>(std::addressof(data)));
+        }
+
+        /// @brief Updates every descriptor set of a pool
+        /// @tparam T Type of the host structure
+        /// @param parent Window that created the descriptor pool
+        /// @param pool Descriptor pool to update
+        /// @param data Host structures containing the descriptor information, one per frame in
+        /// flight
+        template<class T>
+            requires(std::is_trivially_copyable_v<T>)
+        inline void update(const window& parent, const descriptor_pool& pool,
+                           const std::array<T, window::MAX_FRAMES_IN_FLIGHT>& data) const noexcept {
+            for (uint32_t i = 0; i < pool.size(); ++i) this->update(parent, pool[i], data[i]);
+        }
+
+        /// @brief Casts to the underlying `vk::DescriptorUpdateTemplate`
+        constexpr operator vk::DescriptorUpdateTemplate() const noexcept { return this->handle; }
+        /// @brief Casts to the underlying `VkDescriptorUpdateTemplate`
+        inline operator VkDescriptorUpdateTemplate() const noexcept { return this->handle; }
+
+        /// @brief Destroys the descriptor update template
+        /// @param parent Window used to create the template
+        void destroy(const window& parent) &&;
+
+        descriptor_update_template(const descriptor_update_template&) = delete;
+        descriptor_update_template& operator=(const descriptor_update_template&) = delete;
+
+    private:
+        vk::DescriptorUpdateTemplate handle;
+    };
+
+    /// @brief A guard that destroys the descriptor update template when dropped.
+    using descriptor_update_template_guard = resource_guard<descriptor_update_template>;
+}  // namespace vgi
@@ -0,0 +1,318 @@
+#include "impostor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <vgi/buffer/transient.hpp>
+#include <vgi/cmdbuf.hpp>
+#include <vgi/math.hpp>
+#include <vgi/pipeline/descriptor.hpp>
+#include <vgi/vgi.hpp>
+
+namespace vgi {
+    // Matches the push constants of the `impostor.vert` shader
+    struct impostor_constants {
+        glm::mat4 view_projection;
+        glm::vec3 camera_origin;
+        uint32_t grid;
+    };
+    static_assert(sizeof(impostor_constants) == 80);
+
+    // Matches the bindings of the `impostor.frag` shader
+    constexpr static inline const vk::DescriptorSetLayoutBinding IMPOSTOR_BINDINGS[] = {
+            {
+                    .binding = 0,
+                    .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eFragment,
+            },
+    };
+
+    constexpr static inline const vk::PushConstantRange IMPOSTOR_PUSH_CONSTANTS[] = {
+            {
+                    .stageFlags = vk::ShaderStageFlagBits::eVertex,
+                    .offset = 0,
+                    .size = sizeof(impostor_constants),
+            },
+    };
+
+    // Direction from which a view of the grid is taken, decoded from the octahedral mapping of
+    // the `impostor.vert` shader
+    static glm::vec3 view_direction(uint32_t x, uint32_t y, uint32_t grid) noexcept {
+        const glm::vec2 p = (glm::vec2{x, y} + 0.5f) / static_cast<float>(grid) * 2.0f - 1.0f;
+        glm::vec3 direction{p.x, 1.0f - std::abs(p.x) - std::abs(p.y), p.y};
+        if (direction.y < 0.0f) {
+            const glm::vec2 folded = 1.0f - glm::abs(glm::vec2{direction.z, direction.x});
+            direction.x = direction.x >= 0.0f ? folded.x : -folded.x;
+            direction.z = direction.z >= 0.0f ? folded.y : -folded.y;
+        }
+        return glm::normalize(direction);
+    }
+
+    // Upward direction of a view, which matches the quads drawn by the `impostor.vert` shader
+    static glm::vec3 view_up(const glm::vec3& direction) noexcept {
+        return std::abs(direction.y) > 0.999f ? glm::vec3{0.0f, 0.0f, 1.0f}
+                                               : glm::vec3{0.0f, 1.0f, 0.0f};
+    }
+
+    static vk::ImageSubresourceRange layer_range(uint32_t first_layer,
+                                                 uint32_t layer_count) noexcept {
+        return vk::ImageSubresourceRange{
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = first_layer,
+                .layerCount = layer_count,
+        };
+    }
+
+    impostor_atlas::impostor_atlas(window& parent, const shader_stage& vertex,
+                                   const shader_stage& fragment, uint32_t capacity,
+                                   uint32_t resolution, uint32_t grid) :
+        pipeline(parent, vertex, fragment,
+                 graphics_pipeline_options{
+                         .input = vertex_input::of<impostor_instance>(
+                                 0, vk::VertexInputRate::eInstance),
+                         .topology = vk::PrimitiveTopology::eTriangleStrip,
+                         .color_blending = false,
+                         .bindings = IMPOSTOR_BINDINGS,
+                         .push_constants = IMPOSTOR_PUSH_CONSTANTS,
+                 }),
+        layer_count(capacity), view_resolution(resolution), grid_size(grid) {
+        try {
+            if (capacity == 0 || resolution == 0 || grid == 0) {
+                throw vgi_error{"impostor atlases can't be empty"};
+            }
+            const uint32_t size = resolution * grid;
+            if (size / grid != resolution ||
+                size > parent.device().props().limits.maxImageDimension2D) {
+                throw vgi_error{"impostor views don't fit in an image"};
+            }
+            if (capacity > parent.device().props().limits.maxImageArrayLayers) {
+                throw vgi_error{"impostor atlas has too many layers"};
+            }
+
+            this->descriptor = descriptor_pool{parent, this->pipeline};
+            this->sampler = parent->createSampler(vk::SamplerCreateInfo{
+                    .magFilter = vk::Filter::eLinear,
+                    .minFilter = vk::Filter::eLinear,
+                    .mipmapMode = vk::SamplerMipmapMode::eNearest,
+                    .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+                    .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+                    .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+                    .maxLod = 0.0f,
+            });
+
+            // Views are rendered with the window's formats, so that meshes are baked with the
+            // same pipelines that draw them
+            std::tie(this->image, this->allocation) = parent.create_image(
+                    vk::ImageCreateInfo{
+                            .imageType = vk::ImageType::e2D,
+                            .format = parent.format(),
+                            .extent = {size, size, UINT32_C(1)},
+                            .mipLevels = 1,
+                            .arrayLayers = capacity,
+                            .samples = vk::SampleCountFlagBits::e1,
+                            .tiling = vk::ImageTiling::eOptimal,
+                            .usage = vk::ImageUsageFlagBits::eSampled |
+                                     vk::ImageUsageFlagBits::eColorAttachment,
+                            .sharingMode = vk::SharingMode::eExclusive,
+                    },
+                    VmaAllocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE});
+            this->view = parent->createImageView(vk::ImageViewCreateInfo{
+                    .image = this->image,
+                    .viewType = vk::ImageViewType::e2DArray,
+                    .format = parent.format(),
+                    .subresourceRange = layer_range(0, capacity),
+            });
+            this->depth = texture{parent,
+                                  size,
+                                  size,
+                                  parent.depth_texture_format(),
+                                  vk::ImageUsageFlagBits::eDepthStencilAttachment,
+                                  vk::ImageAspectFlagBits::eDepth};
+
+            descriptor_writer writer;
+            for (const vk::DescriptorSet set: this->descriptor) {
+                writer.write_image(set, 0, vk::DescriptorType::eCombinedImageSampler,
+                                   vk::DescriptorImageInfo{
+                                           .sampler = this->sampler,
+                                           .imageView = this->view,
+                                           .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                                   });
+            }
+            writer.flush(parent);
+
+            // Layers that haven't been baked yet are sampled like any other, so they start out
+            // in the layout the draws expect
+            command_buffer cmdbuf{parent};
+            cmdbuf->pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                    vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {},
+                                    vk::ImageMemoryBarrier{
+                                            .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+                                            .oldLayout = vk::ImageLayout::eUndefined,
+                                            .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                                            .image = this->image,
+                                            .subresourceRange = layer_range(0, capacity),
+                                    });
+            std::move(cmdbuf).submit_and_wait();
+        } catch (...) {
+            std::move(*this).destroy(parent);
+            throw;
+        }
+        this->baked.reserve(capacity);
+    }
+
+    uint32_t impostor_atlas::bake(window& parent, const math::sphere& bounds,
+                                  void (*draw)(void*, vk::CommandBuffer, const glm::mat4&),
+                                  void* context) {
+        if (this->baked.size() >= this->layer_count) throw vgi_error{"impostor atlas is full"};
+        if (bounds.empty()) throw vgi_error{"impostors need non-empty bounds"};
+        const uint32_t layer = static_cast<uint32_t>(this->baked.size());
+        const uint32_t size = this->view_resolution * this->grid_size;
+
+        const vk::ImageView target = parent->createImageView(vk::ImageViewCreateInfo{
+                .image = this->image,
+                .viewType = vk::ImageViewType::e2D,
+                .format = parent.format(),
+                .subresourceRange = layer_range(layer, 1),
+        });
+        try {
+            command_buffer cmdbuf{parent};
+            // Previous contents of the layer (and the depth of the last bake) are discarded
+            cmdbuf->pipelineBarrier(
+                    vk::PipelineStageFlagBits::eFragmentShader,
+                    vk::PipelineStageFlagBits::eColorAttachmentOutput, {}, {}, {},
+                    vk::ImageMemoryBarrier{
+                            .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
+                            .oldLayout = vk::ImageLayout::eUndefined,
+                            .newLayout = vk::ImageLayout::eColorAttachmentOptimal,
+                            .image = this->image,
+                            .subresourceRange = layer_range(layer, 1),
+                    });
+            this->depth.change_layout(cmdbuf, vk::ImageLayout::eUndefined,
+                                      vk::ImageLayout::eDepthAttachmentOptimal,
+                                      vk::PipelineStageFlagBits::eTopOfPipe,
+                                      vk::PipelineStageFlagBits::eEarlyFragmentTests);
+
+            const vk::RenderingAttachmentInfo color_attachment{
+                    .imageView = target,
+                    .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+                    .loadOp = vk::AttachmentLoadOp::eClear,
+                    .storeOp = vk::AttachmentStoreOp::eStore,
+                    .clearValue = {.color = {.float32 = {{0.0f, 0.0f, 0.0f, 0.0f}}}},
+            };
+            const vk::RenderingAttachmentInfo depth_attachment{
+                    .imageView = this->depth,
+                    .imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
+                    .loadOp = vk::AttachmentLoadOp::eClear,
+                    .storeOp = vk::AttachmentStoreOp::eDontCare,
+                    .clearValue = {.depthStencil = {.depth = 1.0f, .stencil = 0}},
+            };
+            cmdbuf->beginRendering(vk::RenderingInfo{
+                    .renderArea = {.extent = {size, size}},
+                    .layerCount = 1,
+                    .colorAttachmentCount = 1,
+                    .pColorAttachments = &color_attachment,
+                    .pDepthAttachment = &depth_attachment,
+            });
+
+            // Every view frames the bounding sphere with an orthographic camera, flipped like the
+            // perspective ones (see `vgi::math::perspective_camera::projection`)
+            const float radius = (std::max)(bounds.radius, 1e-6f);
+            glm::mat4 projection =
+                    glm::ortho(-radius, radius, -radius, radius, 0.0f, 4.0f * radius);
+            projection[1] = -projection[1];
+
+            for (uint32_t y = 0; y < this->grid_size; ++y) {
+                for (uint32_t x = 0; x < this->grid_size; ++x) {
+                    const vk::Offset2D offset{static_cast<int32_t>(x * this->view_resolution),
+                                              static_cast<int32_t>(y * this->view_resolution)};
+                    cmdbuf->setViewport(0, vk::Viewport{
+                                                   .x = static_cast<float>(offset.x),
+                                                   .y = static_cast<float>(offset.y),
+                                                   .width = static_cast<float>(
+                                                           this->view_resolution),
+                                                   .height = static_cast<float>(
+                                                           this->view_resolution),
+                                                   .minDepth = 0.0f,
+                                                   .maxDepth = 1.0f,
+                                           });
+                    cmdbuf->setScissor(0, vk::Rect2D{
+                                                  .offset = offset,
+                                                  .extent = {this->view_resolution,
+                                                             this->view_resolution},
+                                          });
+
+                    const glm::vec3 direction = view_direction(x, y, this->grid_size);
+                    const glm::mat4 view = glm::lookAt(bounds.center + 2.0f * radius * direction,
+                                                       bounds.center, view_up(direction));
+                    draw(context, cmdbuf, projection * view);
+                }
+            }
+            cmdbuf->endRendering();
+
+            cmdbuf->pipelineBarrier(
+                    vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                    vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {},
+                    vk::ImageMemoryBarrier{
+                            .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
+                            .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+                            .oldLayout = vk::ImageLayout::eColorAttachmentOptimal,
+                            .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                            .image = this->image,
+                            .subresourceRange = layer_range(layer, 1),
+                    });
+            std::move(cmdbuf).submit_and_wait();
+        } catch (...) {
+            parent->destroyImageView(target);
+            throw;
+        }
+        parent->destroyImageView(target);
+
+        this->baked.push_back(bounds);
+        return layer;
+    }
+
+    bool impostor_atlas::fits(const math::sphere& bounds, const glm::mat4& view,
+                              float projection_scale) const noexcept {
+        if (bounds.empty()) return true;
+        const float distance = glm::length(glm::vec3{view * glm::vec4{bounds.center, 1.0f}});
+        if (distance <= bounds.radius) return false;
+        // Views are always drawn at the distance of the sphere's center
+        return 2.0f * bounds.radius * std::abs(projection_scale) / distance <=
+               static_cast<float>(this->view_resolution);
+    }
+
+    void impostor_atlas::draw(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                              std::span<const impostor_instance> instances,
+                              const glm::mat4& view_projection,
+                              const glm::vec3& camera_origin) const {
+        if (instances.empty()) return;
+        std::optional<uint32_t> count = math::check_cast<uint32_t>(instances.size());
+        if (!count) throw vgi_error{"too many impostors"};
+
+        this->pipeline.bind(cmdbuf);
+        cmdbuf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, this->pipeline, 0,
+                                  this->descriptor[current_frame], {});
+        cmdbuf.pushConstants(this->pipeline, vk::ShaderStageFlagBits::eVertex, UINT32_C(0),
+                             vk::ArrayProxy<const impostor_constants>{impostor_constants{
+                                     .view_projection = view_projection,
+                                     .camera_origin = camera_origin,
+                                     .grid = this->grid_size,
+                             }});
+        parent.transient().push(current_frame, instances).bind_vertices(cmdbuf, 0);
+        // Every quad is a strip of two triangles, generated from the vertex index
+        cmdbuf.draw(4, *count, 0, 0);
+    }
+
+    void impostor_atlas::destroy(const window& parent) && noexcept {
+        std::move(this->depth).destroy(parent);
+        if (this->view) parent->destroyImageView(this->view);
+        if (this->image) parent.destroy_image(this->image, this->allocation);
+        if (this->sampler) parent->destroySampler(this->sampler);
+        std::move(this->descriptor).destroy(parent);
+        std::move(this->pipeline).destroy(parent);
+    }
+}  // namespace vgi
@@ -0,0 +1,216 @@
+/*! \file */
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <vgi/math/bounds.hpp>
+#include <vgi/pipeline.hpp>
+#include <vgi/pipeline/vertex_input.hpp>
+#include <vgi/resource.hpp>
+#include <vgi/texture.hpp>
+#include <vgi/vulkan.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    /// @brief Per-instance data of the impostors drawn by `vgi::impostor_atlas`, fetched at
+    /// `vk::VertexInputRate::eInstance`
+    struct impostor_instance {
+        /// @brief Shader input location of `center` and `radius`, read as a single `vec4`
+        constexpr static inline const uint32_t SPHERE = 0;
+        /// @brief Shader input location of `layer`
+        constexpr static inline const uint32_t LAYER = 1;
+
+        /// @brief Center of the instance's bounding sphere, in world space
+        glm::vec3 center{0.0f};
+        /// @brief Radius of the instance's bounding sphere, in world space
+        float radius = 0.0f;
+        /// @brief Layer of the atlas that holds the views of the instance's mesh
+        uint32_t layer = 0;
+
+        /// @brief Layout of the stream's attributes
+        /// @sa vgi::vertex_layout
+        constexpr static std::array<vertex_attribute, 2> attributes() noexcept {
+            return {{
+                    {
+                            .location = SPHERE,
+                            .format = vk::Format::eR32G32B32A32Sfloat,
+                            .offset = offsetof(impostor_instance, center),
+                    },
+                    {
+                            .location = LAYER,
+                            .format = vk::Format::eR32Uint,
+                            .offset = offsetof(impostor_instance, layer),
+                    },
+            }};
+        }
+    };
+    static_assert(sizeof(impostor_instance) == 20);
+    static_assert(vertex_layout<impostor_instance>);
+
+    /// @brief Pre-rendered views of meshes, which stand in for them once they only cover a few
+    /// pixels on screen
+    /// @details Every mesh baked into the atlas gets a layer of a texture array, split into a
+    /// grid of views. Views are taken from directions spread over the whole sphere with an
+    /// octahedral mapping, each with an orthographic camera that frames the mesh's bounding
+    /// sphere. Meshes are drawn by the caller, with their own pipeline, so impostors look just
+    /// like the meshes they replace.
+    ///
+    /// Impostors are drawn as camera-facing quads, textured with the view taken from the
+    /// direction nearest to the camera, with a single instanced draw for every instance of every
+    /// baked mesh (see `impostor.vert` and `impostor.frag`). Views are baked in model space, so
+    /// instances are drawn with the orientation of their mesh at bake time.
+    ///
+    /// Meshes are usually switched to their impostors once their coarsest level of detail is
+    /// selected (see `vgi::gltf::primitive::select_lod`) and they `fit` within a view.
+    class impostor_atlas {
+    public:
+        /// @brief Default size of every view, in texels
+        constexpr static inline const uint32_t DEFAULT_RESOLUTION = 128;
+        /// @brief Default number of views on each side of a layer's grid
+        constexpr static inline const uint32_t DEFAULT_GRID = 8;
+
+        /// @brief Default constructor
+        impostor_atlas() = default;
+
+        /// @brief Creates a new, empty atlas
+        /// @param parent Window that will create the atlas
+        /// @param vertex The compiled `impostor.vert` shader
+        /// @param fragment The compiled `impostor.frag` shader
+        /// @param capacity Maximum number of meshes that can be baked
+        /// @param resolution Size of every view, in texels
+        /// @param grid Number of views on each side of a layer's grid
+        impostor_atlas(window& parent, const shader_stage& vertex, const shader_stage& fragment,
+                       uint32_t capacity, uint32_t resolution = DEFAULT_RESOLUTION,
+                       uint32_t grid = DEFAULT_GRID);
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        impostor_atlas(impostor_atlas&& other) noexcept :
+            pipeline(std::move(other.pipeline)), descriptor(std::move(other.descriptor)),
+            sampler(std::exchange(other.sampler, nullptr)),
+            image(std::exchange(other.image, nullptr)),
+            allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
+            view(std::exchange(other.view, nullptr)), depth(std::move(other.depth)),
+            baked(std::move(other.baked)), layer_count(std::exchange(other.layer_count, 0)),
+            view_resolution(std::exchange(other.view_resolution, 0)),
+            grid_size(std::exchange(other.grid_size, 0)) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        impostor_atlas& operator=(impostor_atlas&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Maximum number of meshes that can be baked
+        inline uint32_t capacity() const noexcept { return this->layer_count; }
+        /// @brief Number of meshes baked so far
+        inline uint32_t size() const noexcept { return static_cast<uint32_t>(this->baked.size()); }
+        /// @brief Size of every view, in texels
+        inline uint32_t resolution() const noexcept { return this->view_resolution; }
+        /// @brief Number of views on each side of a layer's grid
+        inline uint32_t grid() const noexcept { return this->grid_size; }
+
+        /// @brief Bounding sphere a mesh was baked with, in model space
+        /// @param layer Layer of the mesh
+        inline const math::sphere& bounds(uint32_t layer) const noexcept {
+            VGI_ASSERT(layer < this->baked.size());
+            return this->baked[layer];
+        }
+
+        /// @brief Renders every view of a mesh into a new layer, and waits for it to complete
+        /// @details Every view is recorded within the same rendering, onto attachments with the
+        /// window's color and depth formats, with its viewport and scissor already set. `draw`
+        /// must bind a pipeline and record the mesh's draws with the provided view-projection
+        /// matrix, once per view. Texels the mesh doesn't cover stay transparent.
+        /// @param parent Window that created the atlas
+        /// @param bounds Bounding sphere of the mesh, in model space
+        /// @param draw Function that records the mesh's draws, given a command buffer and a
+        /// view-projection matrix
+        /// @return Layer of the mesh
+        /// @throws `vgi::vgi_error` if the atlas is already full
+        template<class F>
+            requires(std::invocable<F&, vk::CommandBuffer, const glm::mat4&>)
+        uint32_t bake(window& parent, const math::sphere& bounds, F&& draw) {
+            using function = std::remove_reference_t<F>;
+            return this->bake(
+                    parent, bounds,
+                    [](void* context, vk::CommandBuffer cmdbuf, const glm::mat4& view_projection) {
+                        (*static_cast<function*>(context))(cmdbuf, view_projection);
+                    },
+                    const_cast<void*>(static_cast<const void*>(std::addressof(draw))));
+        }
+
+        /// @brief Instance that draws a baked mesh as an impostor
+        /// @param layer Layer of the mesh
+        /// @param model Model matrix of the instance. Only its translation and scale are used.
+        inline impostor_instance instance(uint32_t layer, const glm::mat4& model) const noexcept {
+            const math::sphere world = this->bounds(layer).transform(model);
+            return impostor_instance{
+                    .center = world.center,
+                    .radius = world.radius,
+                    .layer = layer,
+            };
+        }
+
+        /// @brief Checks whether a mesh is small enough on screen to be drawn as an impostor,
+        /// without losing detail
+        /// @param bounds Bounding sphere of the mesh, in world space
+        /// @param view View matrix of the camera
+        /// @param projection_scale Size on screen, in pixels, of a unit of length one unit away
+        /// from the camera (see `vgi::math::perspective_camera::projection_scale`)
+        bool fits(const math::sphere& bounds, const glm::mat4& view,
+                  float projection_scale) const noexcept;
+
+        /// @brief Draws impostors with a single instanced draw
+        /// @details Must be called from `layer::on_render`, since it binds its own pipeline.
+        /// @param parent Window whose transient buffer stores the instances
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param current_frame Index of the current frame
+        /// @param instances Impostors to be drawn
+        /// @param view_projection Matrix that transforms from world to clip space
+        /// @param camera_origin Position of the camera, in world space
+        /// @throws `vgi::vgi_error` if the frame's transient buffer runs out of memory
+        void draw(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                  std::span<const impostor_instance> instances, const glm::mat4& view_projection,
+                  const glm::vec3& camera_origin) const;
+
+        /// @brief Destroys the atlas
+        /// @param parent Window used to create the atlas
+        void destroy(const window& parent) && noexcept;
+
+        impostor_atlas(const impostor_atlas&) = delete;
+        impostor_atlas& operator=(const impostor_atlas&) = delete;
+
+    private:
+        graphics_pipeline pipeline;
+        descriptor_pool descriptor;
+        vk::Sampler sampler;
+        vk::Image image;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        vk::ImageView view;
+        // Depth attachment shared by every bake
+        texture depth;
+        std::vector<math::sphere> baked;
+        uint32_t layer_count = 0;
+        uint32_t view_resolution = 0;
+        uint32_t grid_size = 0;
+
+        uint32_t bake(window& parent, const math::sphere& bounds,
+                      void (*draw)(void*, vk::CommandBuffer, const glm::mat4&), void* context);
+    };
+
+    /// @brief A guard that destroys the impostor atlas when dropped.
+    using impostor_atlas_guard = resource_guard<impostor_atlas>;
+}  // namespace vgi
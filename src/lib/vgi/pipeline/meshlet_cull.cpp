@@ -0,0 +1,153 @@
+#include "meshlet_cull.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <vgi/math.hpp>
+#include <vgi/vgi.hpp>
+
+namespace vgi {
+    // Matches the push constants of the `meshlet_cull.comp` shader (with std430 layout)
+    struct cull_constants {
+        glm::mat4 mvp;
+        glm::vec3 eye;
+        uint32_t meshlet_count;
+        vk::DeviceAddress meshlets;
+        vk::DeviceAddress commands;
+        vk::DeviceAddress count;
+        uint32_t first_index;
+        int32_t vertex_offset;
+        uint32_t first_instance;
+    };
+    static_assert(offsetof(cull_constants, meshlets) == 80);
+    static_assert(offsetof(cull_constants, first_instance) == 112);
+
+    constexpr static inline const vk::PushConstantRange CULL_PUSH_CONSTANTS{
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            .offset = 0,
+            .size = offsetof(cull_constants, first_instance) + sizeof(uint32_t),
+    };
+
+    meshlet_culler::meshlet_culler(const window& parent, const shader_stage& shader,
+                                   uint32_t max_draws, uint32_t max_ranges) :
+        pipeline(parent, shader, {}, std::span{&CULL_PUSH_CONSTANTS, 1}), max_draws(max_draws),
+        max_ranges(max_ranges) {
+        VGI_ASSERT(max_draws > 0 && max_ranges > 0);
+
+        try {
+            if (!parent.device().feats_1_2().drawIndirectCount) {
+                throw vgi_error{"device does not support indirect draw counts"};
+            }
+
+            // Counts are as aligned as the commands, so the latter can follow them right away
+            static_assert(alignof(vk::DrawIndexedIndirectCommand) == alignof(uint32_t));
+            std::optional<vk::DeviceSize> commands_size = math::check_mul<vk::DeviceSize>(
+                    max_draws, sizeof(vk::DrawIndexedIndirectCommand));
+            std::optional<vk::DeviceSize> frame_size =
+                    commands_size ? math::check_add<vk::DeviceSize>(
+                                            *commands_size, max_ranges * sizeof(uint32_t))
+                                  : std::nullopt;
+            std::optional<vk::DeviceSize> size =
+                    frame_size ? math::check_mul<vk::DeviceSize>(*frame_size,
+                                                                 window::MAX_FRAMES_IN_FLIGHT)
+                               : std::nullopt;
+            if (!size) throw vgi_error{"too many meshlet draws"};
+            this->frame_size = *frame_size;
+
+            // Draws are written and read by the device alone
+            std::tie(this->buffer, this->allocation) = parent.create_buffer(
+                    vk::BufferCreateInfo{
+                            .size = *size,
+                            .usage = vk::BufferUsageFlagBits::eIndirectBuffer |
+                                     vk::BufferUsageFlagBits::eStorageBuffer |
+                                     vk::BufferUsageFlagBits::eShaderDeviceAddress |
+                                     vk::BufferUsageFlagBits::eTransferDst,
+                    },
+                    VmaAllocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE});
+            this->address =
+                    parent->getBufferAddress(vk::BufferDeviceAddressInfo{.buffer = this->buffer});
+        } catch (...) {
+            std::move(this->pipeline).destroy(parent);
+            throw;
+        }
+    }
+
+    void meshlet_culler::begin(vk::CommandBuffer cmdbuf, uint32_t current_frame) {
+        VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+        this->draw_head = 0;
+        this->range_head = 0;
+
+        // Only the counts need to be reset, since commands past them are never read
+        cmdbuf.fillBuffer(this->buffer, current_frame * this->frame_size,
+                          this->max_ranges * sizeof(uint32_t), 0);
+        cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                               vk::PipelineStageFlagBits::eComputeShader, {},
+                               vk::MemoryBarrier{
+                                       .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                                       .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                        vk::AccessFlagBits::eShaderWrite,
+                               },
+                               {}, {});
+        this->pipeline.bind(cmdbuf);
+    }
+
+    meshlet_draws meshlet_culler::cull(vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                                       const geometry_range& range, const glm::mat4& model,
+                                       const glm::mat4& view_projection, const glm::vec3& eye,
+                                       uint32_t first_instance) {
+        VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+        VGI_ASSERT(range.meshlet_count > 0);
+        if (this->range_head >= this->max_ranges) throw vgi_error{"too many culled ranges"};
+        if (range.meshlet_count > this->max_draws - this->draw_head) {
+            throw vgi_error{"too many culled meshlets"};
+        }
+
+        const vk::DeviceSize frame_offset = current_frame * this->frame_size;
+        const vk::DeviceSize count = frame_offset + this->range_head * sizeof(uint32_t);
+        const vk::DeviceSize commands = frame_offset + this->max_ranges * sizeof(uint32_t) +
+                                        this->draw_head * sizeof(vk::DrawIndexedIndirectCommand);
+        ++this->range_head;
+        this->draw_head += range.meshlet_count;
+
+        // The frustum is tested in model space, where the meshlet bounds are
+        const cull_constants constants{
+                .mvp = view_projection * model,
+                .eye = glm::vec3{glm::inverse(model) * glm::vec4{eye, 1.0f}},
+                .meshlet_count = range.meshlet_count,
+                .meshlets = range.meshlets,
+                .commands = this->address + commands,
+                .count = this->address + count,
+                .first_index = range.first_index,
+                .vertex_offset = range.vertex_offset,
+                .first_instance = first_instance,
+        };
+        cmdbuf.pushConstants(this->pipeline, CULL_PUSH_CONSTANTS.stageFlags,
+                             CULL_PUSH_CONSTANTS.offset, CULL_PUSH_CONSTANTS.size,
+                             static_cast<const void*>(&constants));
+        this->pipeline.dispatch(cmdbuf, range.meshlet_count / WORKGROUP_SIZE +
+                                                (range.meshlet_count % WORKGROUP_SIZE != 0));
+
+        return meshlet_draws{
+                .buffer = this->buffer,
+                .commands = commands,
+                .count = count,
+                .max_count = range.meshlet_count,
+        };
+    }
+
+    void meshlet_culler::end(vk::CommandBuffer cmdbuf) const noexcept {
+        cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                               vk::PipelineStageFlagBits::eDrawIndirect, {},
+                               vk::MemoryBarrier{
+                                       .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                                       .dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead,
+                               },
+                               {}, {});
+    }
+
+    void meshlet_culler::destroy(const window& parent) && noexcept {
+        if (this->buffer) parent.destroy_buffer(this->buffer, this->allocation);
+        std::move(this->pipeline).destroy(parent);
+    }
+}  // namespace vgi
@@ -0,0 +1,138 @@
+/*! \file */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <utility>
+#include <vgi/buffer/geometry.hpp>
+#include <vgi/pipeline.hpp>
+#include <vgi/resource.hpp>
+#include <vgi/vulkan.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    /// @brief Indirect draws of the meshlets of a range that survived culling
+    /// @details The draws are only valid for the frame they were culled on.
+    struct meshlet_draws {
+        /// @brief Buffer that contains the draw commands and their count
+        vk::Buffer buffer;
+        /// @brief Offset of the first draw command, in bytes
+        vk::DeviceSize commands = 0;
+        /// @brief Offset of the number of draw commands, in bytes
+        vk::DeviceSize count = 0;
+        /// @brief Maximum number of draw commands (the number of meshlets of the range)
+        uint32_t max_count = 0;
+
+        /// @brief Draws the visible meshlets using the bounded properties of the command buffer
+        /// @param cmdbuf Command buffer into which the command is recorded.
+        /// @warning This method assumes that the range's page is the one currently bound.
+        inline void draw(vk::CommandBuffer cmdbuf) const noexcept {
+            cmdbuf.drawIndexedIndirectCount(this->buffer, this->commands, this->buffer, this->count,
+                                            this->max_count,
+                                            sizeof(vk::DrawIndexedIndirectCommand));
+        }
+    };
+
+    /// @brief A compute pass that culls the meshlets of geometry ranges
+    /// @details Meshlets are culled against the view frustum and their normal cones, so that only
+    /// the clusters that may be visible reach the rasterizer. Every visible meshlet is written as
+    /// an indexed indirect draw, and all the draws of a range are issued with a single
+    /// `vkCmdDrawIndexedIndirectCount`.
+    ///
+    /// The pass runs the `meshlet_cull.comp` shader, which reads the meshlets straight from the
+    /// geometry pool through their device address. Culling must be recorded before rendering
+    /// starts (i.e. on `layer::on_update`):
+    /// 1. `begin` resets the draws of the frame.
+    /// 2. `cull` is called for every range to be drawn.
+    /// 3. `end` makes the draws visible to the indirect draw commands.
+    ///
+    /// @warning Meshlet bounds are computed from the mesh's rest pose, so skinned or otherwise
+    /// deformed meshes must not be culled this way.
+    class meshlet_culler {
+    public:
+        /// @brief Number of meshlets culled by every workgroup of the shader
+        constexpr static inline const uint32_t WORKGROUP_SIZE = 64;
+
+        /// @brief Default constructor
+        meshlet_culler() = default;
+
+        /// @brief Creates a new meshlet culler
+        /// @param parent Window that will create the culler
+        /// @param shader The compiled `meshlet_cull.comp` shader
+        /// @param max_draws Maximum number of meshlets culled on every frame
+        /// @param max_ranges Maximum number of ranges culled on every frame
+        /// @throws `vgi::vgi_error` if the device doesn't support indirect draw counts
+        meshlet_culler(const window& parent, const shader_stage& shader, uint32_t max_draws,
+                       uint32_t max_ranges = 1024);
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        meshlet_culler(meshlet_culler&& other) noexcept :
+            pipeline(std::move(other.pipeline)), buffer(std::exchange(other.buffer, nullptr)),
+            allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
+            address(std::exchange(other.address, 0)),
+            frame_size(std::exchange(other.frame_size, 0)),
+            max_draws(std::exchange(other.max_draws, 0)),
+            max_ranges(std::exchange(other.max_ranges, 0)),
+            draw_head(std::exchange(other.draw_head, 0)),
+            range_head(std::exchange(other.range_head, 0)) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        meshlet_culler& operator=(meshlet_culler&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Resets the draws of the frame and binds the culling pipeline
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param current_frame Index of the current frame
+        void begin(vk::CommandBuffer cmdbuf, uint32_t current_frame);
+
+        /// @brief Culls the meshlets of a range
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param current_frame Index of the current frame
+        /// @param range Range to be culled. Must have been allocated with its meshlets.
+        /// @param model Model matrix of the range
+        /// @param view_projection View-projection matrix of the camera
+        /// @param eye Position of the camera, in world space
+        /// @param first_instance Instance ID of the draws
+        /// @return The draws of the visible meshlets
+        /// @throws `vgi::vgi_error` if the frame has run out of draws
+        meshlet_draws cull(vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                           const geometry_range& range, const glm::mat4& model,
+                           const glm::mat4& view_projection, const glm::vec3& eye,
+                           uint32_t first_instance = 0);
+
+        /// @brief Makes the draws of the frame visible to indirect draw commands
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        void end(vk::CommandBuffer cmdbuf) const noexcept;
+
+        /// @brief Destroys the culler
+        /// @param parent Window used to create the culler
+        void destroy(const window& parent) && noexcept;
+
+        meshlet_culler(const meshlet_culler&) = delete;
+        meshlet_culler& operator=(const meshlet_culler&) = delete;
+
+    private:
+        compute_pipeline pipeline;
+        // Every frame holds the draw counts of its ranges, followed by the draw commands
+        vk::Buffer buffer;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        vk::DeviceAddress address = 0;
+        vk::DeviceSize frame_size = 0;
+        uint32_t max_draws = 0;
+        uint32_t max_ranges = 0;
+        uint32_t draw_head = 0;
+        uint32_t range_head = 0;
+    };
+
+    /// @brief A guard that destroys the meshlet culler when dropped.
+    using meshlet_culler_guard = resource_guard<meshlet_culler>;
+}  // namespace vgi
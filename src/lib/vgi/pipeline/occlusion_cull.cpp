@@ -0,0 +1,308 @@
+#include "occlusion_cull.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <tuple>
+#include <vgi/buffer/transient.hpp>
+#include <vgi/math.hpp>
+#include <vgi/math/frustum.hpp>
+#include <vgi/pipeline/descriptor.hpp>
+#include <vgi/vgi.hpp>
+
+namespace vgi {
+    // Matches the `Object` struct of the `occlusion_cull.comp` shader (with std430 layout)
+    struct alignas(16) culled_object {
+        glm::vec3 center;
+        float radius;
+        uint32_t index_count;
+        uint32_t first_index;
+        int32_t vertex_offset;
+        uint32_t first_instance;
+        uint32_t bucket;
+        uint32_t first_command;
+        uint32_t padding[2];
+    };
+    static_assert(sizeof(culled_object) == 48);
+
+    // Matches the `Params` struct of the `occlusion_cull.comp` shader (with std430 layout)
+    struct alignas(16) cull_params {
+        glm::mat4 view;
+        std::array<glm::vec4, 6> planes;
+        float p00;
+        float p11;
+        float p22;
+        float p32;
+        glm::vec2 pyramid_size;
+    };
+    static_assert(offsetof(cull_params, p00) == 160);
+    static_assert(offsetof(cull_params, pyramid_size) == 176);
+
+    // Matches the push constants of the `occlusion_cull.comp` shader (with std430 layout)
+    struct occlusion_constants {
+        vk::DeviceAddress params;
+        vk::DeviceAddress objects;
+        vk::DeviceAddress visibility;
+        vk::DeviceAddress commands;
+        vk::DeviceAddress counts;
+        uint32_t object_count;
+        uint32_t late;
+    };
+    static_assert(sizeof(occlusion_constants) == 48);
+
+    constexpr static inline const vk::PushConstantRange OCCLUSION_PUSH_CONSTANTS{
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            .offset = 0,
+            .size = sizeof(occlusion_constants),
+    };
+
+    // Matches the bindings of the `occlusion_cull.comp` shader
+    constexpr static inline const vk::DescriptorSetLayoutBinding OCCLUSION_BINDINGS[] = {
+            {
+                    .binding = 0,
+                    .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                    .descriptorCount = 1,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            },
+    };
+
+    occlusion_culler::occlusion_culler(const window& parent, const shader_stage& shader,
+                                       const shader_stage& pyramid_shader, uint32_t max_objects,
+                                       uint32_t max_pages) :
+        pipeline(parent, shader, std::span{OCCLUSION_BINDINGS},
+                 std::span{&OCCLUSION_PUSH_CONSTANTS, 1}),
+        max_objects(max_objects), max_pages(max_pages) {
+        VGI_ASSERT(max_objects > 0 && max_pages > 0);
+
+        try {
+            if (!parent.device().feats_1_2().drawIndirectCount) {
+                throw vgi_error{"device does not support indirect draw counts"};
+            }
+
+            // Every frame holds the counts of both phases, followed by their commands
+            static_assert(alignof(vk::DrawIndexedIndirectCommand) == alignof(uint32_t));
+            std::optional<vk::DeviceSize> commands_size = math::check_mul<vk::DeviceSize>(
+                    2 * vk::DeviceSize{max_objects}, sizeof(vk::DrawIndexedIndirectCommand));
+            std::optional<vk::DeviceSize> frame_size =
+                    commands_size ? math::check_add<vk::DeviceSize>(
+                                            *commands_size, 2 * max_pages * sizeof(uint32_t))
+                                  : std::nullopt;
+            std::optional<vk::DeviceSize> frames_size =
+                    frame_size ? math::check_mul<vk::DeviceSize>(*frame_size,
+                                                                 window::MAX_FRAMES_IN_FLIGHT)
+                               : std::nullopt;
+            std::optional<vk::DeviceSize> size =
+                    frames_size ? math::check_add<vk::DeviceSize>(
+                                          *frames_size, max_objects * sizeof(uint32_t))
+                                : std::nullopt;
+            if (!size) throw vgi_error{"too many occlusion culled objects"};
+            this->frame_size = *frame_size;
+
+            this->pyramid = depth_pyramid{parent, pyramid_shader};
+            this->descriptors = descriptor_pool{parent, this->pipeline};
+
+            // Draws and visibility are written and read by the device alone
+            std::tie(this->buffer, this->allocation) = parent.create_buffer(
+                    vk::BufferCreateInfo{
+                            .size = *size,
+                            .usage = vk::BufferUsageFlagBits::eIndirectBuffer |
+                                     vk::BufferUsageFlagBits::eStorageBuffer |
+                                     vk::BufferUsageFlagBits::eShaderDeviceAddress |
+                                     vk::BufferUsageFlagBits::eTransferDst,
+                    },
+                    VmaAllocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE});
+            this->address =
+                    parent->getBufferAddress(vk::BufferDeviceAddressInfo{.buffer = this->buffer});
+        } catch (...) {
+            std::move(*this).destroy(parent);
+            throw;
+        }
+    }
+
+    void occlusion_culler::cull_early(window& parent, vk::CommandBuffer cmdbuf,
+                                      uint32_t current_frame,
+                                      std::span<const occlusion_object> objects,
+                                      const glm::mat4& view, const glm::mat4& projection) {
+        VGI_ASSERT(current_frame < window::MAX_FRAMES_IN_FLIGHT);
+        if (objects.size() > this->max_objects) {
+            throw vgi_error{"too many occlusion culled objects"};
+        }
+
+        this->current_frame = current_frame;
+        this->object_count = 0;
+        this->buckets.clear();
+        if (objects.empty()) return;
+
+        // Draws are grouped by page, so that every page is drawn with a single indirect draw
+        auto find_bucket = [&](uint32_t page) {
+            return std::ranges::find(this->buckets, page,
+                                     [](const page_bucket& bucket) { return bucket.range.page; });
+        };
+        for (const occlusion_object& object: objects) {
+            auto bucket = find_bucket(object.range.page);
+            if (bucket == this->buckets.end()) {
+                if (this->buckets.size() >= this->max_pages) {
+                    throw vgi_error{"too many occlusion culled pages"};
+                }
+                bucket = this->buckets.insert(bucket, page_bucket{.range = object.range});
+            }
+            ++bucket->command_count;
+        }
+        uint32_t first_command = 0;
+        for (page_bucket& bucket: this->buckets) {
+            bucket.first_command = first_command;
+            first_command += bucket.command_count;
+        }
+
+        transient_slice<culled_object> culled =
+                parent.transient().allocate<culled_object>(current_frame, objects.size());
+        for (size_t i = 0; i < objects.size(); ++i) {
+            const occlusion_object& object = objects[i];
+            const auto bucket = find_bucket(object.range.page);
+            culled.data[i] = culled_object{
+                    .center = object.bounds.center,
+                    .radius = object.bounds.radius,
+                    .index_count = object.range.index_count,
+                    .first_index = object.range.first_index,
+                    .vertex_offset = object.range.vertex_offset,
+                    .first_instance = object.first_instance,
+                    .bucket = static_cast<uint32_t>(std::distance(this->buckets.begin(), bucket)),
+                    .first_command = bucket->first_command,
+                    .padding = {},
+            };
+        }
+
+        this->pyramid.prepare(parent, cmdbuf);
+        const math::frustum frustum{projection * view};
+        const vk::Extent2D pyramid_size = this->pyramid.size();
+        this->params = parent.transient()
+                               .push(current_frame,
+                                     cull_params{
+                                             .view = view,
+                                             .planes = frustum.planes,
+                                             .p00 = projection[0][0],
+                                             .p11 = projection[1][1],
+                                             .p22 = projection[2][2],
+                                             .p32 = projection[3][2],
+                                             .pyramid_size = {pyramid_size.width,
+                                                              pyramid_size.height},
+                                     })
+                               .address;
+        this->objects = culled.address;
+        this->object_count = static_cast<uint32_t>(objects.size());
+
+        descriptor_writer writer;
+        writer.write_image(this->descriptors[current_frame], 0,
+                           vk::DescriptorType::eCombinedImageSampler,
+                           vk::DescriptorImageInfo{
+                                   .sampler = this->pyramid.texel_sampler(),
+                                   .imageView = this->pyramid.view(),
+                                   .imageLayout = vk::ImageLayout::eGeneral,
+                           });
+        writer.flush(parent);
+
+        // Reset the counts of both phases and, when the visible set is forgotten, the visibility
+        // of every object. The late phase of the last frame must also be done with the latter.
+        if (this->clear_visibility) {
+            cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                   vk::PipelineStageFlagBits::eTransfer, {},
+                                   vk::MemoryBarrier{
+                                           .srcAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                            vk::AccessFlagBits::eShaderWrite,
+                                           .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+                                   },
+                                   {}, {});
+            cmdbuf.fillBuffer(this->buffer, 0, this->max_objects * sizeof(uint32_t), 0);
+            this->clear_visibility = false;
+        }
+        cmdbuf.fillBuffer(this->buffer, this->counts_offset(0),
+                          2 * this->max_pages * sizeof(uint32_t), 0);
+        cmdbuf.pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eComputeShader, {},
+                vk::MemoryBarrier{
+                        .srcAccessMask = vk::AccessFlagBits::eTransferWrite |
+                                         vk::AccessFlagBits::eShaderWrite,
+                        .dstAccessMask =
+                                vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+                },
+                {}, {});
+
+        this->pipeline.bind(cmdbuf);
+        cmdbuf.bindDescriptorSets(vk::PipelineBindPoint::eCompute, this->pipeline, 0,
+                                  this->descriptors[current_frame], {});
+        this->dispatch(cmdbuf, 0);
+    }
+
+    void occlusion_culler::cull_late(window& parent, vk::CommandBuffer cmdbuf,
+                                     uint32_t current_frame) {
+        VGI_ASSERT(current_frame == this->current_frame);
+        if (this->object_count == 0) return;
+
+        parent.suspend_rendering(cmdbuf);
+        this->pyramid.build(parent, cmdbuf, current_frame);
+        this->pipeline.bind(cmdbuf);
+        cmdbuf.bindDescriptorSets(vk::PipelineBindPoint::eCompute, this->pipeline, 0,
+                                  this->descriptors[current_frame], {});
+        this->dispatch(cmdbuf, 1);
+        parent.resume_rendering(cmdbuf);
+    }
+
+    vk::DeviceSize occlusion_culler::counts_offset(uint32_t phase) const noexcept {
+        return this->max_objects * sizeof(uint32_t) + this->current_frame * this->frame_size +
+               phase * this->max_pages * sizeof(uint32_t);
+    }
+
+    vk::DeviceSize occlusion_culler::commands_offset(uint32_t phase) const noexcept {
+        return this->counts_offset(0) + 2 * this->max_pages * sizeof(uint32_t) +
+               phase * this->max_objects * sizeof(vk::DrawIndexedIndirectCommand);
+    }
+
+    void occlusion_culler::dispatch(vk::CommandBuffer cmdbuf, uint32_t phase) const noexcept {
+        const occlusion_constants constants{
+                .params = this->params,
+                .objects = this->objects,
+                .visibility = this->address,
+                .commands = this->address + this->commands_offset(phase),
+                .counts = this->address + this->counts_offset(phase),
+                .object_count = this->object_count,
+                .late = phase,
+        };
+        cmdbuf.pushConstants(this->pipeline, OCCLUSION_PUSH_CONSTANTS.stageFlags,
+                             OCCLUSION_PUSH_CONSTANTS.offset, OCCLUSION_PUSH_CONSTANTS.size,
+                             static_cast<const void*>(&constants));
+        this->pipeline.dispatch(cmdbuf, this->object_count / WORKGROUP_SIZE +
+                                                (this->object_count % WORKGROUP_SIZE != 0));
+
+        cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                               vk::PipelineStageFlagBits::eDrawIndirect, {},
+                               vk::MemoryBarrier{
+                                       .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                                       .dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead,
+                               },
+                               {}, {});
+    }
+
+    void occlusion_culler::draw(vk::CommandBuffer cmdbuf, uint32_t phase, uint32_t vertex_binding,
+                                vertex_streams streams) const noexcept {
+        for (size_t i = 0; i < this->buckets.size(); ++i) {
+            const page_bucket& bucket = this->buckets[i];
+            bucket.range.bind(cmdbuf, vertex_binding, streams);
+            cmdbuf.drawIndexedIndirectCount(
+                    this->buffer,
+                    this->commands_offset(phase) +
+                            bucket.first_command * sizeof(vk::DrawIndexedIndirectCommand),
+                    this->buffer, this->counts_offset(phase) + i * sizeof(uint32_t),
+                    bucket.command_count, sizeof(vk::DrawIndexedIndirectCommand));
+        }
+    }
+
+    void occlusion_culler::destroy(const window& parent) && noexcept {
+        if (this->buffer) parent.destroy_buffer(this->buffer, this->allocation);
+        std::move(this->descriptors).destroy(parent);
+        std::move(this->pyramid).destroy(parent);
+        std::move(this->pipeline).destroy(parent);
+    }
+}  // namespace vgi
@@ -0,0 +1,190 @@
+/*! \file */
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+#include <vgi/buffer/geometry.hpp>
+#include <vgi/math/bounds.hpp>
+#include <vgi/pipeline.hpp>
+#include <vgi/pipeline/depth_pyramid.hpp>
+#include <vgi/pipeline/vertex_input.hpp>
+#include <vgi/resource.hpp>
+#include <vgi/vulkan.hpp>
+#include <vgi/window.hpp>
+
+namespace vgi {
+    /// @brief An object culled by `vgi::occlusion_culler`
+    struct occlusion_object {
+        /// @brief Range to be drawn. Must have been allocated from the window's geometry pool.
+        geometry_range range;
+        /// @brief Bounding sphere of the object, in world space. Empty spheres are never drawn.
+        math::sphere bounds;
+        /// @brief Instance ID of the object's draw (i.e. to index its transform)
+        uint32_t first_instance = 0;
+    };
+
+    /// @brief A two-phase GPU occlusion culling pass, built on a `vgi::depth_pyramid`
+    /// @details Objects are culled by the `occlusion_cull.comp` shader, which writes an indexed
+    /// indirect draw for every surviving object. Draws are grouped by geometry page, and every
+    /// page is drawn with a single `vkCmdDrawIndexedIndirectCount`. A frame goes through these
+    /// steps:
+    /// 1. `cull_early`, on `layer::on_update`, culls against the frustum the objects that were
+    ///    visible on the last frame.
+    /// 2. `draw_early`, on `layer::on_render`, draws them, filling the depth attachment with
+    ///    the occluders of the frame.
+    /// 3. `cull_late` suspends the rendering, builds the depth pyramid from the attachment and
+    ///    tests every object against both the frustum and the pyramid. Its results become the
+    ///    visible set of the next frame.
+    /// 4. `draw_late` draws the visible objects that weren't drawn by `draw_early`.
+    ///
+    /// Visibility is tracked by the index of every object, so objects must be passed in the same
+    /// order on every frame (or `reset` called whenever it changes).
+    class occlusion_culler {
+    public:
+        /// @brief Number of objects culled by every workgroup of the shader
+        constexpr static inline const uint32_t WORKGROUP_SIZE = 64;
+
+        /// @brief Default constructor
+        occlusion_culler() = default;
+
+        /// @brief Creates a new occlusion culler
+        /// @param parent Window that will create the culler
+        /// @param shader The compiled `occlusion_cull.comp` shader
+        /// @param pyramid_shader The compiled `depth_pyramid.comp` shader
+        /// @param max_objects Maximum number of objects culled on every frame
+        /// @param max_pages Maximum number of geometry pages drawn on every frame
+        /// @throws `vgi::vgi_error` if the device doesn't support indirect draw counts
+        occlusion_culler(const window& parent, const shader_stage& shader,
+                         const shader_stage& pyramid_shader, uint32_t max_objects,
+                         uint32_t max_pages = 16);
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        occlusion_culler(occlusion_culler&& other) noexcept :
+            pipeline(std::move(other.pipeline)), pyramid(std::move(other.pyramid)),
+            descriptors(std::move(other.descriptors)),
+            buffer(std::exchange(other.buffer, nullptr)),
+            allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
+            address(std::exchange(other.address, 0)),
+            frame_size(std::exchange(other.frame_size, 0)),
+            max_objects(std::exchange(other.max_objects, 0)),
+            max_pages(std::exchange(other.max_pages, 0)), buckets(std::move(other.buckets)),
+            objects(std::exchange(other.objects, 0)), params(std::exchange(other.params, 0)),
+            object_count(std::exchange(other.object_count, 0)),
+            current_frame(std::exchange(other.current_frame, 0)),
+            clear_visibility(std::exchange(other.clear_visibility, true)) {}
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        occlusion_culler& operator=(occlusion_culler&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Depth pyramid the objects are tested against
+        inline const depth_pyramid& depth() const noexcept { return this->pyramid; }
+
+        /// @brief Forgets the visible set of the last frame, so that the next one draws every
+        /// object on its late phase
+        /// @details Must be called whenever the objects or their order change.
+        inline void reset() noexcept { this->clear_visibility = true; }
+
+        /// @brief Culls the objects that were visible on the last frame against the frustum
+        /// @details Must be recorded before rendering starts (i.e. on `layer::on_update`).
+        /// @param parent Window whose transient buffer stores the objects of the frame
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param current_frame Index of the current frame
+        /// @param objects Objects to be culled
+        /// @param view View matrix of the camera
+        /// @param projection Projection matrix of the camera, with a depth range of `[0, 1]`
+        /// @throws `vgi::vgi_error` if there are too many objects or pages, or the frame's
+        /// transient buffer runs out of memory
+        void cull_early(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame,
+                        std::span<const occlusion_object> objects, const glm::mat4& view,
+                        const glm::mat4& projection);
+
+        /// @brief Builds the depth pyramid, and culls every object against it
+        /// @details Must be recorded from `layer::on_render`, after the early draws. The
+        /// rendering of the window is suspended while culling, and resumed before returning.
+        ///
+        /// Culling binds compute pipelines whose layouts aren't compatible with the caller's, so
+        /// the push constants of the graphics pipeline are disturbed, and callers must push them
+        /// again before `draw_late`. Bound pipelines and descriptor sets are kept, since they are
+        /// tracked per bind point.
+        /// @param parent Window whose depth attachment builds the pyramid
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param current_frame Index of the current frame
+        void cull_late(window& parent, vk::CommandBuffer cmdbuf, uint32_t current_frame);
+
+        /// @brief Draws the objects that survived `cull_early`
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param vertex_binding Index of the vertex input binding of the position stream. The
+        /// attribute stream is bound to the next one.
+        /// @param streams Vertex streams to bind
+        inline void draw_early(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0,
+                               vertex_streams streams = vertex_streams::all) const noexcept {
+            this->draw(cmdbuf, 0, vertex_binding, streams);
+        }
+
+        /// @brief Draws the objects that survived `cull_late`, and weren't drawn by `draw_early`
+        /// @warning Push constants must be pushed again after `cull_late`
+        /// @param cmdbuf Command buffer into which the commands are recorded
+        /// @param vertex_binding Index of the vertex input binding of the position stream. The
+        /// attribute stream is bound to the next one.
+        /// @param streams Vertex streams to bind
+        inline void draw_late(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0,
+                              vertex_streams streams = vertex_streams::all) const noexcept {
+            this->draw(cmdbuf, 1, vertex_binding, streams);
+        }
+
+        /// @brief Destroys the culler
+        /// @param parent Window used to create the culler
+        void destroy(const window& parent) && noexcept;
+
+        occlusion_culler(const occlusion_culler&) = delete;
+        occlusion_culler& operator=(const occlusion_culler&) = delete;
+
+    private:
+        // Objects that share a geometry page, whose draws are contiguous
+        struct page_bucket {
+            geometry_range range;
+            uint32_t first_command = 0;
+            uint32_t command_count = 0;
+        };
+
+        compute_pipeline pipeline;
+        depth_pyramid pyramid;
+        descriptor_pool descriptors;
+        // The visibility of every object, followed by the draw counts and commands of both
+        // phases for every frame
+        vk::Buffer buffer;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        vk::DeviceAddress address = 0;
+        vk::DeviceSize frame_size = 0;
+        uint32_t max_objects = 0;
+        uint32_t max_pages = 0;
+        // State of the frame being recorded
+        std::vector<page_bucket> buckets;
+        vk::DeviceAddress objects = 0;
+        vk::DeviceAddress params = 0;
+        uint32_t object_count = 0;
+        uint32_t current_frame = 0;
+        bool clear_visibility = true;
+
+        vk::DeviceSize counts_offset(uint32_t phase) const noexcept;
+        vk::DeviceSize commands_offset(uint32_t phase) const noexcept;
+        void dispatch(vk::CommandBuffer cmdbuf, uint32_t phase) const noexcept;
+        void draw(vk::CommandBuffer cmdbuf, uint32_t phase, uint32_t vertex_binding,
+                  vertex_streams streams) const noexcept;
+    };
+
+    /// @brief A guard that destroys the occlusion culler when dropped.
+    using occlusion_culler_guard = resource_guard<occlusion_culler>;
+}  // namespace vgi
@@ -0,0 +1,144 @@
+/*! \file */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vgi/defs.hpp>
+#include <vgi/vulkan.hpp>
+
+namespace vgi {
+    /// @brief Maximum number of attributes a vertex input may fetch
+    /// @details Every Vulkan implementation supports at least this many attributes
+    constexpr static inline const uint32_t MAX_VERTEX_ATTRIBUTES = 16;
+    /// @brief Maximum number of bindings a vertex input may fetch from
+    /// @details Every Vulkan implementation supports at least this many bindings
+    constexpr static inline const uint32_t MAX_VERTEX_BINDINGS = 16;
+
+    /// @brief Describes where an attribute is located within a vertex, and how it's encoded
+    struct vertex_attribute {
+        /// @brief Shader input location of the attribute
+        uint32_t location;
+        /// @brief Format of the attribute, as read by the vertex input stage
+        vk::Format format;
+        /// @brief Offset of the attribute within the vertex, in bytes
+        uint32_t offset;
+    };
+
+    /// @brief A type that can be used as the vertex of a mesh or a graphics pipeline
+    /// @details Vertex types describe their attributes with a `constexpr` static `attributes`
+    /// method, which returns a range of `vgi::vertex_attribute`, so that the vertex input state
+    /// of pipelines can be generated at compile time.
+    template<class V>
+    concept vertex_layout = std::is_trivially_copyable_v<V> && std::is_standard_layout_v<V> &&
+                            requires {
+                                {
+                                    std::span<const vertex_attribute>{V::attributes()}
+                                };
+                                typename std::integral_constant<size_t, V::attributes().size()>;
+                            };
+
+    /// @brief Checks whether a vertex layout has an attribute at the specified location
+    /// @tparam V Vertex layout
+    /// @param location Shader input location
+    template<vertex_layout V>
+    consteval bool has_vertex_attribute(uint32_t location) noexcept {
+        constexpr auto attributes = V::attributes();
+        return std::ranges::any_of(attributes, [location](const vertex_attribute& attribute) {
+            return attribute.location == location;
+        });
+    }
+
+    /// @brief Vertex streams that may be bound
+    enum class vertex_streams {
+        /// @brief Both the position and attribute streams
+        all,
+        /// @brief Only the position stream
+        position,
+    };
+
+    /// @brief Vertex input state of a graphics pipeline
+    /// @details Vertices may be split into several streams (i.e. `vgi::vertex_position` and
+    /// `vgi::vertex_attributes`), each fetched from its own binding. A default-constructed vertex
+    /// input fetches no vertex data at all.
+    struct vertex_input {
+        /// @brief Bindings the vertices are fetched from. Only the first `binding_count` are used.
+        std::array<vk::VertexInputBindingDescription, MAX_VERTEX_BINDINGS> bindings{};
+        /// @brief Attributes fetched by the pipeline. Only the first `attribute_count` are used.
+        std::array<vk::VertexInputAttributeDescription, MAX_VERTEX_ATTRIBUTES> attributes{};
+        /// @brief Number of bindings the vertices are fetched from
+        uint32_t binding_count = 0;
+        /// @brief Number of attributes fetched by the pipeline
+        uint32_t attribute_count = 0;
+
+        /// @brief Generates the vertex input state of a vertex layout at compile time
+        /// @tparam V Vertex layout
+        /// @tparam Locations Locations of the attributes consumed by the vertex shader. If none
+        /// are specified, every attribute of the layout is fetched.
+        /// @param binding Binding the vertices are fetched from
+        /// @param input_rate Whether vertices are fetched per vertex or per instance
+        template<vertex_layout V, uint32_t... Locations>
+        constexpr static vertex_input of(
+                uint32_t binding = 0,
+                vk::VertexInputRate input_rate = vk::VertexInputRate::eVertex) noexcept {
+            return vertex_input{}.with<V, Locations...>(binding, input_rate);
+        }
+
+        /// @brief Adds a binding to the vertex input state, generated at compile time
+        /// @tparam V Vertex layout of the binding
+        /// @tparam Locations Locations of the attributes consumed by the vertex shader. If none
+        /// are specified, every attribute of the layout is fetched.
+        /// @param binding Binding the vertices are fetched from
+        /// @param input_rate Whether vertices are fetched per vertex or per instance
+        template<vertex_layout V, uint32_t... Locations>
+        constexpr vertex_input with(
+                uint32_t binding,
+                vk::VertexInputRate input_rate = vk::VertexInputRate::eVertex) const noexcept {
+            static_assert((has_vertex_attribute<V>(Locations) && ...),
+                          "the vertex layout has no attribute at one of the locations");
+            constexpr auto layout = V::attributes();
+            static_assert(std::size(layout) <= MAX_VERTEX_ATTRIBUTES,
+                          "the vertex layout has too many attributes");
+            VGI_ASSERT(this->binding_count < MAX_VERTEX_BINDINGS);
+
+            vertex_input result = *this;
+            result.bindings[result.binding_count++] = vk::VertexInputBindingDescription{
+                    .binding = binding,
+                    .stride = sizeof(V),
+                    .inputRate = input_rate,
+            };
+            for (const vertex_attribute& attribute: layout) {
+                if constexpr (sizeof...(Locations) > 0) {
+                    if (((attribute.location != Locations) && ...)) continue;
+                }
+                VGI_ASSERT(result.attribute_count < MAX_VERTEX_ATTRIBUTES);
+                result.attributes[result.attribute_count++] = vk::VertexInputAttributeDescription{
+                        .location = attribute.location,
+                        .binding = binding,
+                        .format = attribute.format,
+                        .offset = attribute.offset,
+                };
+            }
+            return result;
+        }
+
+        /// @brief Attributes fetched by the pipeline
+        constexpr std::span<const vk::VertexInputAttributeDescription> fetched() const noexcept {
+            return std::span{this->attributes.data(), this->attribute_count};
+        }
+
+        /// @brief Vertex input state used to create a pipeline
+        /// @warning The result references this object, so it must outlive it
+        constexpr vk::PipelineVertexInputStateCreateInfo create_info() const noexcept {
+            return vk::PipelineVertexInputStateCreateInfo{
+                    .vertexBindingDescriptionCount = this->binding_count,
+                    .pVertexBindingDescriptions = this->bindings.data(),
+                    .vertexAttributeDescriptionCount = this->attribute_count,
+                    .pVertexAttributeDescriptions = this->attributes.data(),
+            };
+        }
+    };
+}  // namespace vgi
@@ -1,11 +1,17 @@
 #include "mesh.hpp"
 
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
 #include <numbers>
 #include <tuple>
+#include <vector>
 
 namespace vgi {
-    template<index T>
-    size_t mesh<T>::plane_transfer_size(uint32_t points_x, uint32_t points_y) {
+    template<index T, vertex_layout V>
+    size_t mesh<T, V>::plane_transfer_size(uint32_t points_x, uint32_t points_y)
+        requires std::same_as<V, vertex_attributes>
+    {
         points_x = (std::max)(points_x, UINT32_C(2));
         points_y = (std::max)(points_y, UINT32_C(2));
 
@@ -21,10 +27,11 @@ namespace vgi {
         return transfer_size(*vertex_count, *index_count);
     }
 
-    template<index T>
-    mesh<T> mesh<T>::load_plane(const window& parent, vk::CommandBuffer cmdbuf,
-                                transfer_buffer& transfer, uint32_t points_x, uint32_t points_y,
-                                const glm::vec4& color, size_t offset) {
+    template<index T, vertex_layout V>
+    void mesh<T, V>::build_plane(std::vector<vertex>& vertices, std::vector<T>& indices,
+                                 uint32_t points_x, uint32_t points_y, const glm::vec4& color)
+        requires std::same_as<V, vertex_attributes>
+    {
         points_x = (std::max)(points_x, UINT32_C(2));
         points_y = (std::max)(points_y, UINT32_C(2));
 
@@ -32,19 +39,13 @@ namespace vgi {
         if (!raw_point_count) throw vgi_error{"too many vertices"};
         std::optional<T> vertex_count = math::check_cast<T>(*raw_point_count);
         if (!vertex_count) throw vgi_error{"too many vertices"};
-        std::optional<size_t> vertex_size = math::check_mul<size_t>(*vertex_count, sizeof(vertex));
-        if (!vertex_size) throw vgi_error{"too many vertices"};
 
         std::optional<uint32_t> index_count = math::check_mul(points_x - 1, points_y - 1);
         if (index_count) index_count = math::check_mul(UINT32_C(6), *index_count);
         if (!index_count) throw vgi_error{"too many indices"};
-        std::optional<size_t> index_size = math::check_mul<size_t>(*index_count, sizeof(T));
-        if (!index_size) throw vgi_error{"too many indices"};
 
-        const std::optional<size_t> start_index_offset = math::check_add(offset, *vertex_size);
-        if (!start_index_offset) throw vgi_error{"out of memory"};
-        size_t vertex_offset = offset;
-        size_t index_offset = *start_index_offset;
+        vertices.reserve(*vertex_count);
+        indices.reserve(*index_count);
 
         const float step_x = 1.0f / static_cast<float>(points_x - 1);
         const float step_y = 1.0f / static_cast<float>(points_y - 1);
@@ -52,11 +53,10 @@ namespace vgi {
         // Create top points
         for (uint32_t i = 0; i < points_x; ++i) {
             const float fi = static_cast<float>(i);
-            vertex_offset = transfer.write_at(vertex{{step_x * fi - 0.5f, 0.5f, 0.0f},
-                                                     color,
-                                                     {step_x * fi, 0.0f},
-                                                     {0.0f, 0.0f, 1.0f}},
-                                              vertex_offset);
+            vertices.push_back(vertex{{step_x * fi - 0.5f, 0.5f, 0.0f},
+                                      color,
+                                      {step_x * fi, 0.0f},
+                                      {0.0f, 0.0f, 1.0f}});
         }
 
         // Create remaining points
@@ -72,90 +72,106 @@ namespace vgi {
                 const T bottom_left = lower_offset + i;
                 const T bottom_right = bottom_left + 1;
 
-                vertex_offset =
-                        transfer.write_at(vertex{{step_x * fi - 0.5f, 0.5f - step_y * fj, 0.0f},
-                                                 color,
-                                                 {step_x * fi, step_y * fj},
-                                                 {0.0f, 0.0f, 1.0f}},
-                                          vertex_offset);
+                vertices.push_back(vertex{{step_x * fi - 0.5f, 0.5f - step_y * fj, 0.0f},
+                                          color,
+                                          {step_x * fi, step_y * fj},
+                                          {0.0f, 0.0f, 1.0f}});
 
-                index_offset = transfer.template write_at<T>(
-                        {top_right, top_left, bottom_left, bottom_left, bottom_right, top_right},
-                        index_offset);
+                indices.insert(indices.end(), {top_right, top_left, bottom_left, bottom_left,
+                                               bottom_right, top_right});
             }
 
             // Add rightmost vertex
             const float fi = static_cast<float>(points_x - 1);
-            vertex_offset = transfer.write_at(vertex{{step_x * fi - 0.5f, 0.5f - step_y * fj, 0.0f},
-                                                     color,
-                                                     {step_x * fi, step_y * fj},
-                                                     {0.0f, 0.0f, 1.0f}},
-                                              vertex_offset);
+            vertices.push_back(vertex{{step_x * fi - 0.5f, 0.5f - step_y * fj, 0.0f},
+                                      color,
+                                      {step_x * fi, step_y * fj},
+                                      {0.0f, 0.0f, 1.0f}});
         }
+    }
 
-        mesh result{parent, *vertex_count, *index_count};
-        cmdbuf.copyBuffer(transfer, result.vertices, vk::BufferCopy{offset, 0, *vertex_size});
-        cmdbuf.copyBuffer(transfer, result.indices,
-                          vk::BufferCopy{*start_index_offset, 0, *index_size});
-
-        return result;
+    template<index T, vertex_layout V>
+    mesh<T, V> mesh<T, V>::load_plane(const window& parent, vk::CommandBuffer cmdbuf,
+                                      transfer_buffer& transfer, uint32_t points_x,
+                                      uint32_t points_y, const glm::vec4& color, size_t offset)
+        requires std::same_as<V, vertex_attributes>
+    {
+        std::vector<vertex> vertices;
+        std::vector<T> indices;
+        build_plane(vertices, indices, points_x, points_y, color);
+        return mesh{parent, cmdbuf, transfer, vertices, indices, offset};
     }
 
-    template<index T>
-    mesh<T> mesh<T>::load_cube(const window& parent, vk::CommandBuffer cmdbuf,
-                               transfer_buffer& transfer, const glm::vec4& color, size_t offset) {
+    template<index T, vertex_layout V>
+    void mesh<T, V>::build_cube(std::vector<vertex>& vertices, std::vector<T>& indices,
+                                const glm::vec4& color)
+        requires std::same_as<V, vertex_attributes>
+    {
         constexpr float size = 0.5f;
-        const auto v0 = [&](float nx, float ny, float nz) constexpr noexcept {
+        const auto v0 = [&](float nx, float ny, float nz) noexcept {
             return vgi::vertex{{size, size, size}, color, {0.0f, 0.0f}, {nx, ny, nz}};
         };
-        const auto v1 = [&](float nx, float ny, float nz) constexpr noexcept {
+        const auto v1 = [&](float nx, float ny, float nz) noexcept {
             return vgi::vertex{{-size, size, size}, color, {1.0f, 0.0f}, {nx, ny, nz}};
         };
-        const auto v2 = [&](float nx, float ny, float nz) constexpr noexcept {
+        const auto v2 = [&](float nx, float ny, float nz) noexcept {
             return vgi::vertex{{-size, -size, size}, color, {1.0f, 1.0f}, {nx, ny, nz}};
         };
-        const auto v3 = [&](float nx, float ny, float nz) constexpr noexcept {
+        const auto v3 = [&](float nx, float ny, float nz) noexcept {
             return vgi::vertex{{size, -size, size}, color, {0.0f, 1.0f}, {nx, ny, nz}};
         };
-        const auto v4 = [&](float nx, float ny, float nz) constexpr noexcept {
+        const auto v4 = [&](float nx, float ny, float nz) noexcept {
             return vgi::vertex{{size, -size, -size}, color, {0.0f, 0.0f}, {nx, ny, nz}};
         };
-        const auto v5 = [&](float nx, float ny, float nz) constexpr noexcept {
+        const auto v5 = [&](float nx, float ny, float nz) noexcept {
             return vgi::vertex{{size, size, -size}, color, {1.0f, 0.0f}, {nx, ny, nz}};
         };
-        const auto v6 = [&](float nx, float ny, float nz) constexpr noexcept {
+        const auto v6 = [&](float nx, float ny, float nz) noexcept {
             return vgi::vertex{{-size, size, -size}, color, {0.0f, 0.0f}, {nx, ny, nz}};
         };
-        const auto v7 = [&](float nx, float ny, float nz) constexpr noexcept {
+        const auto v7 = [&](float nx, float ny, float nz) noexcept {
             return vgi::vertex{{-size, -size, -size}, color, {1.0f, 0.0f}, {nx, ny, nz}};
         };
 
-        const vgi::vertex vertices[] = {// Front face
-                                        v0(0.0f, 0.0f, 1.0f), v1(0.0f, 0.0f, 1.0f),
-                                        v2(0.0f, 0.0f, 1.0f), v3(0.0f, 0.0f, 1.0f),
-                                        // Right face
-                                        v0(1.0f, 0.0f, 0.0f), v3(1.0f, 0.0f, 0.0f),
-                                        v4(1.0f, 0.0f, 0.0f), v5(1.0f, 0.0f, 0.0f),
-                                        // Top face
-                                        v0(0.0f, 1.0f, 0.0f), v5(0.0f, 1.0f, 0.0f),
-                                        v6(0.0f, 1.0f, 0.0f), v1(0.0f, 1.0f, 0.0f),
-                                        // Left face
-                                        v1(-1.0f, 0.0f, 0.0f), v6(-1.0f, 0.0f, 0.0f),
-                                        v7(-1.0f, 0.0f, 0.0f), v2(-1.0f, 0.0f, 0.0f),
-                                        // Bottom face
-                                        v7(0.0f, -1.0f, 0.0f), v4(0.0f, -1.0f, 0.0f),
-                                        v3(0.0f, -1.0f, 0.0f), v2(0.0f, -1.0f, 0.0f),
-                                        // Back face
-                                        v4(0.0f, 0.0f, -1.0f), v7(0.0f, 0.0f, -1.0f),
-                                        v6(0.0f, 0.0f, -1.0f), v5(0.0f, 0.0f, -1.0f)};
-
-        constexpr T indices[] = {0,  1,  2,  2,  3,  0,  // v0-v1-v2-v3 (front)
-                                 4,  5,  6,  6,  7,  4,  // v0-v3-v4-v5 (right)
-                                 8,  9,  10, 10, 11, 8,  // v0-v5-v6-v1 (top)
-                                 12, 13, 14, 14, 15, 12,  // v1-v6-v7-v2 (left)
-                                 16, 17, 18, 18, 19, 16,  // v7-v4-v3-v2 (bottom)
-                                 20, 21, 22, 22, 23, 20};  // v4-v7-v6-v5 (back)
+        const vgi::vertex cube_vertices[] = {// Front face
+                                             v0(0.0f, 0.0f, 1.0f), v1(0.0f, 0.0f, 1.0f),
+                                             v2(0.0f, 0.0f, 1.0f), v3(0.0f, 0.0f, 1.0f),
+                                             // Right face
+                                             v0(1.0f, 0.0f, 0.0f), v3(1.0f, 0.0f, 0.0f),
+                                             v4(1.0f, 0.0f, 0.0f), v5(1.0f, 0.0f, 0.0f),
+                                             // Top face
+                                             v0(0.0f, 1.0f, 0.0f), v5(0.0f, 1.0f, 0.0f),
+                                             v6(0.0f, 1.0f, 0.0f), v1(0.0f, 1.0f, 0.0f),
+                                             // Left face
+                                             v1(-1.0f, 0.0f, 0.0f), v6(-1.0f, 0.0f, 0.0f),
+                                             v7(-1.0f, 0.0f, 0.0f), v2(-1.0f, 0.0f, 0.0f),
+                                             // Bottom face
+                                             v7(0.0f, -1.0f, 0.0f), v4(0.0f, -1.0f, 0.0f),
+                                             v3(0.0f, -1.0f, 0.0f), v2(0.0f, -1.0f, 0.0f),
+                                             // Back face
+                                             v4(0.0f, 0.0f, -1.0f), v7(0.0f, 0.0f, -1.0f),
+                                             v6(0.0f, 0.0f, -1.0f), v5(0.0f, 0.0f, -1.0f)};
+
+        constexpr T cube_indices[] = {0,  1,  2,  2,  3,  0,  // v0-v1-v2-v3 (front)
+                                      4,  5,  6,  6,  7,  4,  // v0-v3-v4-v5 (right)
+                                      8,  9,  10, 10, 11, 8,  // v0-v5-v6-v1 (top)
+                                      12, 13, 14, 14, 15, 12,  // v1-v6-v7-v2 (left)
+                                      16, 17, 18, 18, 19, 16,  // v7-v4-v3-v2 (bottom)
+                                      20, 21, 22, 22, 23, 20};  // v4-v7-v6-v5 (back)
+
+        vertices.assign(std::begin(cube_vertices), std::end(cube_vertices));
+        indices.assign(std::begin(cube_indices), std::end(cube_indices));
+    }
 
+    template<index T, vertex_layout V>
+    mesh<T, V> mesh<T, V>::load_cube(const window& parent, vk::CommandBuffer cmdbuf,
+                                     transfer_buffer& transfer, const glm::vec4& color,
+                                     size_t offset)
+        requires std::same_as<V, vertex_attributes>
+    {
+        std::vector<vertex> vertices;
+        std::vector<T> indices;
+        build_cube(vertices, indices, color);
         return mesh{parent, cmdbuf, transfer, vertices, indices, offset};
     }
 
@@ -203,8 +219,10 @@ namespace vgi {
         return *index_count;
     }
 
-    template<index T>
-    size_t mesh<T>::sphere_transfer_size(uint32_t slices, uint32_t stacks) {
+    template<index T, vertex_layout V>
+    size_t mesh<T, V>::sphere_transfer_size(uint32_t slices, uint32_t stacks)
+        requires std::same_as<V, vertex_attributes>
+    {
         return transfer_size(sphere_vertex_count<T>(slices, stacks),
                              sphere_index_count(slices, stacks));
     }
@@ -236,10 +254,11 @@ namespace vgi {
         return buf;
     }
 
-    template<index T>
-    mesh<T> mesh<T>::load_sphere(const window& parent, vk::CommandBuffer cmdbuf,
-                                 transfer_buffer& transfer, uint32_t slices, uint32_t stacks,
-                                 const glm::vec4& color, size_t offset) {
+    template<index T, vertex_layout V>
+    void mesh<T, V>::build_sphere(std::vector<vertex>& vertices, std::vector<T>& indices,
+                                  uint32_t slices, uint32_t stacks, const glm::vec4& color)
+        requires std::same_as<V, vertex_attributes>
+    {
         T vertex_count = sphere_vertex_count<T>(slices, stacks);
         uint32_t index_count = sphere_index_count(slices, stacks);
         std::optional<size_t> sincos2_size = math::check_add<size_t>(stacks, stacks);
@@ -255,15 +274,8 @@ namespace vgi {
             return vertex{{x, y, z}, color, {y - x, z - x}, {x, y, z}};
         };
 
-        std::optional<size_t> index_size = math::check_mul<size_t>(index_count, sizeof(T));
-        if (!index_size) throw vgi_error{"too many indices"};
-        std::optional<size_t> vertex_size = math::check_mul<size_t>(vertex_count, sizeof(vertex));
-        if (!vertex_size) throw vgi_error{"too many vertices"};
-        std::optional<size_t> start_index_offset = math::check_add<size_t>(offset, *vertex_size);
-        if (!start_index_offset) throw vgi_error{"out of memory"};
-
-        size_t vertex_offset = offset;
-        size_t index_offset = *start_index_offset;
+        vertices.reserve(vertex_count);
+        indices.reserve(index_count);
 
         float z0 = 1.0f;
         float z1 = cost2(1);
@@ -272,16 +284,12 @@ namespace vgi {
         T index = 0;
 
         index += 1;
-        vertex_offset = transfer.write_at(
-                vertex{{0.0f, 0.0f, 1.0f}, color, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}}, vertex_offset);
+        vertices.push_back(vertex{{0.0f, 0.0f, 1.0f}, color, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}});
 
         for (int64_t j = slices - 1; j >= 0; --j) {
-            index_offset = transfer.template write_at<T>({0, index, static_cast<T>(index + 1)},
-                                                         index_offset);
-            vertex_offset = transfer.template write_at<vertex>(
-                    {point_at(cost1(j + 1) * r1, sint1(j + 1) * r1, z1),
-                     point_at(cost1(j) * r1, sint1(j) * r1, z1)},
-                    vertex_offset);
+            indices.insert(indices.end(), {0, index, static_cast<T>(index + 1)});
+            vertices.insert(vertices.end(), {point_at(cost1(j + 1) * r1, sint1(j + 1) * r1, z1),
+                                             point_at(cost1(j) * r1, sint1(j) * r1, z1)});
             index += 2;
         }
 
@@ -292,18 +300,15 @@ namespace vgi {
             r1 = sint2(i + 1);
 
             for (uint32_t j = 0; j < slices; ++j) {
-                index_offset = transfer.template write_at<T>(
-                        {index, static_cast<T>(index + 1), static_cast<T>(index + 3),
-                         static_cast<T>(index + 3), static_cast<T>(index + 2), index},
-                        index_offset);
-                vertex_offset = transfer.template write_at<vertex>(
-                        {
-                                point_at(cost1(j) * r1, sint1(j) * r1, z1),
-                                point_at(cost1(j) * r0, sint1(j) * r0, z0),
-                                point_at(cost1(j + 1) * r1, sint1(j + 1) * r1, z1),
-                                point_at(cost1(j + 1) * r0, sint1(j + 1) * r0, z0),
-                        },
-                        vertex_offset);
+                indices.insert(indices.end(),
+                               {index, static_cast<T>(index + 1), static_cast<T>(index + 3),
+                                static_cast<T>(index + 3), static_cast<T>(index + 2), index});
+                vertices.insert(vertices.end(), {
+                        point_at(cost1(j) * r1, sint1(j) * r1, z1),
+                        point_at(cost1(j) * r0, sint1(j) * r0, z0),
+                        point_at(cost1(j + 1) * r1, sint1(j + 1) * r1, z1),
+                        point_at(cost1(j + 1) * r0, sint1(j + 1) * r0, z0),
+                });
                 index += 4;
             }
         }
@@ -311,31 +316,46 @@ namespace vgi {
         z0 = z1;
         r0 = r1;
 
-        vertex_offset = transfer.write_at(
-                vertex{{0.0f, 0.0f, -1.0f}, color, {0.0f, -1.0f}, {0.0f, 0.0f, -1.0f}},
-                vertex_offset);
+        vertices.push_back(vertex{{0.0f, 0.0f, -1.0f}, color, {0.0f, -1.0f}, {0.0f, 0.0f, -1.0f}});
 
         const T sub_index = index;
         index += 1;
 
         for (uint32_t j = 0; j < slices; ++j) {
-            index_offset = transfer.template write_at<T>(
-                    {sub_index, index, static_cast<T>(index + 1)}, index_offset);
-            vertex_offset = transfer.template write_at<vertex>(
-                    {point_at(cost1(j) * r0, sint1(j) * r0, z0),
-                     point_at(cost1(j + 1) * r0, sint1(j + 1) * r0, z0)},
-                    vertex_offset);
+            indices.insert(indices.end(), {sub_index, index, static_cast<T>(index + 1)});
+            vertices.insert(vertices.end(), {point_at(cost1(j) * r0, sint1(j) * r0, z0),
+                                             point_at(cost1(j + 1) * r0, sint1(j + 1) * r0, z0)});
             index += 2;
         }
+    }
 
-        mesh result{parent, vertex_count, index_count};
-        cmdbuf.copyBuffer(transfer, result.vertices, vk::BufferCopy{offset, 0, *vertex_size});
-        cmdbuf.copyBuffer(transfer, result.indices,
-                          vk::BufferCopy{*start_index_offset, 0, *index_size});
-
-        return result;
+    template<index T, vertex_layout V>
+    mesh<T, V> mesh<T, V>::load_sphere(const window& parent, vk::CommandBuffer cmdbuf,
+                                       transfer_buffer& transfer, uint32_t slices, uint32_t stacks,
+                                       const glm::vec4& color, size_t offset)
+        requires std::same_as<V, vertex_attributes>
+    {
+        std::vector<vertex> vertices;
+        std::vector<T> indices;
+        build_sphere(vertices, indices, slices, stacks, color);
+        return mesh{parent, cmdbuf, transfer, vertices, indices, offset};
     }
 
+    template void mesh<uint16_t>::build_plane(std::vector<vertex>&, std::vector<uint16_t>&,
+                                              uint32_t, uint32_t, const glm::vec4&);
+    template void mesh<uint32_t>::build_plane(std::vector<vertex>&, std::vector<uint32_t>&,
+                                              uint32_t, uint32_t, const glm::vec4&);
+
+    template void mesh<uint16_t>::build_cube(std::vector<vertex>&, std::vector<uint16_t>&,
+                                             const glm::vec4&);
+    template void mesh<uint32_t>::build_cube(std::vector<vertex>&, std::vector<uint32_t>&,
+                                             const glm::vec4&);
+
+    template void mesh<uint16_t>::build_sphere(std::vector<vertex>&, std::vector<uint16_t>&,
+                                               uint32_t, uint32_t, const glm::vec4&);
+    template void mesh<uint32_t>::build_sphere(std::vector<vertex>&, std::vector<uint32_t>&,
+                                               uint32_t, uint32_t, const glm::vec4&);
+
     template size_t mesh<uint16_t>::plane_transfer_size(uint32_t, uint32_t);
     template size_t mesh<uint32_t>::plane_transfer_size(uint32_t, uint32_t);
 
@@ -360,4 +380,23 @@ namespace vgi {
     template mesh<uint32_t> mesh<uint32_t>::load_sphere(const window&, vk::CommandBuffer,
                                                         transfer_buffer&, uint32_t, uint32_t,
                                                         const glm::vec4&, size_t);
+
+    any_mesh upload_mesh(window& parent, std::span<const vertex> vertices,
+                         std::span<const uint32_t> indices,
+                         const mesh_optimization& optimization) {
+        std::vector<vertex> optimized_vertices(vertices.begin(), vertices.end());
+        std::vector<uint32_t> optimized_indices(indices.begin(), indices.end());
+        if (optimization.enabled()) {
+            optimize_mesh(optimized_vertices, optimized_indices, optimization);
+        }
+
+        if (optimized_vertices.size() <= size_t{UINT16_MAX} + 1) {
+            const std::vector<uint16_t> narrowed_indices(optimized_indices.begin(),
+                                                         optimized_indices.end());
+            return mesh<uint16_t>::upload(parent, optimized_vertices, narrowed_indices,
+                                          mesh_optimization::none());
+        }
+        return mesh<uint32_t>::upload(parent, optimized_vertices, optimized_indices,
+                                      mesh_optimization::none());
+    }
 }  // namespace vgi
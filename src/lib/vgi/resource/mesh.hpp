@@ -1,21 +1,34 @@
 #pragma once
 
+#include <concepts>
 #include <ranges>
+#include <variant>
+#include <vector>
 #include <vgi/buffer/index.hpp>
+#include <vgi/buffer/staging.hpp>
 #include <vgi/buffer/transfer.hpp>
 #include <vgi/buffer/vertex.hpp>
 #include <vgi/cmdbuf.hpp>
 #include <vgi/math.hpp>
 #include <vgi/pipeline.hpp>
 #include <vgi/resource.hpp>
+#include <vgi/resource/optimize.hpp>
 #include <vgi/window.hpp>
 
 namespace vgi {
     /// @brief A vertex array-based geometry
-    template<index T>
+    /// @details Vertices are split into two streams, their positions and the remaining attributes,
+    /// so that passes which only need positions (i.e. depth pre-passes or shadows) may bind the
+    /// position stream alone.
+    /// @tparam T Type of the indices
+    /// @tparam V Layout of the attribute stream. The shapes loaded by the `load_*` methods are
+    /// only available for `vgi::vertex_attributes`.
+    template<index T, vertex_layout V = vertex_attributes>
     struct mesh {
-        /// @brief Buffer containint the mesh vertices
-        vertex_buffer vertices;
+        /// @brief Buffer containing the positions of the mesh vertices
+        basic_vertex_buffer<vertex_position> positions;
+        /// @brief Buffer containing the remaining attributes of the mesh vertices
+        basic_vertex_buffer<V> attributes;
         /// @brief Buffer containing the mesh indices
         index_buffer<T> indices;
         /// @brief Number of indices inside `indices`
@@ -29,29 +42,64 @@ namespace vgi {
         /// @param vertex_count Number of vertices that will fit inside the mesh
         /// @param index_count Number of indices that will fit inside the mesh
         mesh(const window& parent, vk::DeviceSize vertex_count, uint32_t index_count) :
-            vertices(parent, vertex_count), indices(parent, index_count), index_count(index_count) {
-        }
+            positions(parent, vertex_count), attributes(parent, vertex_count),
+            indices(parent, index_count), index_count(index_count) {}
 
         /// @brief Creates a new mesh and sets up the command and transfer buffers for the upload
         /// @param parent Window that will create the mesh
         /// @param cmdbuf Command buffer used to register commands
         /// @param transfer Transfer buffer used to move the data from host to device memory
+        /// @param positions The position stream to be uploaded
+        /// @param attributes The attribute stream to be uploaded. Must be as long as `positions`.
+        /// @param indices The index data to be uploaded
+        /// @param offset The offset from which the data will be written to the transfer buffer
+        mesh(const window& parent, vk::CommandBuffer cmdbuf, transfer_buffer& transfer,
+             std::span<const vertex_position> positions, std::span<const V> attributes,
+             std::span<const T> indices, size_t offset = 0) :
+            mesh(parent, positions.size(), math::check_cast<uint32_t>(indices.size()).value()) {
+            VGI_ASSERT(positions.size() == attributes.size());
+            offset = transfer.template write_at<vertex_position>(cmdbuf, positions, offset,
+                                                                 this->positions, 0);
+            offset = transfer.template write_at<V>(cmdbuf, attributes, offset, this->attributes, 0);
+            transfer.template write_at<T>(cmdbuf, indices, offset, this->indices, 0);
+        }
+
+        /// @brief Creates a new mesh, splitting the vertices into their streams, and sets up the
+        /// command and transfer buffers for the upload
+        /// @param parent Window that will create the mesh
+        /// @param cmdbuf Command buffer used to register commands
+        /// @param transfer Transfer buffer used to move the data from host to device memory
         /// @param vertices The vertex data to be uploaded
         /// @param indices The index data to be uploaded
         /// @param offset The offset from which the data will be written to the transfer buffer
         mesh(const window& parent, vk::CommandBuffer cmdbuf, transfer_buffer& transfer,
-             std::span<const vertex> vertices, std::span<const T> indices, size_t offset = 0) :
-            mesh(parent, vertices.size(), math::check_cast<uint32_t>(indices.size()).value()) {
-            offset =
-                    transfer.template write_at<vertex>(cmdbuf, vertices, offset, this->vertices, 0);
+             std::span<const vertex> vertices, std::span<const T> indices, size_t offset = 0)
+            requires std::same_as<V, vertex_attributes>
+            : mesh(parent, vertices.size(), math::check_cast<uint32_t>(indices.size()).value()) {
+            const size_t positions_offset = offset;
+            for (const vertex& value: vertices) {
+                offset = transfer.write_at(value.position, offset);
+            }
+            const size_t attributes_offset = offset;
+            for (const vertex& value: vertices) {
+                offset = transfer.write_at(value.attributes, offset);
+            }
+
+            const vk::DeviceSize base = transfer.buffer_offset();
+            cmdbuf.copyBuffer(transfer, this->positions,
+                              vk::BufferCopy{base + positions_offset, 0,
+                                             attributes_offset - positions_offset});
+            cmdbuf.copyBuffer(
+                    transfer, this->attributes,
+                    vk::BufferCopy{base + attributes_offset, 0, offset - attributes_offset});
             transfer.template write_at<T>(cmdbuf, indices, offset, this->indices, 0);
         }
 
         /// @brief Move constructor
         /// @param other Object to move
         mesh(mesh&& other) noexcept :
-            vertices(std::move(other.vertices)), indices(std::move(other.indices)),
-            index_count(std::exchange(other.index_count, 0)) {}
+            positions(std::move(other.positions)), attributes(std::move(other.attributes)),
+            indices(std::move(other.indices)), index_count(std::exchange(other.index_count, 0)) {}
 
         /// @brief Move assignment
         /// @param other Object to move
@@ -62,12 +110,17 @@ namespace vgi {
             return *this;
         }
 
-        /// @brief Binds both the vertex and index buffers
+        /// @brief Binds the vertex and index buffers
         /// @param cmdbuf Command buffer into which the command is recorded.
-        /// @param vertex_binding Index of the vertex input binding whose state is updated by the
-        /// command
-        void bind(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0) const noexcept {
-            this->vertices.bind(cmdbuf, vertex_binding);
+        /// @param vertex_binding Index of the vertex input binding of the position stream. The
+        /// attribute stream is bound to the next one.
+        /// @param streams Vertex streams to bind
+        void bind(vk::CommandBuffer cmdbuf, uint32_t vertex_binding = 0,
+                  vertex_streams streams = vertex_streams::all) const noexcept {
+            const vk::Buffer buffers[] = {this->positions, this->attributes};
+            constexpr vk::DeviceSize offsets[] = {0, 0};
+            cmdbuf.bindVertexBuffers(vertex_binding, streams == vertex_streams::all ? 2 : 1,
+                                     buffers, offsets);
             this->indices.bind(cmdbuf);
         }
 
@@ -85,15 +138,17 @@ namespace vgi {
         /// @sa vgi::mesh::bind
         /// @sa vgi::mesh::draw
         void bind_and_draw(vk::CommandBuffer cmdbuf, uint32_t instance_count = 1,
-                           uint32_t vertex_binding = 0) const noexcept {
-            this->bind(cmdbuf, vertex_binding);
+                           uint32_t vertex_binding = 0,
+                           vertex_streams streams = vertex_streams::all) const noexcept {
+            this->bind(cmdbuf, vertex_binding, streams);
             this->draw(cmdbuf, instance_count);
         }
 
         /// @brief Destroys the resource
         /// @param parent Window that created the resource
         void destroy(const window& parent) && {
-            std::move(this->vertices).destroy(parent);
+            std::move(this->positions).destroy(parent);
+            std::move(this->attributes).destroy(parent);
             std::move(this->indices).destroy(parent);
         }
 
@@ -120,7 +175,8 @@ namespace vgi {
         static inline size_t transfer_size(size_t vertex_count, uint32_t index_count)
             requires(!std::is_same_v<size_t, uint32_t>)
         {
-            auto vertex_size = math::check_mul<size_t>(vertex_count, sizeof(vertex));
+            auto vertex_size =
+                    math::check_mul<size_t>(vertex_count, sizeof(vertex_position) + sizeof(V));
             if (!vertex_size) throw vgi_error{"too many vertices"};
             auto index_size = math::check_mul<size_t>(index_count, sizeof(T));
             if (!index_size) throw vgi_error{"too many indices"};
@@ -129,6 +185,25 @@ namespace vgi {
             return *total_size;
         }
 
+        /// @brief Creates a new mesh, creates a transfer buffer with the required size and sets up
+        /// the command for the upload
+        /// @param parent Window that will create the mesh
+        /// @param cmdbuf Command buffer used to register commands
+        /// @param positions The position stream to be uploaded
+        /// @param attributes The attribute stream to be uploaded. Must be as long as `positions`.
+        /// @param indices The index data to be uploaded
+        /// @param min_size The minimum size of the transfer buffer
+        static inline std::pair<mesh, transfer_buffer_guard> upload(
+                const window& parent, vk::CommandBuffer cmdbuf,
+                std::span<const vertex_position> positions, std::span<const V> attributes,
+                std::span<const T> indices, size_t min_size = 0) {
+            vgi::transfer_buffer_guard transfer{
+                    parent, (std::max)(transfer_size(positions.size(), indices.size()), min_size)};
+            mesh result{parent, cmdbuf, transfer, positions, attributes, indices};
+            return std::make_pair<mesh, transfer_buffer_guard>(std::move(result),
+                                                               std::move(transfer));
+        }
+
         /// @brief Creates a new mesh, creates a transfer buffer with the required size and sets up
         /// the command for the upload
         /// @param parent Window that will create the mesh
@@ -138,7 +213,9 @@ namespace vgi {
         /// @param min_size The minimum size of the transfer buffer
         static inline std::pair<mesh, transfer_buffer_guard> upload(
                 const window& parent, vk::CommandBuffer cmdbuf, std::span<const vertex> vertices,
-                std::span<const T> indices, size_t min_size = 0) {
+                std::span<const T> indices, size_t min_size = 0)
+            requires std::same_as<V, vertex_attributes>
+        {
             vgi::transfer_buffer_guard transfer{
                     parent, (std::max)(transfer_size(vertices.size(), indices.size()), min_size)};
             mesh result{parent, cmdbuf, transfer, vertices, indices};
@@ -146,33 +223,119 @@ namespace vgi {
                                                                std::move(transfer));
         }
 
+        /// @brief Creates a mesh and streams the data to the device through the window's staging
+        /// ring, without waiting for the upload to complete.
+        /// @details The upload is submitted alongside the next frame (or whenever the staging ring
+        /// is submitted), so uploading many meshes this way results in a single queue submission.
+        /// @param parent Window that will create the mesh
+        /// @param positions The position stream to be uploaded
+        /// @param attributes The attribute stream to be uploaded. Must be as long as `positions`.
+        /// @param indices The index data to be uploaded
+        static inline mesh upload(window& parent, std::span<const vertex_position> positions,
+                                  std::span<const V> attributes, std::span<const T> indices) {
+            VGI_ASSERT(positions.size() == attributes.size());
+            staging_ring& staging = parent.staging();
+            mesh result{parent, positions.size(),
+                        math::check_cast<uint32_t>(indices.size()).value()};
+            staging.upload(parent, positions, result.positions, result.positions);
+            staging.upload(parent, attributes, result.attributes, result.attributes);
+            staging.upload(parent, indices, result.indices, result.indices);
+            return result;
+        }
+
+        /// @brief Creates a mesh, splitting the vertices into their streams, and streams the data
+        /// to the device through the window's staging ring, without waiting for the upload to
+        /// complete.
+        /// @param parent Window that will create the mesh
+        /// @param vertices The vertex data to be uploaded
+        /// @param indices The index data to be uploaded. Must be a triangle list, unless
+        /// `optimization` is `mesh_optimization::none()`.
+        /// @param optimization Optimization stages applied to a copy of the data before uploading
+        /// it. Triangle lists may opt in with `mesh_optimization{}`.
+        /// @sa vgi::mesh::upload
+        /// @sa vgi::upload_mesh
+        static inline mesh upload(window& parent, std::span<const vertex> vertices,
+                                  std::span<const T> indices,
+                                  const mesh_optimization& optimization = mesh_optimization::none())
+            requires std::same_as<V, vertex_attributes>
+        {
+            if (optimization.enabled()) {
+                std::vector<vertex> optimized_vertices(vertices.begin(), vertices.end());
+                std::vector<uint32_t> optimized_indices(indices.begin(), indices.end());
+                optimize_mesh(optimized_vertices, optimized_indices, optimization);
+                // Welding never adds vertices, so the indices still fit in `T`
+                const std::vector<T> narrowed_indices(optimized_indices.begin(),
+                                                      optimized_indices.end());
+                return upload(parent, optimized_vertices, narrowed_indices,
+                              mesh_optimization::none());
+            }
+
+            staging_ring& staging = parent.staging();
+            mesh result{parent, vertices.size(),
+                        math::check_cast<uint32_t>(indices.size()).value()};
+
+            // Vertices are staged in chunks that fit within half of the ring, like the ones of
+            // `staging_ring::upload`. Each staged region must be written before the next one is
+            // staged.
+            const size_t chunk_size = (std::max<size_t>) (
+                    static_cast<size_t>(staging.capacity() / 2) / sizeof(vertex_attributes), 1);
+            for (size_t first = 0; first < vertices.size(); first += chunk_size) {
+                const std::span<const vertex> chunk =
+                        vertices.subspan(first, (std::min)(chunk_size, vertices.size() - first));
+                vertex::copy_positions(
+                        chunk, staging.stage(parent, chunk.size() * sizeof(vertex_position),
+                                             result.positions, result.positions,
+                                             first * sizeof(vertex_position))
+                                       .data());
+                vertex::copy_attributes(
+                        chunk, staging.stage(parent, chunk.size() * sizeof(vertex_attributes),
+                                             result.attributes, result.attributes,
+                                             first * sizeof(vertex_attributes))
+                                       .data());
+            }
+
+            staging.upload(parent, indices, result.indices, result.indices);
+            return result;
+        }
+
         /// @brief Creates a mesh and uploads the data to the device, waiting for the upload to
         /// complete.
         /// @param parent Window that will create the mesh
         /// @param vertices The vertex data to be uploaded
-        /// @param indices The index data to be uploaded
+        /// @param indices The index data to be uploaded. Must be a triangle list, unless
+        /// `optimization` is `mesh_optimization::none()`.
+        /// @param optimization Optimization stages applied to a copy of the data before uploading
+        /// it. Triangle lists may opt in with `mesh_optimization{}`.
         /// @warning If possible, avoid using this method and instead upload multiple meshes
         /// simultaneously.
-        static inline mesh upload_and_wait(window& parent, std::span<const vertex> vertices,
-                                           std::span<const T> indices) {
-            command_buffer cmdbuf{parent};
-            auto [mesh, transfer] = upload(parent, cmdbuf, vertices, indices);
-            std::move(cmdbuf).submit_and_wait();
-            return std::move(mesh);
+        static inline mesh upload_and_wait(
+                window& parent, std::span<const vertex> vertices, std::span<const T> indices,
+                const mesh_optimization& optimization = mesh_optimization::none())
+            requires std::same_as<V, vertex_attributes>
+        {
+            mesh result = upload(parent, vertices, indices, optimization);
+            parent.staging().wait(parent);
+            return result;
         }
 
         /// @brief Computes the size required for a transfer buffer to hold a plane's mesh data
         /// @param points_x Number of points per column (minumum 2)
         /// @param points_y Number of points per row (minumum 2)
-        static size_t plane_transfer_size(uint32_t points_x, uint32_t points_y);
+        static size_t plane_transfer_size(uint32_t points_x, uint32_t points_y)
+            requires std::same_as<V, vertex_attributes>;
 
         /// @brief Computes the size required for a transfer buffer to hold a cube's mesh data
-        static size_t cube_transfer_size() { return 24 * sizeof(vertex) + 36 * sizeof(T); }
+        static size_t cube_transfer_size()
+            requires std::same_as<V, vertex_attributes>
+        {
+            return 24 * (sizeof(vertex_position) + sizeof(V)) + 36 * sizeof(T);
+        }
 
         /// @brief Computes the size required for a transfer buffer to hold a sphere's mesh data
         /// @param slices Number of slices that form the sphere
         /// @param stacks Number of stacks that form the sphere
-        static size_t sphere_transfer_size(uint32_t slices, uint32_t stacks);
+        static size_t sphere_transfer_size(uint32_t slices, uint32_t stacks)
+            requires std::same_as<V, vertex_attributes>;
 
         /// @brief Loads a plane as a mesh
         /// @param parent Window that will create the mesh
@@ -184,7 +347,8 @@ namespace vgi {
         /// @param offset The offset from which the data will be written to the transfer buffer
         static mesh load_plane(const window& parent, vk::CommandBuffer cmdbuf,
                                transfer_buffer& transfer, uint32_t points_x, uint32_t points_y,
-                               const glm::vec4& color = glm::vec4{1.0f}, size_t offset = 0);
+                               const glm::vec4& color = glm::vec4{1.0f}, size_t offset = 0)
+            requires std::same_as<V, vertex_attributes>;
 
         /// @brief Loads a solid cube as a mesh
         /// @param parent Window that will create the mesh
@@ -196,7 +360,8 @@ namespace vgi {
         /// @author Enric Marti <enric.marti@uab.cat>
         static mesh load_cube(const window& parent, vk::CommandBuffer cmdbuf,
                               transfer_buffer& transfer, const glm::vec4& color = glm::vec4{1.0f},
-                              size_t offset = 0);
+                              size_t offset = 0)
+            requires std::same_as<V, vertex_attributes>;
 
         /// @brief Loads a solid sphere as a mesh
         /// @param parent Window that will create the mesh
@@ -208,7 +373,8 @@ namespace vgi {
         /// @param offset The offset from which the data will be written to the transfer buffer
         static mesh load_sphere(const window& parent, vk::CommandBuffer cmdbuf,
                                 transfer_buffer& transfer, uint32_t slices, uint32_t stacks,
-                                const glm::vec4& color = glm::vec4{1.0f}, size_t offset = 0);
+                                const glm::vec4& color = glm::vec4{1.0f}, size_t offset = 0)
+            requires std::same_as<V, vertex_attributes>;
 
         /// @brief Loads a solid cube as a mesh
         /// @param parent Window that will create the mesh
@@ -219,7 +385,9 @@ namespace vgi {
         /// @param min_size The minimum size of the transfer buffer
         static std::pair<mesh, transfer_buffer_guard> load_plane(
                 const window& parent, vk::CommandBuffer cmdbuf, uint32_t points_x,
-                uint32_t points_y, const glm::vec4& color = glm::vec4{1.0f}, size_t min_size = 0) {
+                uint32_t points_y, const glm::vec4& color = glm::vec4{1.0f}, size_t min_size = 0)
+            requires std::same_as<V, vertex_attributes>
+        {
             vgi::transfer_buffer_guard transfer{
                     parent, (std::max)(plane_transfer_size(points_x, points_y), min_size)};
             mesh result = load_plane(parent, cmdbuf, transfer, points_x, points_y, color);
@@ -236,7 +404,9 @@ namespace vgi {
         /// @author Enric Marti <enric.marti@uab.cat>
         static std::pair<mesh, transfer_buffer_guard> load_cube(
                 const window& parent, vk::CommandBuffer cmdbuf,
-                const glm::vec4& color = glm::vec4{1.0f}, size_t min_size = 0) {
+                const glm::vec4& color = glm::vec4{1.0f}, size_t min_size = 0)
+            requires std::same_as<V, vertex_attributes>
+        {
             vgi::transfer_buffer_guard transfer{parent, (std::max)(cube_transfer_size(), min_size)};
             mesh result = load_cube(parent, cmdbuf, transfer, color);
             return std::make_pair<mesh, transfer_buffer_guard>(std::move(result),
@@ -252,7 +422,9 @@ namespace vgi {
         /// @param min_size The minimum size of the transfer buffer
         static std::pair<mesh, transfer_buffer_guard> load_sphere(
                 const window& parent, vk::CommandBuffer cmdbuf, uint32_t slices, uint32_t stacks,
-                const glm::vec4& color = glm::vec4{1.0f}, size_t min_size = 0) {
+                const glm::vec4& color = glm::vec4{1.0f}, size_t min_size = 0)
+            requires std::same_as<V, vertex_attributes>
+        {
             vgi::transfer_buffer_guard transfer{
                     parent, (std::max)(sphere_transfer_size(slices, stacks), min_size)};
             mesh result = load_sphere(parent, cmdbuf, transfer, slices, stacks, color);
@@ -268,11 +440,13 @@ namespace vgi {
         /// @warning If possible, avoid using this method and instead upload multiple meshes
         /// simultaneously.
         static mesh load_plane_and_wait(window& parent, uint32_t points_x, uint32_t points_y,
-                                        const glm::vec4& color = glm::vec4{1.0f}) {
-            command_buffer cmdbuf{parent};
-            auto [mesh, transfer] = load_plane(parent, cmdbuf, points_x, points_y, color);
-            std::move(cmdbuf).submit_and_wait();
-            return std::move(mesh);
+                                        const glm::vec4& color = glm::vec4{1.0f})
+            requires std::same_as<V, vertex_attributes>
+        {
+            std::vector<vertex> vertices;
+            std::vector<T> indices;
+            build_plane(vertices, indices, points_x, points_y, color);
+            return upload_and_wait(parent, vertices, indices);
         }
 
         /// @brief Loads a solid cube as a mesh
@@ -282,11 +456,13 @@ namespace vgi {
         /// simultaneously.
         /// @author Andreas Umbach <marvin@dataway.ch>
         /// @author Enric Marti <enric.marti@uab.cat>
-        static mesh load_cube_and_wait(window& parent, const glm::vec4& color = glm::vec4{1.0f}) {
-            command_buffer cmdbuf{parent};
-            auto [mesh, transfer] = load_cube(parent, cmdbuf, color);
-            std::move(cmdbuf).submit_and_wait();
-            return std::move(mesh);
+        static mesh load_cube_and_wait(window& parent, const glm::vec4& color = glm::vec4{1.0f})
+            requires std::same_as<V, vertex_attributes>
+        {
+            std::vector<vertex> vertices;
+            std::vector<T> indices;
+            build_cube(vertices, indices, color);
+            return upload_and_wait(parent, vertices, indices);
         }
 
         /// @brief Loads a solid cube as a mesh
@@ -297,14 +473,46 @@ namespace vgi {
         /// @warning If possible, avoid using this method and instead upload multiple meshes
         /// simultaneously.
         static mesh load_sphere_and_wait(window& parent, uint32_t slices, uint32_t stacks,
-                                         const glm::vec4& color = glm::vec4{1.0f}) {
-            command_buffer cmdbuf{parent};
-            auto [mesh, transfer] = load_sphere(parent, cmdbuf, slices, stacks, color);
-            std::move(cmdbuf).submit_and_wait();
-            return std::move(mesh);
+                                         const glm::vec4& color = glm::vec4{1.0f})
+            requires std::same_as<V, vertex_attributes>
+        {
+            std::vector<vertex> vertices;
+            std::vector<T> indices;
+            build_sphere(vertices, indices, slices, stacks, color);
+            return upload_and_wait(parent, vertices, indices);
         }
 
         mesh(const mesh&) = delete;
         mesh& operator=(const mesh&) = delete;
+
+    private:
+        // Generate the vertices and indices of the built-in shapes on the host
+        static void build_plane(std::vector<vertex>& vertices, std::vector<T>& indices,
+                                uint32_t points_x, uint32_t points_y, const glm::vec4& color)
+            requires std::same_as<V, vertex_attributes>;
+        static void build_cube(std::vector<vertex>& vertices, std::vector<T>& indices,
+                               const glm::vec4& color)
+            requires std::same_as<V, vertex_attributes>;
+        static void build_sphere(std::vector<vertex>& vertices, std::vector<T>& indices,
+                                 uint32_t slices, uint32_t stacks, const glm::vec4& color)
+            requires std::same_as<V, vertex_attributes>;
     };
+
+    /// @brief A mesh whose index type is chosen when it's uploaded
+    using any_mesh = std::variant<mesh<uint16_t>, mesh<uint32_t>>;
+
+    /// @brief Uploads a mesh through the window's staging ring, with the narrowest index type
+    /// that fits its vertices.
+    /// @details Meshes with up to 65536 vertices (once welded) use 16-bit indices, halving the
+    /// size of their index buffer.
+    /// @param parent Window that will create the mesh
+    /// @param vertices The vertex data to be uploaded
+    /// @param indices The index data to be uploaded. Must be a triangle list, unless
+    /// `optimization` is `mesh_optimization::none()`.
+    /// @param optimization Optimization stages applied to a copy of the data before uploading it.
+    /// Triangle lists may opt in with `mesh_optimization{}`.
+    /// @sa vgi::mesh::upload
+    any_mesh upload_mesh(window& parent, std::span<const vertex> vertices,
+                         std::span<const uint32_t> indices,
+                         const mesh_optimization& optimization = mesh_optimization::none());
 }  // namespace vgi
@@ -0,0 +1,40 @@
+/*! \file */
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace vgi {
+    /// @brief Maximum number of vertices referenced by a meshlet
+    constexpr static inline const uint32_t MAX_MESHLET_VERTICES = 64;
+    /// @brief Maximum number of triangles of a meshlet
+    constexpr static inline const uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+    /// @brief A cluster of neighbouring triangles, which is culled as a whole
+    /// @details Meshlets match the `Meshlet` structure of the `meshlet_cull.comp` shader (with
+    /// std430 layout). Their triangles are contiguous within the index buffer of their mesh, so
+    /// every visible meshlet is drawn with a single indexed draw.
+    /// @sa vgi::build_meshlets
+    /// @sa vgi::meshlet_culler
+    struct meshlet {
+        /// @brief Center of the meshlet's bounding sphere, in model space
+        glm::vec3 center;
+        /// @brief Radius of the meshlet's bounding sphere
+        float radius;
+        /// @brief Apex of the meshlet's normal cone, in model space
+        glm::vec3 cone_apex;
+        /// @brief The meshlet is facing away from any viewer for which the dot product between
+        /// the view direction (from the viewer to the apex) and the cone axis is at least this
+        float cone_cutoff;
+        /// @brief Axis of the meshlet's normal cone
+        glm::vec3 cone_axis;
+        /// @brief Index of the meshlet's first index, relative to the first index of its mesh
+        uint32_t first_index;
+        /// @brief Number of indices of the meshlet
+        uint32_t index_count;
+        //! @cond Doxygen_Suppress
+        uint32_t padding[3]{};
+        //! @endcond
+    };
+    static_assert(sizeof(meshlet) == 64, "meshlets must match their std430 layout");
+}  // namespace vgi
@@ -0,0 +1,213 @@
+#include "optimize.hpp"
+
+#include <meshoptimizer.h>
+#include <type_traits>
+#include <utility>
+#include <vgi/vgi.hpp>
+
+namespace vgi {
+    static_assert(std::is_same_v<uint32_t, unsigned int>,
+                  "meshoptimizer expects 32-bit indices to be unsigned ints");
+
+    // Normal cones are only used for culling, so the meshlets may be slightly less compact in
+    // exchange for tighter cones
+    constexpr static inline const float MESHLET_CONE_WEIGHT = 0.25f;
+
+    // Attributes weighed by the simplifier (normal, then texture coordinates), with errors of
+    // the same magnitude as the positions' ones
+    constexpr static inline const size_t LOD_ATTRIBUTE_COUNT = 5;
+    constexpr static inline const float LOD_ATTRIBUTE_WEIGHTS[LOD_ATTRIBUTE_COUNT] = {
+            0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
+    };
+
+    static std::vector<glm::vec3> unpack_origins(std::span<const vertex> vertices) {
+        std::vector<glm::vec3> origins;
+        origins.reserve(vertices.size());
+        for (const vertex& value: vertices) {
+            origins.push_back(vertex::unpack_origin(value.position.origin));
+        }
+        return origins;
+    }
+
+    static std::vector<float> unpack_lod_attributes(std::span<const vertex> vertices) {
+        std::vector<float> attributes;
+        attributes.reserve(vertices.size() * LOD_ATTRIBUTE_COUNT);
+        for (const vertex& value: vertices) {
+            const glm::vec3 normal = vertex::unpack_normal(value.attributes.normal);
+            attributes.insert(attributes.end(), {normal.x, normal.y, normal.z,
+                                                 value.attributes.tex.x, value.attributes.tex.y});
+        }
+        return attributes;
+    }
+
+    // Locks the vertices of every triangle whose vertices are mostly influenced by different
+    // joints, so that collapses never blend the skinning of two bones
+    static std::vector<unsigned char> lock_joint_seams(std::span<const vertex> vertices,
+                                                       std::span<const uint32_t> indices) {
+        std::vector<uint8_t> dominant(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const vertex_attributes& value = vertices[i].attributes;
+            glm::length_t strongest = 0;
+            for (glm::length_t j = 1; j < 4; ++j) {
+                if (value.weights[j] > value.weights[strongest]) strongest = j;
+            }
+            dominant[i] = value.joints[strongest];
+        }
+
+        std::vector<unsigned char> locked(vertices.size(), 0);
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            const uint8_t a = dominant[indices[i]];
+            const uint8_t b = dominant[indices[i + 1]];
+            const uint8_t c = dominant[indices[i + 2]];
+            if (a == b && b == c) continue;
+            locked[indices[i]] = locked[indices[i + 1]] = locked[indices[i + 2]] = 1;
+        }
+        return locked;
+    }
+
+    void optimize_mesh(std::vector<vertex>& vertices, std::vector<uint32_t>& indices,
+                       const mesh_optimization& options) {
+        if (indices.size() % 3 != 0) throw vgi_error{"mesh is not a triangle list"};
+        if (vertices.empty() || indices.empty() || !options.enabled()) return;
+
+        // Quantized vertices have no padding, so comparing their bytes welds exact duplicates
+        if (options.weld) {
+            std::vector<uint32_t> remap(vertices.size());
+            const size_t vertex_count = meshopt_generateVertexRemap(
+                    remap.data(), indices.data(), indices.size(), vertices.data(), vertices.size(),
+                    sizeof(vertex));
+            meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+            meshopt_remapVertexBuffer(vertices.data(), vertices.data(), vertices.size(),
+                                      sizeof(vertex), remap.data());
+            vertices.resize(vertex_count);
+            vertices.shrink_to_fit();
+        }
+
+        if (options.vertex_cache) {
+            meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(),
+                                        vertices.size());
+        }
+
+        // Overdraw is estimated from the triangles' positions, so they are unpacked first
+        if (options.overdraw_threshold >= 1.0f) {
+            const std::vector<glm::vec3> origins = unpack_origins(vertices);
+            meshopt_optimizeOverdraw(indices.data(), indices.data(), indices.size(),
+                                     &origins.data()->x, origins.size(), sizeof(glm::vec3),
+                                     options.overdraw_threshold);
+        }
+
+        if (options.vertex_fetch) {
+            std::vector<vertex> fetched(vertices.size());
+            const size_t vertex_count =
+                    meshopt_optimizeVertexFetch(fetched.data(), indices.data(), indices.size(),
+                                                vertices.data(), vertices.size(), sizeof(vertex));
+            fetched.resize(vertex_count);
+            vertices = std::move(fetched);
+        }
+    }
+
+    std::vector<meshlet> build_meshlets(std::span<const vertex> vertices,
+                                        std::vector<uint32_t>& indices) {
+        if (indices.size() % 3 != 0) throw vgi_error{"mesh is not a triangle list"};
+        if (vertices.empty() || indices.empty()) return {};
+
+        const std::vector<glm::vec3> origins = unpack_origins(vertices);
+        const size_t max_clusters = meshopt_buildMeshletsBound(
+                indices.size(), MAX_MESHLET_VERTICES, MAX_MESHLET_TRIANGLES);
+        std::vector<meshopt_Meshlet> clusters(max_clusters);
+        std::vector<uint32_t> cluster_vertices(max_clusters * MAX_MESHLET_VERTICES);
+        std::vector<uint8_t> cluster_triangles(max_clusters * MAX_MESHLET_TRIANGLES * 3);
+        clusters.resize(meshopt_buildMeshlets(
+                clusters.data(), cluster_vertices.data(), cluster_triangles.data(), indices.data(),
+                indices.size(), &origins.data()->x, origins.size(), sizeof(glm::vec3),
+                MAX_MESHLET_VERTICES, MAX_MESHLET_TRIANGLES, MESHLET_CONE_WEIGHT));
+
+        std::vector<meshlet> result;
+        result.reserve(clusters.size());
+        uint32_t first_index = 0;
+        for (const meshopt_Meshlet& cluster: clusters) {
+            const uint32_t* local_vertices = cluster_vertices.data() + cluster.vertex_offset;
+            const uint8_t* local_triangles = cluster_triangles.data() + cluster.triangle_offset;
+            const meshopt_Bounds bounds = meshopt_computeMeshletBounds(
+                    local_vertices, local_triangles, cluster.triangle_count, &origins.data()->x,
+                    origins.size(), sizeof(glm::vec3));
+
+            // Meshlets are drawn straight from the mesh's vertices, so their triangles are
+            // written back with the mesh's indices
+            const uint32_t index_count = cluster.triangle_count * 3;
+            for (uint32_t i = 0; i < index_count; ++i) {
+                indices[first_index + i] = local_vertices[local_triangles[i]];
+            }
+
+            result.push_back(meshlet{
+                    .center = glm::vec3{bounds.center[0], bounds.center[1], bounds.center[2]},
+                    .radius = bounds.radius,
+                    .cone_apex = glm::vec3{bounds.cone_apex[0], bounds.cone_apex[1],
+                                           bounds.cone_apex[2]},
+                    .cone_cutoff = bounds.cone_cutoff,
+                    .cone_axis = glm::vec3{bounds.cone_axis[0], bounds.cone_axis[1],
+                                           bounds.cone_axis[2]},
+                    .first_index = first_index,
+                    .index_count = index_count,
+            });
+            first_index += index_count;
+        }
+
+        // Every triangle belongs to exactly one meshlet
+        VGI_ASSERT(first_index == indices.size());
+        return result;
+    }
+
+    std::vector<mesh_lod> build_lods(std::span<const vertex> vertices,
+                                     std::vector<uint32_t>& indices, const lod_options& options) {
+        if (indices.size() % 3 != 0) throw vgi_error{"mesh is not a triangle list"};
+        if (indices.size() > UINT32_MAX) throw vgi_error{"mesh has too many indices"};
+        if (indices.empty()) return {};
+
+        std::vector<mesh_lod> result{mesh_lod{
+                .first_index = 0,
+                .index_count = static_cast<uint32_t>(indices.size()),
+                .error = 0.0f,
+        }};
+        if (vertices.empty() || options.max_levels <= 1) return result;
+
+        const std::vector<glm::vec3> origins = unpack_origins(vertices);
+        const std::vector<float> attributes = unpack_lod_attributes(vertices);
+        const std::vector<unsigned char> locked = lock_joint_seams(vertices, indices);
+        // Simplification errors are relative to the mesh's extents
+        const float scale = meshopt_simplifyScale(&origins.data()->x, origins.size(),
+                                                  sizeof(glm::vec3));
+
+        std::vector<uint32_t> source{indices};
+        std::vector<uint32_t> simplified(source.size());
+        float error = 0.0f;
+        while (result.size() < options.max_levels) {
+            const size_t target_triangles =
+                    static_cast<size_t>(static_cast<float>(source.size() / 3) * options.reduction);
+            float step_error = 0.0f;
+            const size_t index_count = meshopt_simplifyWithAttributes(
+                    simplified.data(), source.data(), source.size(), &origins.data()->x,
+                    origins.size(), sizeof(glm::vec3), attributes.data(),
+                    LOD_ATTRIBUTE_COUNT * sizeof(float), LOD_ATTRIBUTE_WEIGHTS,
+                    LOD_ATTRIBUTE_COUNT, locked.data(), target_triangles * 3, options.max_error,
+                    meshopt_SimplifyLockBorder, &step_error);
+            const float kept =
+                    static_cast<float>(index_count) / static_cast<float>(source.size());
+            if (index_count == 0 || kept > options.min_reduction) break;
+
+            // Errors of every step add up, since each level is simplified from the previous one
+            simplified.resize(index_count);
+            meshopt_optimizeVertexCache(simplified.data(), simplified.data(), index_count,
+                                        vertices.size());
+            error += step_error * scale;
+            result.push_back(mesh_lod{
+                    .first_index = static_cast<uint32_t>(indices.size()),
+                    .index_count = static_cast<uint32_t>(index_count),
+                    .error = error,
+            });
+            indices.insert(indices.end(), simplified.begin(), simplified.end());
+            std::swap(source, simplified);
+        }
+        return result;
+    }
+}  // namespace vgi
@@ -0,0 +1,98 @@
+/*! \file */
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <vgi/buffer/vertex.hpp>
+#include <vgi/resource/meshlet.hpp>
+
+namespace vgi {
+    /// @brief Optimization stages applied to a triangle list before it's uploaded
+    /// @details Stages run in the order they are declared, so each one preserves the work of the
+    /// previous ones as much as possible.
+    struct mesh_optimization {
+        /// @brief Merges the vertices that are identical once quantized
+        bool weld = true;
+        /// @brief Reorders triangles to make the best use of the post-transform vertex cache
+        bool vertex_cache = true;
+        /// @brief How much the vertex cache efficiency may degrade to reduce overdraw (i.e. `1.05`
+        /// allows up to 5% more cache misses). Values lower than one disable the stage.
+        float overdraw_threshold = 1.05f;
+        /// @brief Reorders vertices in the order they are first referenced, for fetch locality
+        bool vertex_fetch = true;
+
+        /// @brief Options that leave meshes untouched
+        constexpr static mesh_optimization none() noexcept {
+            return mesh_optimization{
+                    .weld = false,
+                    .vertex_cache = false,
+                    .overdraw_threshold = 0.0f,
+                    .vertex_fetch = false,
+            };
+        }
+
+        /// @brief Checks whether any stage is enabled
+        constexpr bool enabled() const noexcept {
+            return this->weld || this->vertex_cache || this->overdraw_threshold >= 1.0f ||
+                   this->vertex_fetch;
+        }
+    };
+
+    /// @brief Options of the simplification that generates the levels of detail of a mesh
+    struct lod_options {
+        /// @brief Maximum number of levels, including the full detail one
+        uint32_t max_levels = 5;
+        /// @brief Fraction of the triangles of a level that every coarser level aims to keep
+        float reduction = 0.5f;
+        /// @brief Largest error a single simplification step may introduce, relative to the
+        /// mesh's extents
+        float max_error = 0.05f;
+        /// @brief Levels that keep more than this fraction of the previous level's triangles are
+        /// discarded, and end the chain
+        float min_reduction = 0.85f;
+    };
+
+    /// @brief A level of detail of a mesh, drawn from a sub-range of its indices
+    struct mesh_lod {
+        /// @brief Index of the level's first index, relative to the first index of its mesh
+        uint32_t first_index;
+        /// @brief Number of indices of the level
+        uint32_t index_count;
+        /// @brief Largest distance between the level and the full detail mesh, in model units
+        float error;
+    };
+
+    /// @brief Optimizes an indexed triangle list in place
+    /// @param vertices Vertices of the mesh. Welding may shrink it, and the remaining stages
+    /// reorder it.
+    /// @param indices Indices of the triangle list. Its size must be a multiple of three.
+    /// @param options Stages to apply
+    void optimize_mesh(std::vector<vertex>& vertices, std::vector<uint32_t>& indices,
+                       const mesh_optimization& options = {});
+
+    /// @brief Splits an indexed triangle list into meshlets, with their culling bounds
+    /// @details Meshlets have up to `MAX_MESHLET_VERTICES` vertices and `MAX_MESHLET_TRIANGLES`
+    /// triangles. Meshes should be optimized (see `vgi::optimize_mesh`) beforehand.
+    /// @param vertices Vertices of the mesh
+    /// @param indices Indices of the triangle list. Triangles are reordered so that the ones of
+    /// every meshlet are contiguous.
+    /// @return The meshlets of the mesh, in the order of their triangles
+    std::vector<meshlet> build_meshlets(std::span<const vertex> vertices,
+                                        std::vector<uint32_t>& indices);
+
+    /// @brief Generates a chain of simplified levels of detail of an indexed triangle list
+    /// @details Every level is simplified from the previous one with quadric-error edge
+    /// collapses, which also weigh the normals and texture coordinates of the vertices. Vertices
+    /// on the mesh's borders and on the seams between the influences of different joints are
+    /// locked, so that levels keep matching the neighbouring primitives and skinning still
+    /// deforms them like the full detail mesh.
+    /// @param vertices Vertices of the mesh, which are shared by every level
+    /// @param indices Indices of the triangle list. The indices of the simplified levels are
+    /// appended to it, after the full detail ones.
+    /// @param options Simplification options
+    /// @return The levels of the mesh, starting with the full detail one
+    std::vector<mesh_lod> build_lods(std::span<const vertex> vertices,
+                                     std::vector<uint32_t>& indices,
+                                     const lod_options& options = {});
+}  // namespace vgi
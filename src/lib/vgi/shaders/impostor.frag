@@ -0,0 +1,16 @@
+#version 450
+
+// Shades impostors with the texels of their atlas, discarding the ones their mesh didn't cover
+// (see `vgi::impostor_atlas`)
+
+layout (location = 0) in vec3 inTex;
+
+layout (location = 0) out vec4 outColor;
+
+layout (binding = 0) uniform sampler2DArray atlas;
+
+void main() {
+    vec4 color = texture(atlas, inTex);
+    if (color.a < 0.5) discard;
+    outColor = vec4(color.rgb, 1.0);
+}
@@ -0,0 +1,48 @@
+#version 450
+
+// Draws impostors as camera-facing quads, textured with the view of their mesh taken from the
+// direction nearest to the camera (see `vgi::impostor_atlas`)
+
+layout (location = 0) in vec4 inSphere;
+layout (location = 1) in uint inLayer;
+
+layout (location = 0) out vec3 outTex;
+
+layout (push_constant) uniform Constants {
+    mat4 viewProjection;
+    vec3 cameraOrigin;
+    uint grid;
+} constants;
+
+// Octahedral mapping of the whole sphere, with the upper hemisphere at the center of the grid
+vec2 octahedralEncode(vec3 direction) {
+    vec3 p = direction / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+    vec2 result = p.xz;
+    if (p.y < 0.0) {
+        vec2 signs = vec2(result.x >= 0.0 ? 1.0 : -1.0, result.y >= 0.0 ? 1.0 : -1.0);
+        result = (1.0 - abs(result.yx)) * signs;
+    }
+    return result * 0.5 + 0.5;
+}
+
+void main() {
+    vec3 center = inSphere.xyz;
+    float radius = inSphere.w;
+    vec3 direction = normalize(constants.cameraOrigin - center);
+
+    // Views were baked with the same basis (see `view_up` on `impostor.cpp`)
+    vec3 reference = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(reference, direction));
+    vec3 up = cross(direction, right);
+
+    // Corners of a triangle strip, from the bottom left to the top right
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1) * 2.0 - 1.0;
+    gl_Position = constants.viewProjection *
+                  vec4(center + (right * corner.x + up * corner.y) * radius, 1.0);
+
+    // Views are flipped vertically, like every other projection
+    float grid = float(constants.grid);
+    vec2 cell = min(floor(octahedralEncode(direction) * grid), vec2(grid - 1.0));
+    vec2 local = vec2(corner.x, -corner.y) * 0.5 + 0.5;
+    outTex = vec3((cell + local) / grid, float(inLayer));
+}
@@ -1,6 +1,8 @@
 #include "texture.hpp"
 
 #include <SDL3_image/SDL_image.h>
+#include <algorithm>
+#include <cstring>
 #include <vgi/io.hpp>
 #include <vgi/math.hpp>
 
@@ -176,7 +178,7 @@ namespace vgi {
             cmdbuf.copyBufferToImage(
                     transfer, this->image, vk::ImageLayout::eTransferDstOptimal,
                     vk::BufferImageCopy{
-                            .bufferOffset = start_offset,
+                            .bufferOffset = transfer.buffer_offset() + start_offset,
                             .bufferRowLength = 0,
                             .bufferImageHeight = 0,
                             .imageSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor,
@@ -196,28 +198,97 @@ namespace vgi {
         }
     }
 
+    texture::texture(window& parent, staging_ring& staging, const surface& surface,
+                     vk::ImageUsageFlags usage, vk::SampleCountFlagBits samples,
+                     vk::ImageLayout initial_layout) :
+        aspect_mask(vk::ImageAspectFlagBits::eColor) {
+        vk::Format format = sdl_to_vk_format(surface->format, parent.colorspace());
+        if (format == vk::Format::eUndefined) throw vgi_error{"pixel format not supported"};
+        vk::ComponentMapping swizzle = {
+                vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity,
+                vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity};
+
+        std::optional<uint32_t> width = math::check_cast<uint32_t>(surface->w);
+        std::optional<uint32_t> height = math::check_cast<uint32_t>(surface->h);
+        std::optional<uint32_t> pitch = math::check_cast<uint32_t>(surface->pitch);
+        if (!width || !height || !pitch) throw vgi_error{"invalid size"};
+        this->init(parent, *width, *height, format, usage, samples, vk::ImageLayout::eUndefined,
+                   swizzle);
+
+        try {
+            size_t pixel_size = bytes_per_pixel(format);
+            std::optional<size_t> length = math::check_mul<size_t>(*width, pixel_size);
+            if (!length) throw vgi_error{"too many pixels"};
+            const size_t row_size = (std::min<size_t>) (*length, *pitch);
+
+            // Bands are kept within half of the ring, like the chunks of `staging_ring::upload`,
+            // so that the device can consume one band while the next one is being written
+            const size_t band_rows = std::clamp<size_t>(
+                    static_cast<size_t>(staging.capacity() / 2) / *length, 1, *height);
+
+            this->change_layout(staging.record(parent), vk::ImageLayout::eUndefined,
+                                vk::ImageLayout::eTransferDstOptimal,
+                                vk::PipelineStageFlagBits::eTransfer |
+                                        vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                                        vk::PipelineStageFlagBits::eFragmentShader,
+                                vk::PipelineStageFlagBits::eTransfer);
+
+            const std::byte* src = static_cast<const std::byte*>(surface->pixels);
+            for (uint32_t row = 0; row < *height;) {
+                const uint32_t rows = static_cast<uint32_t>(
+                        (std::min<size_t>) (band_rows, *height - row));
+                transfer_buffer region = staging.allocate(parent, *length * rows);
+                std::byte* dest = region->data();
+                for (uint32_t i = 0; i < rows; ++i) {
+                    std::memcpy(dest, src, row_size);
+                    dest += *length;
+                    src += *pitch;
+                }
+
+                // Allocating may submit the pending batch, so the command buffer is fetched again
+                staging.record(parent).copyBufferToImage(
+                        region, this->image, vk::ImageLayout::eTransferDstOptimal,
+                        vk::BufferImageCopy{
+                                .bufferOffset = region.buffer_offset(),
+                                .bufferRowLength = 0,
+                                .bufferImageHeight = 0,
+                                .imageSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                                                     .layerCount = 1},
+                                .imageOffset = {0, static_cast<int32_t>(row), 0},
+                                .imageExtent = {*width, rows, 1},
+                        });
+                row += rows;
+            }
+
+            if (initial_layout != vk::ImageLayout::eUndefined) {
+                this->change_layout(staging.record(parent), vk::ImageLayout::eTransferDstOptimal,
+                                    initial_layout, vk::PipelineStageFlagBits::eTransfer,
+                                    vk::PipelineStageFlagBits::eAllCommands);
+            }
+        } catch (...) {
+            std::move(*this).destroy(parent);
+            throw;
+        }
+    }
+
     void texture::init(const window& parent, uint32_t width, uint32_t height, vk::Format format,
                        vk::ImageUsageFlags usage, vk::SampleCountFlagBits samples,
                        vk::ImageLayout initial_layout, const vk::ComponentMapping& components) {
-        const VmaAllocationCreateInfo alloc_create_info{.usage = VMA_MEMORY_USAGE_AUTO};
-        const VkImageCreateInfo create_info = vk::ImageCreateInfo{
-                .imageType = vk::ImageType::e2D,
-                .format = format,
-                .extent = {width, height, 1},
-                .mipLevels = 1,
-                .arrayLayers = 1,
-                .samples = samples,
-                .tiling = vk::ImageTiling::eOptimal,
-                .usage = usage | vk::ImageUsageFlagBits::eTransferSrc |
-                         vk::ImageUsageFlagBits::eTransferDst,
-                .sharingMode = vk::SharingMode::eExclusive,
-                .initialLayout = initial_layout,
-        };
-
-        VkImage image;
-        VGI_VMA_CHECK(vmaCreateImage(parent, &create_info, &alloc_create_info, &image,
-                                     &this->allocation, nullptr));
-        this->image = image;
+        std::tie(this->image, this->allocation) = parent.create_image(
+                vk::ImageCreateInfo{
+                        .imageType = vk::ImageType::e2D,
+                        .format = format,
+                        .extent = {width, height, 1},
+                        .mipLevels = 1,
+                        .arrayLayers = 1,
+                        .samples = samples,
+                        .tiling = vk::ImageTiling::eOptimal,
+                        .usage = usage | vk::ImageUsageFlagBits::eTransferSrc |
+                                 vk::ImageUsageFlagBits::eTransferDst,
+                        .sharingMode = vk::SharingMode::eExclusive,
+                        .initialLayout = initial_layout,
+                },
+                VmaAllocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO});
         this->view = parent->createImageView(vk::ImageViewCreateInfo{
                 .image = this->image,
                 .viewType = vk::ImageViewType::e2D,
@@ -251,7 +322,7 @@ namespace vgi {
 
     void texture::destroy(const window& parent) && noexcept {
         if (this->view) parent->destroyImageView(this->view);
-        vmaDestroyImage(parent, this->image, this->allocation);
+        parent.destroy_image(this->image, this->allocation);
     }
 
     vk::SamplerCreateInfo sampler_options::create_info(const window& parent) const noexcept {
@@ -314,6 +385,7 @@ namespace vgi {
                 break;
 
             case vk::ImageLayout::eDepthStencilAttachmentOptimal:
+            case vk::ImageLayout::eDepthAttachmentOptimal:
                 // Image is a depth/stencil attachment
                 // Make sure any writes to the depth/stencil buffer have been finished
                 img_memory_barrier.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
@@ -369,6 +441,12 @@ namespace vgi {
                                                    vk::AccessFlagBits::eDepthStencilAttachmentWrite;
                 break;
 
+            case vk::ImageLayout::eDepthAttachmentOptimal:
+                // Image layout will be used as a depth attachment, which is tested and written
+                img_memory_barrier.dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                                                   vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+                break;
+
             case vk::ImageLayout::eShaderReadOnlyOptimal:
                 // Image will be read in a shader (sampler, input attachment)
                 // Make sure any writes to the image have been finished
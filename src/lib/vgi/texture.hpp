@@ -5,11 +5,13 @@
 #include <memory>
 #include <utility>
 
+#include "buffer/staging.hpp"
 #include "buffer/transfer.hpp"
 #include "cmdbuf.hpp"
 #include "defs.hpp"
 #include "forward.hpp"
 #include "pipeline.hpp"
+#include "pipeline/descriptor.hpp"
 #include "resource.hpp"
 #include "vulkan.hpp"
 
@@ -149,6 +151,21 @@ namespace vgi {
                 vk::ImageLayout initial_layout = vk::ImageLayout::eShaderReadOnlyOptimal,
                 size_t offset = 0);
 
+        /// @brief Creates a new texture by streaming a surface to it through a staging ring
+        /// @details The surface is split into bands of rows, each one copied from its own region of
+        /// the ring, so staging memory stays bounded no matter the size of the surface. The copies
+        /// are recorded into the ring's pending batch.
+        /// @param parent Window that will create the texture
+        /// @param staging Staging ring through which the surface is streamed
+        /// @param surface Surface that will be uploaded to the device
+        /// @param usage Bitmask of describing the intended usage of the image
+        /// @param samples Value specifying the number of samples per texel
+        /// @param initial_layout The initial layout of all image subresources of the image
+        texture(window& parent, staging_ring& staging, const surface& surface,
+                vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eSampled,
+                vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1,
+                vk::ImageLayout initial_layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+
         /// @brief Move constructor
         /// @param other Object to move
         texture(texture&& other) noexcept :
@@ -218,15 +235,15 @@ namespace vgi {
                 window& parent, const surface& surface,
                 vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eSampled,
                 vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1) {
-            vgi::command_buffer cmdbuf{parent};
-            auto [tex, transfer] = upload(parent, cmdbuf, surface, usage, samples);
+            vgi::staging_ring& staging = parent.staging();
+            texture tex{parent, staging, surface, usage, samples};
             try {
-                std::move(cmdbuf).submit_and_wait();
+                staging.wait(parent);
             } catch (...) {
                 std::move(tex).destroy(parent);
                 throw;
             }
-            return std::move(tex);
+            return tex;
         }
 
         /// @brief Computes the minimum remaining space a transfer buffer must have to transfer the
@@ -383,24 +400,27 @@ namespace vgi {
             return {.sampler = this->samplers[index], .imageView = *this, .imageLayout = layout};
         }
 
+        /// @brief Queues the writes needed for a descriptor pool's bindings to use this texture
+        /// @param writer Writer where the descriptor writes will be queued
+        /// @param pool Descriptor pool to update
+        /// @param binding Slot to which bind the texture
+        void update_descriptors(descriptor_writer& writer, const descriptor_pool& pool,
+                                uint32_t binding) const {
+            for (uint32_t i = 0; i < pool.size(); ++i) {
+                writer.write_image(pool[i], binding, vk::DescriptorType::eCombinedImageSampler,
+                                   this->descriptor_info(i));
+            }
+        }
+
         /// @brief Updates a descriptor pool's bindings so that they use this texture
         /// @param parent Window used to create the descriptor pool and the buffer
         /// @param pool Descriptor pool to update
         /// @param binding Slot to which bind the buffer
-        void update_descriptors(const window& parent, descriptor_pool& pool,
+        void update_descriptors(const window& parent, const descriptor_pool& pool,
                                 uint32_t binding) const {
-            for (uint32_t i = 0; i < pool.size(); ++i) {
-                const vk::DescriptorImageInfo img_info = this->descriptor_info(i);
-                parent->updateDescriptorSets(
-                        vk::WriteDescriptorSet{
-                                .dstSet = pool[i],
-                                .dstBinding = binding,
-                                .descriptorCount = 1,
-                                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-                                .pImageInfo = &img_info,
-                        },
-                        {});
-            }
+            descriptor_writer writer;
+            this->update_descriptors(writer, pool, binding);
+            writer.flush(parent);
         }
 
         /// @brief Destroys the resource
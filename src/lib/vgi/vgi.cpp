@@ -2,9 +2,11 @@
 
 #include <SDL3/SDL_vulkan.h>
 #include <algorithm>
+#include <cstring>
 #include <ranges>
 #include <vector>
 
+#include "alloc.hpp"
 #include "collections/slab.hpp"
 #include "defs.hpp"
 #include "fs.hpp"
@@ -17,6 +19,25 @@ VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 #error "This project requires dynamic Vulkan library"
 #endif
 
+// Memory callback functions
+extern "C" {
+void* SDLCALL sdl_malloc(size_t size) { return vgi::host_alloc(vgi::alloc_scope::sdl, size); }
+
+void* SDLCALL sdl_calloc(size_t count, size_t size) {
+    std::optional<size_t> byte_size = vgi::math::check_mul<size_t>(count, size);
+    if (!byte_size) return nullptr;
+    void* ptr = vgi::host_alloc(vgi::alloc_scope::sdl, byte_size.value());
+    if (ptr != nullptr) std::memset(ptr, 0, byte_size.value());
+    return ptr;
+}
+
+void* SDLCALL sdl_realloc(void* ptr, size_t size) {
+    return vgi::host_realloc(vgi::alloc_scope::sdl, ptr, size);
+}
+
+void SDLCALL sdl_free(void* ptr) { vgi::host_free(vgi::alloc_scope::sdl, ptr); }
+}
+
 // Log callback functions
 extern "C" {
 void SDLCALL sdl_log_callback(void* userdata, int category, SDL_LogPriority priority,
@@ -241,20 +262,26 @@ namespace vgi {
         };
 
         // Create Instance
-        instance = vk::createInstance(vk::InstanceCreateInfo{
-                .pNext = &debug_create_info,
-                .flags = flags,
-                .pApplicationInfo = &app_info,
-                .enabledLayerCount = layer_count.value(),
-                .ppEnabledLayerNames = layers.data(),
-                .enabledExtensionCount = extension_count.value(),
-                .ppEnabledExtensionNames = extensions.data(),
-        });
+        instance = vk::createInstance(
+                vk::InstanceCreateInfo{
+                        .pNext = &debug_create_info,
+                        .flags = flags,
+                        .pApplicationInfo = &app_info,
+                        .enabledLayerCount = layer_count.value(),
+                        .ppEnabledLayerNames = layers.data(),
+                        .enabledExtensionCount = extension_count.value(),
+                        .ppEnabledExtensionNames = extensions.data(),
+                },
+                host_callbacks(alloc_scope::vulkan));
     }
 
     void init(const char8_t* app_name) {
         // Setup default logger
         add_logger<default_logger>();
+#if VGI_HOST_ALLOCATOR
+        // Route SDL's allocations through vgi. This must happen before SDL allocates anything.
+        sdl::tri(SDL_SetMemoryFunctions(sdl_malloc, sdl_calloc, sdl_realloc, sdl_free));
+#endif
         // Initialize SDL
         sdl::tri(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMEPAD));
         try {
@@ -278,7 +305,7 @@ namespace vgi {
                 try {
                     VULKAN_HPP_DEFAULT_DISPATCHER.init(instance);
                 } catch (...) {
-                    instance.destroy();
+                    instance.destroy(host_callbacks(alloc_scope::vulkan));
                     throw;
                 }
             } catch (...) {
@@ -326,7 +353,7 @@ namespace vgi {
 
     void quit() noexcept {
         systems.clear();
-        if (instance) std::exchange(instance, nullptr).destroy();
+        if (instance) std::exchange(instance, nullptr).destroy(host_callbacks(alloc_scope::vulkan));
         SDL_Vulkan_UnloadLibrary();
         SDL_Quit();
     }
@@ -1,10 +1,13 @@
 #include "window.hpp"
 
 #include <SDL3/SDL_vulkan.h>
+#include <array>
 #include <iterator>
 #include <optional>
 #include <ranges>
 
+#include "alloc.hpp"
+#include "buffer/vertex.hpp"
 #include "cmdbuf.hpp"
 #include "log.hpp"
 #include "math.hpp"
@@ -54,7 +57,8 @@ namespace vgi {
         return result;
     }
 
-    static vk::Device create_logical_device(const device& physical, uint32_t queue_family) {
+    static vk::Device create_logical_device(const device& physical, uint32_t queue_family,
+                                            bool& memory_budget) {
         std::vector<std::string> available_exts = enumerate_device_exts(physical);
         std::vector<const char*> extensions({VK_KHR_SWAPCHAIN_EXTENSION_NAME});
 
@@ -73,15 +77,31 @@ namespace vgi {
         }
 #endif
 
+        // Enable `VK_EXT_memory_budget`, if available, so that the driver reports heap budgets
+        memory_budget = std::ranges::find(available_exts, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) !=
+                        available_exts.end();
+        if (memory_budget) extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
         // Enable all required features
         vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan11Features,
                            vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features>
                 features;
 
         features.get<vk::PhysicalDeviceFeatures2>().features = vk::PhysicalDeviceFeatures{
+                // Enable batched indirect draws (if available), used by `vgi::draw_list`
+                .multiDrawIndirect = physical.feats().multiDrawIndirect,
+                .drawIndirectFirstInstance = physical.feats().drawIndirectFirstInstance,
                 // Enable sampler anisotropy (if available)
                 .samplerAnisotropy = physical.feats().samplerAnisotropy,
         };
+        // Timeline semaphores are used to track the uploads of the staging ring, and compute
+        // shaders (i.e. meshlet culling) access buffers through their device address
+        vk::PhysicalDeviceVulkan12Features& feats_1_2 =
+                features.get<vk::PhysicalDeviceVulkan12Features>();
+        feats_1_2.timelineSemaphore = vk::True;
+        feats_1_2.bufferDeviceAddress = vk::True;
+        // Enable draw counts sourced from buffers (if available), used by the GPU culling passes
+        feats_1_2.drawIndirectCount = physical.feats_1_2().drawIndirectCount;
         features.get<vk::PhysicalDeviceVulkan13Features>() = vk::PhysicalDeviceVulkan13Features {
                 .synchronization2 = vk::True,
                 .dynamicRendering = vk::True,
@@ -97,24 +117,31 @@ namespace vgi {
         std::optional<uint32_t> extension_count = math::check_cast<uint32_t>(extensions.size());
         if (!extension_count) throw vgi_error{"too many device extensions"};
 
-        return physical->createDevice(vk::DeviceCreateInfo{
-                .pNext = &features.get<vk::PhysicalDeviceFeatures2>(),
-                .queueCreateInfoCount = 1,
-                .pQueueCreateInfos = &queue_info,
-                .enabledExtensionCount = extension_count.value(),
-                .ppEnabledExtensionNames = extensions.data(),
-        });
+        return physical->createDevice(
+                vk::DeviceCreateInfo{
+                        .pNext = &features.get<vk::PhysicalDeviceFeatures2>(),
+                        .queueCreateInfoCount = 1,
+                        .pQueueCreateInfos = &queue_info,
+                        .enabledExtensionCount = extension_count.value(),
+                        .ppEnabledExtensionNames = extensions.data(),
+                },
+                host_callbacks(alloc_scope::vulkan));
     }
 
-    static VmaAllocator create_allocator(const device& physical, vk::Device logical) {
+    static VmaAllocator create_allocator(const device& physical, vk::Device logical,
+                                         bool memory_budget) {
         VmaVulkanFunctions vk_fns{
                 .vkGetInstanceProcAddr = VULKAN_HPP_DEFAULT_DISPATCHER.vkGetInstanceProcAddr,
                 .vkGetDeviceProcAddr = VULKAN_HPP_DEFAULT_DISPATCHER.vkGetDeviceProcAddr,
         };
 
         VmaAllocatorCreateInfo create_info{
+                .flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT |
+                         (memory_budget ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0u),
                 .physicalDevice = physical,
                 .device = logical,
+                .pAllocationCallbacks = reinterpret_cast<const VkAllocationCallbacks*>(
+                        host_callbacks(alloc_scope::vma)),
                 .pVulkanFunctions = &vk_fns,
                 .instance = instance,
                 .vulkanApiVersion = VK_API_VERSION_1_3,
@@ -225,12 +252,12 @@ namespace vgi {
                 new_render_complete.push_back(logical.createSemaphoreUnique({}));
 
                 depth_texture& depth = new_swapchain_depths.emplace_back(
-                        this->logical, this->allocator, this->depth_format,
-                        new_swapchain_extent.width, new_swapchain_extent.height);
+                        *this, this->depth_format, new_swapchain_extent.width,
+                        new_swapchain_extent.height);
 
                 // Change the layout of the depth image to the required one
                 change_layout(cmdbuf, depth.image, vk::ImageLayout::eUndefined,
-                              vk::ImageLayout::eDepthStencilAttachmentOptimal,
+                              vk::ImageLayout::eDepthAttachmentOptimal,
                               vk::PipelineStageFlagBits::eTopOfPipe,
                               vk::PipelineStageFlagBits::eEarlyFragmentTests,
                               vk::ImageAspectFlagBits::eDepth);
@@ -243,7 +270,7 @@ namespace vgi {
                 this->logical.waitIdle();
 
                 for (depth_texture& depth: this->swapchain_depths) {
-                    std::move(depth).destroy(this->logical, this->allocator);
+                    std::move(depth).destroy(*this);
                 }
                 for (vk::ImageView view: this->swapchain_views) {
                     this->logical.destroyImageView(view);
@@ -255,7 +282,7 @@ namespace vgi {
             }
         } catch (...) {
             for (depth_texture& depth: new_swapchain_depths) {
-                std::move(depth).destroy(this->logical, this->allocator);
+                std::move(depth).destroy(*this);
             }
             throw;
         }
@@ -280,25 +307,23 @@ namespace vgi {
         return create_swapchain(width.value(), height.value(), vsync, hdr10);
     }
 
-    window::depth_texture::depth_texture(vk::Device logical, VmaAllocator allocator,
-                                         vk::Format format, uint32_t width, uint32_t height) {
-        VkImageCreateInfo create_info = vk::ImageCreateInfo{
-                .imageType = vk::ImageType::e2D,
-                .format = format,
-                .extent = {width, height, UINT32_C(1)},
-                .mipLevels = 1,
-                .arrayLayers = 1,
-                .samples = vk::SampleCountFlagBits::e1,
-                .tiling = vk::ImageTiling::eOptimal,
-                .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
-                .sharingMode = vk::SharingMode::eExclusive,
-        };
-
-        VmaAllocationCreateInfo alloc_create_info{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE};
-        VkImage image = VK_NULL_HANDLE;
-        VGI_VMA_CHECK(vmaCreateImage(allocator, &create_info, &alloc_create_info, &image,
-                                     &this->allocation, nullptr));
-        this->image = image;
+    window::depth_texture::depth_texture(const window& parent, vk::Format format, uint32_t width,
+                                         uint32_t height) {
+        std::tie(this->image, this->allocation) = parent.create_image(
+                vk::ImageCreateInfo{
+                        .imageType = vk::ImageType::e2D,
+                        .format = format,
+                        .extent = {width, height, UINT32_C(1)},
+                        .mipLevels = 1,
+                        .arrayLayers = 1,
+                        .samples = vk::SampleCountFlagBits::e1,
+                        .tiling = vk::ImageTiling::eOptimal,
+                        // Depth is also sampled by compute passes (i.e. `vgi::depth_pyramid`)
+                        .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                                 vk::ImageUsageFlagBits::eSampled,
+                        .sharingMode = vk::SharingMode::eExclusive,
+                },
+                VmaAllocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE});
 
         vk::ImageViewCreateInfo view_create_info{
                 .image = this->image,
@@ -310,12 +335,12 @@ namespace vgi {
                                      .levelCount = 1,
                                      .layerCount = 1},
         };
-        this->view = logical.createImageView(view_create_info);
+        this->view = parent->createImageView(view_create_info);
     }
 
-    void window::depth_texture::destroy(vk::Device logical, VmaAllocator allocator) && noexcept {
-        if (this->view) logical.destroyImageView(this->view);
-        vmaDestroyImage(allocator, this->image, this->allocation);
+    void window::depth_texture::destroy(const window& parent) && noexcept {
+        if (this->view) parent->destroyImageView(this->view);
+        parent.destroy_image(this->image, this->allocation);
     }
 
     window::window(const vgi::device& device, const char8_t* title, int width, int height,
@@ -326,7 +351,8 @@ namespace vgi {
         // Find depth format
         auto depth_formats =
                 device.supported_formats(std::span<const vk::Format>{DEPTH_FORMATS},
-                                         vk::FormatFeatureFlagBits::eDepthStencilAttachment);
+                                         vk::FormatFeatureFlagBits::eDepthStencilAttachment |
+                                                 vk::FormatFeatureFlagBits::eSampledImage);
         if (std::ranges::empty(depth_formats))
             throw vgi_error{"Device does not support depth textures"};
         this->depth_format = *std::ranges::begin(depth_formats);
@@ -354,14 +380,20 @@ namespace vgi {
             }
         }
 
-        this->logical = create_logical_device(device, queue_family.value());
-        this->allocator = create_allocator(device, this->logical);
+        this->logical =
+                create_logical_device(device, queue_family.value(), this->memory_budget_ext);
+        this->allocator = create_allocator(device, this->logical, this->memory_budget_ext);
         this->queue = this->logical.getQueue(queue_family.value(), 0);
         this->cmdpool = this->logical.createCommandPool(vk::CommandPoolCreateInfo{
                 .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
                 .queueFamilyIndex = queue_family.value(),
         });
         this->create_swapchain(vsync, hdr10);
+        this->transient_data = transient_buffer{*this, TRANSIENT_BUFFER_SIZE};
+        this->staging_data = staging_ring{*this, STAGING_BUFFER_SIZE};
+        for (frame_arena& arena: this->arenas) arena = frame_arena{FRAME_ARENA_SIZE};
+        this->geometry_data = geometry_pool{sizeof(vertex_position), sizeof(vertex_attributes),
+                                            GEOMETRY_PAGE_SIZE};
 
         // Command Buffers
         vkn::allocateCommandBuffers(this->logical,
@@ -418,6 +450,11 @@ namespace vgi {
                                            UINT64_MAX)) {
                 case vk::Result::eSuccess: {
                     (*this)->resetFences(this->in_flight[this->current_frame]);
+                    // The device is done with this frame, so its transient data can be reused
+                    this->transient_data.reset(this->current_frame);
+                    this->arenas[this->current_frame].reset();
+                    this->geometry_data.reclaim(this->current_frame);
+                    this->staging_data.reclaim(*this);
                     goto acquire_image;
                 }
                 case vk::Result::eTimeout:
@@ -432,7 +469,6 @@ namespace vgi {
         // Get the next swap chain image from the implementation
         // Note that the implementation is free to return the images in any order, so we must use
         // the acquire function and can't just cycle through the images/imageIndex on our own
-        uint32_t current_image;
         while (true) {
             vk::ResultValue<uint32_t> result{{}, {}};
             try {
@@ -449,7 +485,7 @@ namespace vgi {
                     this->should_resize = true;
                     [[fallthrough]];
                 case vk::Result::eSuccess:
-                    current_image = result.value;
+                    this->current_image = result.value;
                     goto updates;
                 case vk::Result::eNotReady:
                 case vk::Result::eTimeout:
@@ -462,12 +498,13 @@ namespace vgi {
 
     updates:
         vk::CommandBuffer cmdbuf = this->cmdbufs[this->current_frame];
-        vk::Image img = this->swapchain_images[current_image];
-        vk::ImageView view = this->swapchain_views[current_image];
-        depth_texture& depth = this->swapchain_depths[current_image];
+        vk::Image img = this->swapchain_images[this->current_image];
 
         cmdbuf.reset();
         cmdbuf.begin(vk::CommandBufferBeginInfo{});
+        // The device is done with this frame, so the defragmentation pass it recorded (if any)
+        // can be completed, and a new one recorded
+        this->defrag_data.step(*this, this->current_frame);
         change_layout(cmdbuf, img, vk::ImageLayout::eUndefined,
                       vk::ImageLayout::eColorAttachmentOptimal,
                       vk::PipelineStageFlagBits::eColorAttachmentOutput,
@@ -494,31 +531,7 @@ namespace vgi {
         }
 
         // Run scene renders
-        vk::RenderingAttachmentInfo color_attachment{
-                .imageView = view,
-                .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
-                .loadOp = vk::AttachmentLoadOp::eClear,
-                .storeOp = vk::AttachmentStoreOp::eStore,
-                .clearValue = {.color = {.float32 = {{0.0f, 0.0f, 0.0f, 1.0f}}}},
-        };
-
-        vk::RenderingAttachmentInfo depth_attachment{
-                .imageView = depth.view,
-                .imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
-                .loadOp = vk::AttachmentLoadOp::eClear,
-                .storeOp = vk::AttachmentStoreOp::eDontCare,
-                .clearValue = {.depthStencil = {.depth = 1.0f, .stencil = 0}},
-        };
-
-        cmdbuf.beginRendering(vk::RenderingInfo{
-                // TODO Per-scene render area
-                .renderArea = {.extent = this->swapchain_info.imageExtent},
-                .layerCount = 1,
-                .colorAttachmentCount = 1,
-                .pColorAttachments = &color_attachment,
-                .pDepthAttachment = &depth_attachment,
-                .pStencilAttachment = nullptr,
-        });
+        this->begin_rendering(cmdbuf, vk::AttachmentLoadOp::eClear);
 
         const vk::Extent2D render_size = this->draw_size();
         const float render_width = render_size.width;
@@ -547,30 +560,50 @@ namespace vgi {
         change_layout(cmdbuf, img, vk::ImageLayout::eColorAttachmentOptimal,
                       vk::ImageLayout::ePresentSrcKHR);
         cmdbuf.end();
+        this->transient_data.flush(*this, this->current_frame);
+        // Uploads recorded during this frame are executed right before it, within the same queue
+        // submission
+        std::array<vk::SubmitInfo2, 2> submits;
+        uint32_t submit_count = 0;
+        vk::CommandBufferSubmitInfo staging_cmdbuf;
+        vk::SemaphoreSubmitInfo staging_signal;
+        if (this->staging_data.prepare(*this, staging_cmdbuf, staging_signal)) {
+            submits[submit_count++] = vk::SubmitInfo2{
+                    .commandBufferInfoCount = 1,
+                    .pCommandBufferInfos = &staging_cmdbuf,
+                    .signalSemaphoreInfoCount = 1,
+                    .pSignalSemaphoreInfos = &staging_signal,
+            };
+        }
 
-        constexpr vk::PipelineStageFlags waitStageMask[1] = {
-                vk::PipelineStageFlagBits::eColorAttachmentOutput,
+        const vk::SemaphoreSubmitInfo wait_info{
+                .semaphore = this->present_complete[this->current_frame],
+                .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+        };
+        const vk::CommandBufferSubmitInfo cmdbuf_info{.commandBuffer = cmdbuf};
+        const vk::SemaphoreSubmitInfo signal_info{
+                .semaphore = this->render_complete[this->current_image],
+                .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+        };
+        submits[submit_count++] = vk::SubmitInfo2{
+                .waitSemaphoreInfoCount = 1,
+                .pWaitSemaphoreInfos = &wait_info,
+                .commandBufferInfoCount = 1,
+                .pCommandBufferInfos = &cmdbuf_info,
+                .signalSemaphoreInfoCount = 1,
+                .pSignalSemaphoreInfos = &signal_info,
         };
 
-        this->queue.submit(
-                vk::SubmitInfo{
-                        .waitSemaphoreCount = 1,
-                        .pWaitSemaphores = &this->present_complete[this->current_frame],
-                        .pWaitDstStageMask = waitStageMask,
-                        .commandBufferCount = 1,
-                        .pCommandBuffers = &cmdbuf,
-                        .signalSemaphoreCount = 1,
-                        .pSignalSemaphores = &this->render_complete[current_image],
-                },
-                this->in_flight[this->current_frame]);
+        this->queue.submit2(vk::ArrayProxy<const vk::SubmitInfo2>{submit_count, submits.data()},
+                            this->in_flight[this->current_frame]);
 
         try {
             switch (this->queue.presentKHR(vk::PresentInfoKHR{
                     .waitSemaphoreCount = 1,
-                    .pWaitSemaphores = &this->render_complete[current_image],
+                    .pWaitSemaphores = &this->render_complete[this->current_image],
                     .swapchainCount = 1,
                     .pSwapchains = &this->swapchain,
-                    .pImageIndices = &current_image,
+                    .pImageIndices = &this->current_image,
             })) {
                 case vk::Result::eSuccess:
                     break;
@@ -592,16 +625,182 @@ namespace vgi {
                               window::MAX_FRAMES_IN_FLIGHT;
     }
 
+    void window::suspend_rendering(vk::CommandBuffer cmdbuf) const noexcept {
+        cmdbuf.endRendering();
+        // Rendering is resumed loading the color attachment, so it must see the previous writes
+        cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                               vk::PipelineStageFlagBits::eColorAttachmentOutput, {},
+                               vk::MemoryBarrier{
+                                       .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
+                                       .dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead |
+                                                        vk::AccessFlagBits::eColorAttachmentWrite,
+                               },
+                               {}, {});
+        change_layout(cmdbuf, this->swapchain_depths[this->current_image].image,
+                      vk::ImageLayout::eDepthAttachmentOptimal,
+                      vk::ImageLayout::eShaderReadOnlyOptimal,
+                      vk::PipelineStageFlagBits::eLateFragmentTests,
+                      vk::PipelineStageFlagBits::eComputeShader, vk::ImageAspectFlagBits::eDepth);
+    }
+
+    void window::resume_rendering(vk::CommandBuffer cmdbuf) const noexcept {
+        change_layout(cmdbuf, this->swapchain_depths[this->current_image].image,
+                      vk::ImageLayout::eShaderReadOnlyOptimal,
+                      vk::ImageLayout::eDepthAttachmentOptimal,
+                      vk::PipelineStageFlagBits::eComputeShader,
+                      vk::PipelineStageFlagBits::eEarlyFragmentTests,
+                      vk::ImageAspectFlagBits::eDepth);
+        // Viewports and scissors are command buffer state, so they outlive the suspension
+        this->begin_rendering(cmdbuf, vk::AttachmentLoadOp::eLoad);
+    }
+
+    void window::begin_rendering(vk::CommandBuffer cmdbuf,
+                                 vk::AttachmentLoadOp load_op) const noexcept {
+        vk::RenderingAttachmentInfo color_attachment{
+                .imageView = this->swapchain_views[this->current_image],
+                .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+                .loadOp = load_op,
+                .storeOp = vk::AttachmentStoreOp::eStore,
+                .clearValue = {.color = {.float32 = {{0.0f, 0.0f, 0.0f, 1.0f}}}},
+        };
+
+        // Depth is stored, so that it survives a suspension of the rendering
+        vk::RenderingAttachmentInfo depth_attachment{
+                .imageView = this->swapchain_depths[this->current_image].view,
+                .imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
+                .loadOp = load_op,
+                .storeOp = vk::AttachmentStoreOp::eStore,
+                .clearValue = {.depthStencil = {.depth = 1.0f, .stencil = 0}},
+        };
+
+        cmdbuf.beginRendering(vk::RenderingInfo{
+                // TODO Per-scene render area
+                .renderArea = {.extent = this->swapchain_info.imageExtent},
+                .layerCount = 1,
+                .colorAttachmentCount = 1,
+                .pColorAttachments = &color_attachment,
+                .pDepthAttachment = &depth_attachment,
+                .pStencilAttachment = nullptr,
+        });
+    }
+
+    std::vector<heap_budget> window::heap_budgets() const {
+        const VkPhysicalDeviceMemoryProperties* props;
+        vmaGetMemoryProperties(this->allocator, &props);
+
+        VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+        vmaGetHeapBudgets(this->allocator, budgets);
+
+        std::vector<heap_budget> result;
+        result.reserve(props->memoryHeapCount);
+        for (uint32_t i = 0; i < props->memoryHeapCount; ++i) {
+            result.push_back(heap_budget{
+                    .flags = vk::MemoryHeapFlags{props->memoryHeaps[i].flags},
+                    .block_count = budgets[i].statistics.blockCount,
+                    .allocation_count = budgets[i].statistics.allocationCount,
+                    .block_bytes = budgets[i].statistics.blockBytes,
+                    .allocation_bytes = budgets[i].statistics.allocationBytes,
+                    .usage = budgets[i].usage,
+                    .budget = budgets[i].budget,
+            });
+        }
+        return result;
+    }
+
+    std::string window::memory_stats(bool detailed) const {
+        char* stats = nullptr;
+        vmaBuildStatsString(this->allocator, &stats, detailed ? VK_TRUE : VK_FALSE);
+        std::string result{stats != nullptr ? stats : ""};
+        vmaFreeStatsString(this->allocator, stats);
+        return result;
+    }
+
     std::pair<vk::Buffer, VmaAllocation VGI_RESTRICT> window::create_buffer(
             const vk::BufferCreateInfo& create_info,
             const VmaAllocationCreateInfo& alloc_create_info, VmaAllocationInfo* alloc_info) const {
+        // Buffers that can only be read by transfers are only ever used to stage uploads
+        const memory_category category = create_info.usage == vk::BufferUsageFlagBits::eTransferSrc
+                                                 ? memory_category::staging
+                                                 : memory_category::buffer;
+
         std::pair<VkBuffer, VmaAllocation> result;
         VGI_VMA_CHECK(vmaCreateBuffer(
                 this->allocator, reinterpret_cast<const VkBufferCreateInfo*>(&create_info),
                 &alloc_create_info, &result.first, &result.second, alloc_info));
+        this->track_allocation(result.second, category);
         return result;
     }
 
+    std::pair<const vk::Buffer*, VmaAllocation VGI_RESTRICT> window::create_relocatable_buffer(
+            const vk::BufferCreateInfo& create_info,
+            const VmaAllocationCreateInfo& alloc_create_info, VmaAllocationInfo* alloc_info) const {
+        auto [buffer, allocation] = this->create_buffer(create_info, alloc_create_info, alloc_info);
+        try {
+            return {&this->defrag_data.track(buffer, allocation, create_info), allocation};
+        } catch (...) {
+            this->destroy_buffer(buffer, allocation);
+            throw;
+        }
+    }
+
+    std::pair<vk::Image, VmaAllocation VGI_RESTRICT> window::create_image(
+            const vk::ImageCreateInfo& create_info,
+            const VmaAllocationCreateInfo& alloc_create_info, VmaAllocationInfo* alloc_info) const {
+        const memory_category category =
+                create_info.usage & (vk::ImageUsageFlagBits::eColorAttachment |
+                                     vk::ImageUsageFlagBits::eDepthStencilAttachment)
+                        ? memory_category::attachment
+                        : memory_category::texture;
+
+        std::pair<VkImage, VmaAllocation> result;
+        VGI_VMA_CHECK(vmaCreateImage(
+                this->allocator, reinterpret_cast<const VkImageCreateInfo*>(&create_info),
+                &alloc_create_info, &result.first, &result.second, alloc_info));
+        this->track_allocation(result.second, category);
+        return result;
+    }
+
+    void window::destroy_buffer(vk::Buffer buffer, VmaAllocation allocation) const noexcept {
+        this->untrack_allocation(allocation);
+        // Allocations referenced by a defragmentation pass are released once it is completed
+        if (this->defrag_data.release(buffer, allocation)) return;
+        vmaDestroyBuffer(this->allocator, buffer, allocation);
+    }
+
+    void window::destroy_image(vk::Image image, VmaAllocation allocation) const noexcept {
+        this->untrack_allocation(allocation);
+        if (this->defrag_data.release(image, allocation)) return;
+        vmaDestroyImage(this->allocator, image, allocation);
+    }
+
+    void window::track_allocation(VmaAllocation allocation,
+                                  memory_category category) const noexcept {
+        // The category is offset by one, so that allocations without user data are never tracked
+        vmaSetAllocationUserData(
+                this->allocator, allocation,
+                reinterpret_cast<void*>(static_cast<uintptr_t>(category) + 1));
+
+        VmaAllocationInfo info;
+        vmaGetAllocationInfo(this->allocator, allocation, &info);
+        vgi::memory_usage& usage = this->memory_usages[static_cast<size_t>(category)];
+        usage.allocations += 1;
+        usage.bytes += info.size;
+    }
+
+    void window::untrack_allocation(VmaAllocation allocation) const noexcept {
+        if (allocation == VK_NULL_HANDLE) return;
+
+        VmaAllocationInfo info;
+        vmaGetAllocationInfo(this->allocator, allocation, &info);
+        const uintptr_t tag = reinterpret_cast<uintptr_t>(info.pUserData);
+        if (tag == 0 || tag > MEMORY_CATEGORY_COUNT) return;
+
+        vgi::memory_usage& usage = this->memory_usages[tag - 1];
+        VGI_ASSERT(usage.allocations > 0 && usage.bytes >= info.size);
+        usage.allocations -= 1;
+        usage.bytes -= info.size;
+    }
+
     void window::close() && noexcept {
         if (this->logical) {
             try {
@@ -635,7 +834,7 @@ namespace vgi {
                 this->logical.destroyFence(flying.fence);
             }
             for (depth_texture& depth: this->swapchain_depths) {
-                std::move(depth).destroy(this->logical, this->allocator);
+                std::move(depth).destroy(*this);
             }
             for (vk::ImageView view: this->swapchain_views) {
                 this->logical.destroyImageView(view);
@@ -650,11 +849,15 @@ namespace vgi {
                 this->logical.destroySemaphore(this->present_complete[i]);
             }
 
+            std::move(this->defrag_data).destroy(*this);
+            std::move(this->geometry_data).destroy(*this);
+            std::move(this->staging_data).destroy(*this);
             if (this->cmdpool) this->logical.destroyCommandPool(this->cmdpool);
             if (this->swapchain) this->logical.destroySwapchainKHR(this->swapchain);
+            std::move(this->transient_data).destroy(*this);
             if (this->allocator) vmaDestroyAllocator(this->allocator);
 
-            std::exchange(this->logical, nullptr).destroy();
+            std::exchange(this->logical, nullptr).destroy(host_callbacks(alloc_scope::vulkan));
         }
 
         if (this->surface) {
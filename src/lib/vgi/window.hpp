@@ -2,15 +2,24 @@
 #pragma once
 
 #include <SDL3/SDL.h>
+#include <array>
 #include <cstdint>
 #include <deque>
 #include <memory>
 #include <optional>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "arena.hpp"
+#include "buffer/geometry.hpp"
+#include "buffer/staging.hpp"
+#include "buffer/transient.hpp"
+#include "budget.hpp"
 #include "collections/slab.hpp"
+#include "defrag.hpp"
 #include "device.hpp"
 #include "forward.hpp"
 #include "resource.hpp"
@@ -94,6 +103,15 @@ namespace vgi {
     struct window : public system {
         /// @brief Maximum number of frames that can waiting to be presented at the same time.
         constexpr static inline const uint32_t MAX_FRAMES_IN_FLIGHT = VGI_MAX_FRAMES_IN_FLIGHT;
+        /// @brief Number of bytes of transient memory that can be allocated for each frame.
+        constexpr static inline const vk::DeviceSize TRANSIENT_BUFFER_SIZE =
+                VGI_TRANSIENT_BUFFER_SIZE;
+        /// @brief Number of bytes of host memory used to stream uploads to the device.
+        constexpr static inline const vk::DeviceSize STAGING_BUFFER_SIZE = VGI_STAGING_BUFFER_SIZE;
+        /// @brief Number of bytes of vertex memory of every page of the geometry pool.
+        constexpr static inline const vk::DeviceSize GEOMETRY_PAGE_SIZE = VGI_GEOMETRY_PAGE_SIZE;
+        /// @brief Number of bytes of host memory initially reserved by each frame arena.
+        constexpr static inline const size_t FRAME_ARENA_SIZE = VGI_FRAME_ARENA_SIZE;
 
         /// @brief Create a window with the specified properties
         /// @param device Device to be used for hardware acceleration
@@ -117,7 +135,11 @@ namespace vgi {
             physical(other.physical), logical(std::move(other.logical)),
             allocator(std::move(other.allocator)), queue(std::move(other.queue)),
             cmdpool(std::move(other.cmdpool)), swapchain(std::move(other.swapchain)),
-            no_vsync_mode(other.no_vsync_mode), has_hdr10(other.has_hdr10) {}
+            transient_data(std::move(other.transient_data)),
+            staging_data(std::move(other.staging_data)), arenas(std::move(other.arenas)),
+            geometry_data(std::move(other.geometry_data)), no_vsync_mode(other.no_vsync_mode),
+            has_hdr10(other.has_hdr10), memory_budget_ext(other.memory_budget_ext),
+            memory_usages(other.memory_usages), defrag_data(std::move(other.defrag_data)) {}
 
         /// @brief Move assignment for `window`
         /// @param other Object to move
@@ -141,6 +163,69 @@ namespace vgi {
         inline vk::Extent2D draw_size() const noexcept { return this->swapchain_info.imageExtent; }
         /// @brief Format of the depth textures
         inline vk::Format depth_texture_format() const noexcept { return this->depth_format; }
+        /// @brief Depth attachment of the frame being recorded
+        /// @details Only valid from `layer::on_render`. It's in `eShaderReadOnlyOptimal` layout
+        /// while rendering is suspended, and in `eDepthAttachmentOptimal` layout otherwise.
+        inline vk::ImageView depth_view() const noexcept {
+            return this->swapchain_depths[this->current_image].view;
+        }
+        /// @brief Per-frame linear allocator for transient data (i.e. uniforms, vertices or indices
+        /// that are only used for a single frame).
+        /// @details The regions allocated for a frame are released automatically once the device
+        /// has finished processing that frame, and flushed before the frame is submitted.
+        inline vgi::transient_buffer& transient() noexcept { return this->transient_data; }
+        /// @brief Per-frame linear allocator for transient data (i.e. uniforms, vertices or indices
+        /// that are only used for a single frame).
+        inline const vgi::transient_buffer& transient() const noexcept {
+            return this->transient_data;
+        }
+        /// @brief Persistent ring used to stream uploads to the device.
+        /// @details Any batch still pending when a frame is submitted is executed right before it,
+        /// within the same queue submission, and completed batches are reclaimed at the start of
+        /// every frame.
+        inline vgi::staging_ring& staging() noexcept { return this->staging_data; }
+        /// @brief Persistent ring used to stream uploads to the device.
+        inline const vgi::staging_ring& staging() const noexcept { return this->staging_data; }
+        /// @brief Shared storage for the vertices and indices of meshes, so that many of them can
+        /// be drawn with a single bind.
+        /// @details Ranges released to the pool are reused once the device has finished with every
+        /// frame that may reference them.
+        inline vgi::geometry_pool& geometry() noexcept { return this->geometry_data; }
+        /// @brief Shared storage for the vertices and indices of meshes
+        inline const vgi::geometry_pool& geometry() const noexcept { return this->geometry_data; }
+        /// @brief Host arena of the current frame, for scratch data that only lives until the end
+        /// of the frame (i.e. draw lists, culled node lists or joint palettes).
+        /// @details Every frame in flight has its own arena, which is reset alongside its transient
+        /// data once the device has finished with that frame.
+        inline vgi::frame_arena& arena() noexcept { return this->arenas[this->current_frame]; }
+
+        /// @brief Whether the device reports its own memory budget (`VK_EXT_memory_budget`).
+        /// @details Otherwise, budgets and process-wide usage are estimated from the heap sizes and
+        /// the memory allocated through this window.
+        inline bool has_memory_budget() const noexcept { return this->memory_budget_ext; }
+        /// @brief Current usage and budget of every memory heap of the device
+        std::vector<heap_budget> heap_budgets() const;
+        /// @brief Device memory currently allocated through the window for a category
+        /// @param category Memory category
+        inline const vgi::memory_usage& allocated(memory_category category) const noexcept {
+            VGI_ASSERT(static_cast<size_t>(category) < MEMORY_CATEGORY_COUNT);
+            return this->memory_usages[static_cast<size_t>(category)];
+        }
+        /// @brief Detailed statistics of the window's allocator, in JSON format
+        /// @param detailed Whether to include a map of every memory block, with the name of each
+        /// allocation (as set by `vmaSetAllocationName`). Useful to spot leaks and fragmentation.
+        std::string memory_stats(bool detailed = true) const;
+        /// @brief Starts compacting device memory incrementally, with one pass every few frames
+        /// @details Does nothing if a defragmentation is already in progress. Only buffers created
+        /// with `create_relocatable_buffer` are ever moved.
+        /// @param budget Limits of every pass
+        inline void defragment(const defrag_budget& budget = {}) {
+            this->defrag_data.start(*this, budget);
+        }
+        /// @brief Stops the defragmentation in progress, once its current pass is completed
+        inline void stop_defragmentation() noexcept { this->defrag_data.stop(); }
+        /// @brief Whether a defragmentation is in progress
+        inline bool defragmenting() const noexcept { return this->defrag_data.running(); }
 
         /// @brief Checks whether the windows has the provided identifier
         /// @details This is necessary to map window events to a specific `window` object.
@@ -198,6 +283,68 @@ namespace vgi {
                 const VmaAllocationCreateInfo& alloc_create_info,
                 VmaAllocationInfo* alloc_info = nullptr) const;
 
+        /// @brief Creates a new buffer whose memory may be moved by defragmentation
+        /// @details The `vk::Buffer` is owned by the window, which replaces it whenever its memory
+        /// is moved, so it must always be read through the returned handle right before being
+        /// used, and never cached across frames.
+        /// @param create_info Creation information for the `vk::Buffer`. Must not have a `pNext`
+        /// chain.
+        /// @param alloc_create_info Creation information fo the `VmaAllocation`
+        /// @param alloc_info Information about allocated memory. It can be later fetched using
+        /// function `vmaGetAllocationInfo`.
+        /// @return Handle to the current `vk::Buffer`, valid until the buffer is destroyed, and
+        /// it's associated `VmaAllocation`
+        std::pair<const vk::Buffer*, VmaAllocation VGI_RESTRICT> create_relocatable_buffer(
+                const vk::BufferCreateInfo& create_info,
+                const VmaAllocationCreateInfo& alloc_create_info,
+                VmaAllocationInfo* alloc_info = nullptr) const;
+
+        /// @brief Allocation information for buffers written by the host and read by the device
+        /// (i.e. vertex or index buffers)
+        /// @details Host-visible device memory (integrated GPUs, resizable BAR) is preferred and
+        /// persistently mapped, so that uploads may skip the staging ring. Otherwise, the buffer
+        /// is placed on device memory and uploaded through the ring.
+        constexpr static inline const VmaAllocationCreateInfo UPLOAD_ALLOCATION_INFO{
+                .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                         VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT |
+                         VMA_ALLOCATION_CREATE_MAPPED_BIT,
+                .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+        };
+
+        /// @brief Creates a new image
+        /// @param create_info Creation information for the `vk::Image`
+        /// @param alloc_create_info Creation information fo the `VmaAllocation`
+        /// @param alloc_info Information about allocated memory. It can be later fetched using
+        /// function `vmaGetAllocationInfo`.
+        /// @return The created `vk::Image` and it's associated `VmaAllocation`
+        std::pair<vk::Image, VmaAllocation VGI_RESTRICT> create_image(
+                const vk::ImageCreateInfo& create_info,
+                const VmaAllocationCreateInfo& alloc_create_info,
+                VmaAllocationInfo* alloc_info = nullptr) const;
+
+        /// @brief Destroys a buffer created with `create_buffer`
+        /// @param buffer Buffer to be destroyed
+        /// @param allocation Allocation of the buffer
+        void destroy_buffer(vk::Buffer buffer, VmaAllocation allocation) const noexcept;
+
+        /// @brief Destroys an image created with `create_image`
+        /// @param image Image to be destroyed
+        /// @param allocation Allocation of the image
+        void destroy_image(vk::Image image, VmaAllocation allocation) const noexcept;
+
+        /// @brief Ends the rendering of the current frame, so that compute passes that read its
+        /// depth (i.e. `vgi::depth_pyramid`) can be recorded from `layer::on_render`
+        /// @details The depth attachment is transitioned to `eShaderReadOnlyOptimal`, and its
+        /// writes made visible to compute shaders. Rendering must be resumed with
+        /// `resume_rendering` before `layer::on_render` returns.
+        /// @param cmdbuf Command buffer of the current frame
+        void suspend_rendering(vk::CommandBuffer cmdbuf) const noexcept;
+
+        /// @brief Resumes the rendering of the current frame after `suspend_rendering`, keeping
+        /// the contents of its attachments
+        /// @param cmdbuf Command buffer of the current frame
+        void resume_rendering(vk::CommandBuffer cmdbuf) const noexcept;
+
         /// @brief Closes the window, releasing all it's resources.
         void close() && noexcept;
 
@@ -214,11 +361,13 @@ namespace vgi {
             vk::ImageView view;
             VmaAllocation allocation;
 
-            depth_texture(vk::Device logical, VmaAllocator allocator, vk::Format format,
-                          uint32_t width, uint32_t height);
-            void destroy(vk::Device logical, VmaAllocator allocator) && noexcept;
+            depth_texture(const window& parent, vk::Format format, uint32_t width,
+                          uint32_t height);
+            void destroy(const window& parent) && noexcept;
         };
 
+        void begin_rendering(vk::CommandBuffer cmdbuf, vk::AttachmentLoadOp load_op) const noexcept;
+
         SDL_Window* handle;
         vk::SurfaceKHR surface;
         const vgi::device& physical;
@@ -238,15 +387,29 @@ namespace vgi {
         vk::Semaphore present_complete[MAX_FRAMES_IN_FLIGHT];
         unique_span<vk::Semaphore> render_complete;
         uint32_t current_frame = 0;
+        uint32_t current_image = 0;
+        vgi::transient_buffer transient_data;
+        vgi::staging_ring staging_data;
+        std::array<vgi::frame_arena, MAX_FRAMES_IN_FLIGHT> arenas;
+        vgi::geometry_pool geometry_data;
         collections::slab<std::unique_ptr<layer>> layers;
         std::optional<vk::PresentModeKHR> no_vsync_mode;
         bool has_hdr10;
         bool should_resize = false;
+        bool memory_budget_ext = false;
+        // Allocations are tagged with their category (through their user data), so that they may
+        // be accounted for when destroyed.
+        mutable std::array<vgi::memory_usage, MEMORY_CATEGORY_COUNT> memory_usages{};
+        // Relocatable buffers are created and destroyed through const references, like any other
+        mutable vgi::defragmenter defrag_data;
 
         void create_swapchain(uint32_t width, uint32_t height, bool vsync, bool hdr10);
         void create_swapchain(bool vsync, bool hdr10);
+        void track_allocation(VmaAllocation allocation, memory_category category) const noexcept;
+        void untrack_allocation(VmaAllocation allocation) const noexcept;
 
         friend struct command_buffer;
+        friend class staging_ring;
         friend struct frame;
     };
 }  // namespace vgi
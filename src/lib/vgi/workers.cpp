@@ -0,0 +1,91 @@
+#include "workers.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+
+namespace vgi {
+    struct worker_pool::shared_state {
+        std::mutex mutex;
+        // Signaled when a new loop starts
+        std::condition_variable_any wake;
+        // Signaled when the last worker of a loop is done with it
+        std::condition_variable idle;
+        void (*task)(void*, size_t) noexcept = nullptr;
+        void* context = nullptr;
+        size_t count = 0;
+        std::atomic<size_t> next = 0;
+        uint64_t generation = 0;
+        size_t busy = 0;
+
+        // Runs tasks until every index of the current loop has been claimed
+        void claim() noexcept {
+            for (size_t i = this->next.fetch_add(1, std::memory_order_relaxed); i < this->count;
+                 i = this->next.fetch_add(1, std::memory_order_relaxed)) {
+                this->task(this->context, i);
+            }
+        }
+
+        // Main loop of every worker, which sleeps until a new loop starts
+        void work(std::stop_token stop) noexcept {
+            uint64_t seen = 0;
+            std::unique_lock lock{this->mutex};
+            while (this->wake.wait(lock, stop, [&] { return this->generation != seen; })) {
+                seen = this->generation;
+                lock.unlock();
+                this->claim();
+                lock.lock();
+                if (--this->busy == 0) this->idle.notify_one();
+            }
+        }
+    };
+
+    worker_pool::worker_pool(size_t worker_count) : state(std::make_unique<shared_state>()) {
+        this->threads.reserve(worker_count);
+        for (size_t i = 0; i < worker_count; ++i) {
+            this->threads.emplace_back(
+                    [state = this->state.get()](std::stop_token stop) { state->work(stop); });
+        }
+    }
+
+    worker_pool::worker_pool(worker_pool&& other) noexcept :
+        state(std::move(other.state)), threads(std::move(other.threads)) {}
+
+    void worker_pool::run(size_t count, void (*task)(void*, size_t) noexcept, void* context) {
+        if (count == 0) return;
+        if (this->threads.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) task(context, i);
+            return;
+        }
+
+        shared_state& state = *this->state;
+        {
+            std::lock_guard lock{state.mutex};
+            state.task = task;
+            state.context = context;
+            state.count = count;
+            state.next.store(0, std::memory_order_relaxed);
+            state.busy = this->threads.size();
+            ++state.generation;
+        }
+        state.wake.notify_all();
+        state.claim();
+
+        // Every worker has to be done with this loop before the next one starts, since the
+        // ones that wake up late would otherwise claim indices of the wrong loop
+        std::unique_lock lock{state.mutex};
+        state.idle.wait(lock, [&] { return state.busy == 0; });
+    }
+
+    size_t worker_pool::default_size() noexcept {
+        const unsigned threads = std::thread::hardware_concurrency();
+        return threads > 1 ? threads - 1 : 0;
+    }
+
+    worker_pool::~worker_pool() noexcept {
+        // Workers are asked to stop and joined by the destructors of their threads
+        this->threads.clear();
+    }
+}  // namespace vgi
@@ -0,0 +1,84 @@
+/*! \file */
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <vgi/defs.hpp>
+
+namespace vgi {
+    /// @brief A pool of persistent worker threads, which run the tasks of a parallel loop
+    /// @details `run` hands out the indices of a loop to the workers and the calling thread,
+    /// which claim them one at a time until every index has been processed, and returns once
+    /// they have all finished. Threads are created once, alongside the pool, and sleep while
+    /// there's no work to do.
+    ///
+    /// @warning Tasks must not throw, and the pool must only be used from one thread at a time.
+    class worker_pool {
+    public:
+        /// @brief Creates a new pool, with a worker for every hardware thread other than the
+        /// calling one
+        worker_pool() : worker_pool(default_size()) {}
+
+        /// @brief Creates a new pool
+        /// @param worker_count Number of worker threads. With no workers, tasks are run by the
+        /// calling thread alone.
+        explicit worker_pool(size_t worker_count);
+
+        /// @brief Move constructor
+        /// @param other Object to be moved
+        worker_pool(worker_pool&& other) noexcept;
+
+        /// @brief Move assignment
+        /// @param other Object to be moved
+        worker_pool& operator=(worker_pool&& other) noexcept {
+            if (this == &other) [[unlikely]]
+                return *this;
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+            return *this;
+        }
+
+        /// @brief Number of threads that run tasks, including the calling thread
+        inline size_t size() const noexcept { return this->threads.size() + 1; }
+
+        /// @brief Runs `task(i)` for every `i` in `[0, count)`, and waits for them to finish
+        /// @details Indices are claimed in increasing order, but may run in any order and on
+        /// any thread.
+        /// @param count Number of tasks
+        /// @param task Function that runs a task, given its index
+        template<class F>
+            requires(std::invocable<F&, size_t>)
+        void run(size_t count, F&& task) {
+            using function = std::remove_reference_t<F>;
+            this->run(
+                    count,
+                    [](void* context, size_t index) noexcept {
+                        (*static_cast<function*>(context))(index);
+                    },
+                    const_cast<void*>(static_cast<const void*>(std::addressof(task))));
+        }
+
+        /// @brief Number of workers used by default
+        static size_t default_size() noexcept;
+
+        /// @brief Stops and joins every worker
+        ~worker_pool() noexcept;
+
+        worker_pool(const worker_pool&) = delete;
+        worker_pool& operator=(const worker_pool&) = delete;
+
+    private:
+        struct shared_state;
+
+        std::unique_ptr<shared_state> state;
+        // Destroyed before `state`, so that workers are joined while it's still alive
+        std::vector<std::jthread> threads;
+
+        void run(size_t count, void (*task)(void*, size_t) noexcept, void* context);
+    };
+}  // namespace vgi